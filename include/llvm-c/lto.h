@@ -27,7 +27,7 @@
  * @{
  */
 
-#define LTO_API_VERSION 4
+#define LTO_API_VERSION 5
 
 typedef enum {
     LTO_SYMBOL_ALIGNMENT_MASK              = 0x0000001F, /* log2 of alignment */
@@ -284,6 +284,21 @@ lto_codegen_compile(lto_code_gen_t cg, size_t* length);
 extern bool
 lto_codegen_compile_to_file(lto_code_gen_t cg, const char** name);
 
+/**
+ * Generates code for all added modules into num_partitions native object
+ * files, which together replace the single file that
+ * lto_codegen_compile_to_file() would produce.  The optimized module is split
+ * into partitions that are code generated in parallel, one per thread.  The
+ * split only depends on the added modules and num_partitions, so the output
+ * is the same from run to run.  The names of the files are written to names
+ * and their number to count; both are owned by the lto_code_gen_t and remain
+ * valid until lto_codegen_dispose() is called or code is generated again.
+ * Returns true on error (check lto_get_error_message() for details).
+ */
+extern bool
+lto_codegen_compile_to_files(lto_code_gen_t cg, unsigned num_partitions,
+                             const char* const** names, unsigned* count);
+
 
 /**
  * Sets options to help debug codegen bugs.
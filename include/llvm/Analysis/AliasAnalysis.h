@@ -37,6 +37,7 @@
 #ifndef LLVM_ANALYSIS_ALIASANALYSIS_H
 #define LLVM_ANALYSIS_ALIASANALYSIS_H
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/Support/CallSite.h"
 
@@ -182,6 +183,22 @@ public:
     return alias(V1, UnknownSize, V2, UnknownSize);
   }
 
+  /// alias - Compute the alias relation of every pair of locations in Locs.
+  /// Result receives Locs.size() * (Locs.size() - 1) / 2 entries, one for each
+  /// pair (i, j) with j < i, ordered (1, 0), (2, 0), (2, 1), (3, 0), ...
+  /// The queries are made between beginBatch and endBatch, so implementations
+  /// can share work between them.
+  void alias(ArrayRef<Location> Locs, SmallVectorImpl<AliasResult> &Result);
+
+  /// beginBatch - Tell the analysis that the program will not be modified
+  /// until the matching call to endBatch, so it may remember results and
+  /// intermediate values across queries. Batches do not nest.
+  virtual void beginBatch();
+
+  /// endBatch - End the batch started by beginBatch and drop anything that
+  /// was remembered during it.
+  virtual void endBatch();
+
   /// isNoAlias - A trivial helper function to check to see if the specified
   /// pointers are no-alias.
   bool isNoAlias(const Location &LocA, const Location &LocB) {
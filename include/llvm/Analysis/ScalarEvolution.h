@@ -23,6 +23,7 @@
 
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/FoldingSet.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/Operator.h"
@@ -359,9 +360,11 @@ namespace llvm {
 
     /// ValuesAtScopes - This map contains entries for all the expressions
     /// that we attempt to compute getSCEVAtScope information for, which can
-    /// be expensive in extreme cases.
-    DenseMap<const SCEV *,
-             std::map<const Loop *, const SCEV *> > ValuesAtScopes;
+    /// be expensive in extreme cases. Most expressions are only evaluated in
+    /// one or two scopes, so the scopes are kept in a small flat vector.
+    typedef SmallVector<std::pair<const Loop *, const SCEV *>, 2>
+      ValuesAtScopesEntry;
+    DenseMap<const SCEV *, ValuesAtScopesEntry> ValuesAtScopes;
 
     /// LoopDispositions - Memoized computeLoopDisposition results.
     DenseMap<const SCEV *,
@@ -885,6 +888,20 @@ namespace llvm {
     FoldingSet<SCEV> UniqueSCEVs;
     BumpPtrAllocator SCEVAllocator;
 
+    /// Cache counters for the current function, reported by -scev-stats.
+    unsigned NumSCEVLookups, NumSCEVHits;
+    unsigned NumScopeLookups, NumScopeHits;
+    unsigned NumBTCLookups, NumBTCHits, NumBTCForgotten;
+
+    /// printCacheStats - Print the -scev-stats record for the current
+    /// function.
+    void printCacheStats();
+
+    /// clearCaches - Drop every SCEV and cached result, but keep the current
+    /// function and its cache counters.  Used by releaseMemory and by
+    /// verifyAnalysis, which recomputes the results for the same function.
+    void clearCaches();
+
     /// FirstUnknown - The head of a linked list of all SCEVUnknown
     /// values that have been allocated. This is used by releaseMemory
     /// to locate them all and call their destructors.
@@ -114,6 +114,29 @@ public:
   /// \brief Retrieve the current position in the stream, in bits.
   uint64_t GetCurrentBitNo() const { return GetBufferOffset() * 8 + CurBit; }
 
+  /// \brief Append Words, the contents of another stream written at the
+  /// current abbrev width. Both the current position and the size of Words
+  /// must be a whole number of 32-bit words.
+  void EmitWords(StringRef Words) {
+    assert(CurBit == 0 && "Not 32-bit aligned");
+    assert((Words.size() & 3) == 0 && "Not a whole number of words");
+    Out.append(Words.begin(), Words.end());
+  }
+
+  /// \brief Backpatch a 32-bit field that starts at bit BitNo of the stream,
+  /// which need not be word aligned but must have been flushed to the output.
+  void BackpatchBits32(uint64_t BitNo, uint32_t NewValue) {
+    assert(BitNo + 32 <= GetBufferOffset() * 8 && "Field not flushed yet!");
+    for (unsigned i = 0; i != 32; ++i, ++BitNo) {
+      char &Byte = Out[BitNo / 8];
+      char Mask = char(1 << (BitNo & 7));
+      if (NewValue & (1U << i))
+        Byte |= Mask;
+      else
+        Byte &= ~Mask;
+    }
+  }
+
   //===--------------------------------------------------------------------===//
   // Basic Primitives for emitting bits to the stream.
   //===--------------------------------------------------------------------===//
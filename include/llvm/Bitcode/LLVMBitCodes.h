@@ -42,7 +42,9 @@ namespace bitc {
 
     TYPE_BLOCK_ID_NEW,
 
-    USELIST_BLOCK_ID
+    USELIST_BLOCK_ID,
+
+    FUNCTION_INDEX_BLOCK_ID
   };
 
 
@@ -71,7 +73,21 @@ namespace bitc {
     // MODULE_CODE_PURGEVALS: [numvals]
     MODULE_CODE_PURGEVALS   = 10,
 
-    MODULE_CODE_GCNAME      = 11   // GCNAME: [strchr x N]
+    MODULE_CODE_GCNAME      = 11,  // GCNAME: [strchr x N]
+
+    // FNINDEXOFFSET: [offset]
+    // The offset, in 32-bit words from the start of the module block body, of
+    // the FUNCTION_INDEX_BLOCK that follows the function bodies.
+    MODULE_CODE_FNINDEXOFFSET = 12
+  };
+
+  /// The FUNCTION_INDEX block has one entry for each function body in the
+  /// module, in the order of the bodies.
+  enum FunctionIndexCodes {
+    // ENTRY: [offset]
+    // The offset, in bits from the start of the module block body, of the
+    // FUNCTION_BLOCK.
+    FNINDEX_CODE_ENTRY = 1
   };
 
   /// PARAMATTR blocks have code for defining a parameter attribute set.
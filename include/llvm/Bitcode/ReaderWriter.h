@@ -60,8 +60,11 @@ namespace llvm {
 
   /// WriteBitcodeToFile - Write the specified module to the specified
   /// raw output stream.  For streams where it matters, the given stream
-  /// should be in "binary" mode.
-  void WriteBitcodeToFile(const Module *M, raw_ostream &Out);
+  /// should be in "binary" mode.  If NumThreads is greater than one and LLVM
+  /// is in multithreaded mode, the function bodies are encoded by that many
+  /// threads; the output is the same either way.
+  void WriteBitcodeToFile(const Module *M, raw_ostream &Out,
+                          unsigned NumThreads = 1);
 
   /// createBitcodeWriterPass - Create and return a pass that writes the module
   /// to the specified ostream.
@@ -61,6 +61,10 @@ namespace llvm {
     ///
     VNInfo::Allocator VNInfoAllocator;
 
+    /// ChunkAllocators - VNInfo pools for the intervals computed in parallel
+    /// by computeVirtRegs, one per chunk of virtual registers.
+    SmallVector<VNInfo::Allocator*, 8> ChunkAllocators;
+
     /// Live interval pointers for all the virtual registers.
     IndexedMap<LiveInterval*, VirtReg2IndexFunctor> VirtRegIntervals;
 
@@ -102,6 +106,11 @@ namespace llvm {
     // Calculate the spill weight to assign to a single instruction.
     static float getSpillWeight(bool isDef, bool isUse, BlockFrequency freq);
 
+    /// getNumThreads - Return the number of threads -live-interval-threads
+    /// allows for computing virtual register intervals.  More than one thread
+    /// is only used after llvm_start_multithreaded() has been called.
+    static unsigned getNumThreads();
+
     LiveInterval &getInterval(unsigned Reg) {
       LiveInterval *LI = VirtRegIntervals[Reg];
       assert(LI && "Interval does not exist for virtual register");
@@ -376,6 +385,13 @@ namespace llvm {
     /// Compute live intervals for all virtual registers.
     void computeVirtRegs();
 
+    /// Compute live intervals for the virtual registers in NumChunks chunks,
+    /// on up to NumThreads threads.
+    void computeVirtRegsInParallel(unsigned NumChunks, unsigned NumThreads);
+
+    /// Thread entry point for computeVirtRegsInParallel.
+    static void computeVirtRegChunk(void *Chunk);
+
     /// Compute RegMaskSlots and RegMaskBits.
     void computeRegMasks();
 
@@ -108,6 +108,11 @@ public:
     return DT->properlyDominates(A, B);
   }
 
+  /// updateDFSNumbers - Number the nodes in DFS order now.  Dominance queries
+  /// otherwise do it lazily, so calling this first makes them read-only until
+  /// the tree is next modified, and safe to make from several threads.
+  void updateDFSNumbers() { DT->updateDFSNumbers(); }
+
   /// findNearestCommonDominator - Find nearest common dominator basic block
   /// for basic block A and B. If there is no such block then return NULL.
   inline MachineBasicBlock *findNearestCommonDominator(MachineBasicBlock *A,
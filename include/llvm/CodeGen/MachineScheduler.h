@@ -319,6 +319,9 @@ public:
     return RegionCriticalPSets;
   }
 
+  virtual bool getRegionPressure(std::vector<unsigned> &Before,
+                                 std::vector<unsigned> &After) const;
+
   const SUnit *getNextClusterPred() const { return NextClusterPred; }
 
   const SUnit *getNextClusterSucc() const { return NextClusterSucc; }
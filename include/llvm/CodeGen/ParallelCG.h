@@ -0,0 +1,69 @@
+//===-- llvm/CodeGen/ParallelCG.h - Parallel code generation ----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This header declares functions that split a module into partitions and code
+// generate the partitions in parallel.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CODEGEN_PARALLELCG_H
+#define LLVM_CODEGEN_PARALLELCG_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/Target/TargetMachine.h"
+#include <string>
+#include <vector>
+
+namespace llvm {
+
+class Module;
+class raw_ostream;
+
+/// TargetMachineFactory - Create the TargetMachine used to code generate one
+/// partition.  This is called once per partition, possibly from several
+/// threads at the same time, so it must not modify any shared state.
+typedef TargetMachine *(*TargetMachineFactory)(void *Opaque);
+
+/// partitionModule - Assign each global value defined in \p M to one of
+/// \p NumPartitions partitions, balancing the number of instructions in each.
+/// Definitions that must be emitted together, such as an alias and its
+/// aliasee or a function and the users of its block addresses, are always
+/// placed in the same partition.  Local symbols may be placed apart from their
+/// users.  The assignment only depends on the contents and order of \p M, so
+/// it is the same from run to run.
+///
+/// On return, \p FnParts, \p GVParts and \p AliasParts hold the partition
+/// numbers of the functions, global variables and aliases of \p M, in module
+/// order.  Declarations are given the partition number \p NumPartitions.
+void partitionModule(const Module &M, unsigned NumPartitions,
+                     std::vector<unsigned> &FnParts,
+                     std::vector<unsigned> &GVParts,
+                     std::vector<unsigned> &AliasParts);
+
+/// splitCodeGen - Split \p M into OSs.size() partitions with partitionModule
+/// and code generate each one in its own LLVMContext, with a TargetMachine
+/// created by \p CreateTM, writing partition I to OSs[I].  Every partition
+/// sees the definitions of the other partitions as external declarations.
+/// Local definitions that are used from another partition are emitted with
+/// hidden visibility and a new name that is unique within \p M.
+///
+/// Partitions are compiled on up to \p NumThreads threads if LLVM is in
+/// multithreaded mode, and sequentially otherwise; either way the output does
+/// not depend on the thread schedule.  The partitions are not verified, so
+/// callers should verify \p M first.  \p M itself is not modified.
+///
+/// This returns true and fills in \p ErrMsg on failure.
+bool splitCodeGen(const Module &M, ArrayRef<raw_ostream *> OSs,
+                  unsigned NumThreads, TargetMachineFactory CreateTM,
+                  void *Opaque, TargetMachine::CodeGenFileType FileType,
+                  std::string &ErrMsg);
+
+} // end namespace llvm
+
+#endif
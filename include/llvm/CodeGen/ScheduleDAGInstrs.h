@@ -214,6 +214,14 @@ namespace llvm {
     /// the level of the whole MachineFunction. By default does nothing.
     virtual void finalizeSchedule() {}
 
+    /// getRegionPressure - Report the maximum pressure of each register
+    /// pressure set in the current region before and after scheduling.
+    /// Returns false if this scheduler does not track register pressure.
+    virtual bool getRegionPressure(std::vector<unsigned> &Before,
+                                   std::vector<unsigned> &After) const {
+      return false;
+    }
+
     virtual void dumpNode(const SUnit *SU) const;
 
     /// Return a label for a DAG node that points to an instruction.
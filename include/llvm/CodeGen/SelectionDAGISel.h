@@ -19,6 +19,8 @@
 #include "llvm/CodeGen/SelectionDAG.h"
 #include "llvm/IR/BasicBlock.h"
 #include "llvm/Pass.h"
+#include <map>
+#include <string>
 
 namespace llvm {
   class FastISel;
@@ -66,6 +68,8 @@ public:
 
   virtual bool runOnMachineFunction(MachineFunction &MF);
 
+  virtual bool doFinalization(Module &M);
+
   virtual void EmitFunctionEntryCode() {}
 
   /// PreprocessISelDAG - This hook allows targets to hack on the graph before
@@ -279,6 +283,18 @@ private:
   /// state machines that start with a OPC_SwitchOpcode node.
   std::vector<unsigned> OpcodeOffset;
 
+  /// FastISelMisses - For -fast-isel-report, the number of times FastISel
+  /// handed a block to SelectionDAG and the number of instructions it handed
+  /// over, keyed by the opcode of the instruction it missed and the reason.
+  std::map<std::pair<std::string, std::string>,
+           std::pair<unsigned, unsigned> > FastISelMisses;
+  /// NumFastISelSelected - For -fast-isel-report, the number of instructions
+  /// FastISel selected.
+  unsigned NumFastISelSelected;
+
+  void recordFastISelMiss(const Instruction *I, unsigned NumInstrs);
+  void printFastISelReport(raw_ostream &OS);
+
   void UpdateChainsAndGlue(SDNode *NodeToMatch, SDValue InputChain,
                            const SmallVectorImpl<SDNode*> &ChainNodesMatched,
                            SDValue InputGlue, const SmallVectorImpl<SDNode*> &F,
@@ -35,19 +35,30 @@ namespace llvm {
   /// SlotIndexes pass. It should not be used directly. See the
   /// SlotIndex & SlotIndexes classes for the public interface to this
   /// information.
+  ///
+  /// Each entry remembers the basic block it belongs to, so mapping an index
+  /// to its block is a single load. The entry at a block boundary belongs to
+  /// the block that starts there.
   class IndexListEntry : public ilist_node<IndexListEntry> {
     MachineInstr *mi;
+    MachineBasicBlock *mbb;
     unsigned index;
 
   public:
 
-    IndexListEntry(MachineInstr *mi, unsigned index) : mi(mi), index(index) {}
+    IndexListEntry(MachineInstr *mi, unsigned index, MachineBasicBlock *mbb)
+      : mi(mi), mbb(mbb), index(index) {}
 
     MachineInstr* getInstr() const { return mi; }
     void setInstr(MachineInstr *mi) {
       this->mi = mi;
     }
 
+    MachineBasicBlock* getMBB() const { return mbb; }
+    void setMBB(MachineBasicBlock *mbb) {
+      this->mbb = mbb;
+    }
+
     unsigned getIndex() const { return index; }
     void setIndex(unsigned index) {
       this->index = index;
@@ -349,13 +360,14 @@ namespace llvm {
     // IndexListEntry allocator.
     BumpPtrAllocator ileAllocator;
 
-    IndexListEntry* createEntry(MachineInstr *mi, unsigned index) {
+    IndexListEntry* createEntry(MachineInstr *mi, unsigned index,
+                                MachineBasicBlock *mbb) {
       IndexListEntry *entry =
         static_cast<IndexListEntry*>(
           ileAllocator.Allocate(sizeof(IndexListEntry),
           alignOf<IndexListEntry>()));
 
-      new (entry) IndexListEntry(mi, index);
+      new (entry) IndexListEntry(mi, index, mbb);
 
       return entry;
     }
@@ -363,6 +375,9 @@ namespace llvm {
     /// Renumber locally after inserting curItr.
     void renumberIndexes(IndexList::iterator curItr);
 
+    /// Time the common queries against the current numbering.
+    void runQueryBenchmark(unsigned Rounds) const;
+
   public:
     static char ID;
 
@@ -497,19 +512,11 @@ namespace llvm {
 
     /// Returns the basic block which the given index falls in.
     MachineBasicBlock* getMBBFromIndex(SlotIndex index) const {
-      if (MachineInstr *MI = getInstructionFromIndex(index))
-        return MI->getParent();
-      SmallVectorImpl<IdxMBBPair>::const_iterator I =
-        std::lower_bound(idx2MBBMap.begin(), idx2MBBMap.end(), index);
-      // Take the pair containing the index
-      SmallVectorImpl<IdxMBBPair>::const_iterator J =
-        ((I != idx2MBBMap.end() && I->first > index) ||
-         (I == idx2MBBMap.end() && idx2MBBMap.size()>0)) ? (I-1): I;
-
-      assert(J != idx2MBBMap.end() && J->first <= index &&
-             index < getMBBEndIdx(J->second) &&
+      MachineBasicBlock *MBB = index.listEntry()->getMBB();
+      assert(MBB && getMBBStartIdx(MBB) <= index &&
+             index < getMBBEndIdx(MBB) &&
              "index does not correspond to an MBB");
-      return J->second;
+      return MBB;
     }
 
     bool findLiveInMBBs(SlotIndex start, SlotIndex end,
@@ -588,7 +595,7 @@ namespace llvm {
 
       // Insert a new list entry for mi.
       IndexList::iterator newItr =
-        indexList.insert(nextItr, createEntry(mi, newNumber));
+        indexList.insert(nextItr, createEntry(mi, newNumber, mi->getParent()));
 
       // Renumber locally if we need to.
       if (dist == 0)
@@ -638,10 +645,11 @@ namespace llvm {
       IndexList::iterator newItr;
       if (nextMBB == mbb->getParent()->end()) {
         startEntry = &indexList.back();
-        endEntry = createEntry(0, 0);
+        startEntry->setMBB(mbb);
+        endEntry = createEntry(0, 0, 0);
         newItr = indexList.insertAfter(startEntry, endEntry);
       } else {
-        startEntry = createEntry(0, 0);
+        startEntry = createEntry(0, 0, mbb);
         endEntry = getMBBStartIdx(nextMBB).listEntry();
         newItr = indexList.insert(endEntry, startEntry);
       }
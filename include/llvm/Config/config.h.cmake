@@ -576,6 +576,9 @@
 /* Installation directory for documentation */
 #cmakedefine LLVM_DOCSDIR "${LLVM_DOCSDIR}"
 
+/* Define if Use objects are built without a pointer back into the use list */
+#cmakedefine01 LLVM_ENABLE_COMPACT_USE_LISTS
+
 /* Define if threads enabled */
 #cmakedefine01 LLVM_ENABLE_THREADS
 
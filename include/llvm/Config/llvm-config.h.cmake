@@ -34,6 +34,9 @@
 /* Define if threads enabled */
 #cmakedefine01 LLVM_ENABLE_THREADS
 
+/* Define if Use objects are built without a pointer back into the use list */
+#cmakedefine01 LLVM_ENABLE_COMPACT_USE_LISTS
+
 /* Installation directory for config files */
 #cmakedefine LLVM_ETCDIR "${LLVM_ETCDIR}"
 
@@ -129,6 +129,11 @@ public:
 
   virtual void dump(raw_ostream &OS, DIDumpType DumpType = DIDT_All) = 0;
 
+  /// setMemoryBudget - Limit the memory used by the debug information which
+  /// is parsed for address lookups and kept for later ones to about Bytes.
+  /// Zero means no limit, which is the default.
+  virtual void setMemoryBudget(uint64_t Bytes) {}
+
   virtual DILineInfo getLineInfoForAddress(uint64_t Address,
       DILineInfoSpecifier Specifier = DILineInfoSpecifier()) = 0;
   virtual DILineInfoTable getLineInfoForAddressRange(uint64_t Address,
@@ -0,0 +1,130 @@
+//===-- MCJITCompileService.h - Parallel MCJIT compilation ------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the MCJITCompileService class, which compiles many
+// independent modules with MCJIT on several threads at once.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_EXECUTIONENGINE_MCJITCOMPILESERVICE_H
+#define LLVM_EXECUTIONENGINE_MCJITCOMPILESERVICE_H
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/CodeGen.h"
+#include "llvm/Support/Compiler.h"
+#include "llvm/Support/Mutex.h"
+#include <string>
+#include <vector>
+
+namespace llvm {
+
+class ExecutionEngine;
+class Module;
+
+/// MCJITCompileService - Compiles modules with MCJIT on a group of threads.
+///
+/// Every module gets its own MCJIT ExecutionEngine, and thus its own
+/// TargetMachine, MCContext and SectionMemoryManager, so engines compiling on
+/// different threads share no state.  The one thing the service cannot
+/// duplicate is the LLVMContext a module was created in: modules that share an
+/// LLVMContext are always compiled one after the other on the same thread,
+/// while modules from different contexts are compiled in parallel.  Callers
+/// that want full parallelism should therefore build each module in an
+/// LLVMContext of its own, and must not touch a context while the service is
+/// compiling modules from it.
+///
+/// Compilation is requested in batches: addModule() queues a module and
+/// returns a ticket, and compilePending() compiles everything queued so far
+/// and resolves the tickets.  Threads are only used if LLVM is in
+/// multithreaded mode (see llvm_start_multithreaded()); otherwise the modules
+/// are compiled on the calling thread.
+///
+/// All methods but the destructor may be called from several threads at once.
+/// Calls to compilePending() are serialized: a call waits for the batch being
+/// compiled by another thread, then compiles whatever is still queued, so that
+/// every module queued before it was called is compiled when it returns.
+class MCJITCompileService {
+public:
+  typedef unsigned Ticket;
+
+  explicit MCJITCompileService(unsigned NumThreads,
+                               CodeGenOpt::Level OptLevel =
+                                   CodeGenOpt::Default);
+
+  /// The destructor frees every engine, together with its module and the
+  /// memory holding its code.
+  ~MCJITCompileService();
+
+  /// addModule - Queue M for compilation by the next compilePending() call,
+  /// and take ownership of it.  Once compiled, the address of the function
+  /// named FunctionName can be retrieved with getFunctionAddress().
+  Ticket addModule(Module *M, StringRef FunctionName);
+
+  /// compilePending - Compile and finalize all queued modules, and wait for
+  /// them to finish.
+  void compilePending();
+
+  /// isCompiled - Return true if the module of T has been compiled, whether
+  /// or not that succeeded.
+  bool isCompiled(Ticket T) const;
+
+  /// getFunctionAddress - Return the address of the requested function of T's
+  /// module, or null if it could not be compiled or is not compiled yet.
+  void *getFunctionAddress(Ticket T) const;
+
+  /// getErrorMessage - Return why T's module could not be compiled.
+  std::string getErrorMessage(Ticket T) const;
+
+  /// getExecutionEngine - Return the engine that owns T's module and code, or
+  /// null if the module is not compiled yet.
+  ExecutionEngine *getExecutionEngine(Ticket T) const;
+
+private:
+  /// Job - The state of one module.  Only the thread compiling it writes
+  /// to a job, and other threads only read a job once Compiled is set.
+  struct Job {
+    Module *M;
+    std::string FunctionName;
+    ExecutionEngine *EE;
+    void *Address;
+    std::string ErrMsg;
+    bool Compiled;
+  };
+
+  /// JobGroup - Jobs whose modules share an LLVMContext.
+  struct JobGroup {
+    std::vector<Job*> Jobs;
+    CodeGenOpt::Level OptLevel;
+  };
+
+  static void compileJob(Job &J, CodeGenOpt::Level OptLevel);
+  static void compileJobGroup(void *Group);
+
+  MCJITCompileService(const MCJITCompileService &) LLVM_DELETED_FUNCTION;
+  void operator=(const MCJITCompileService &) LLVM_DELETED_FUNCTION;
+
+  unsigned NumThreads;
+  CodeGenOpt::Level OptLevel;
+
+  /// Lock - Guards Jobs, FirstPending and the Compiled flag of every job.
+  mutable sys::Mutex Lock;
+  /// CompileLock - Held by the thread in compilePending(), so that modules
+  /// sharing a context are never compiled by two batches at once.
+  sys::Mutex CompileLock;
+
+  /// The jobs are allocated one by one so that they stay put while other
+  /// threads add jobs.
+  std::vector<Job*> Jobs;
+  /// The index of the first job not claimed by compilePending() yet.
+  unsigned FirstPending;
+};
+
+} // end namespace llvm
+
+#endif
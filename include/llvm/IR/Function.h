@@ -438,6 +438,15 @@ public:
   ///
   void dropAllReferences();
 
+  /// releaseBody - Delete the body of the function, like dropAllReferences,
+  /// when the function itself is about to be deleted as well.  This is faster
+  /// because uses between the values of the function are not unlinked one by
+  /// one, and because all of the local names, including those of the
+  /// arguments, are dropped at once.  No value of the body may be used outside
+  /// of the function, except for basic blocks used by blockaddress constants.
+  ///
+  void releaseBody();
+
   /// hasAddressTaken - returns true if there are any uses of this function
   /// other than direct calls or invokes to it, or blockaddress expressions.
   /// Optionally passes back an offending user for diagnostic purposes.
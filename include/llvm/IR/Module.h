@@ -572,6 +572,12 @@ public:
   /// is delete'd for real.  Note that no operations are valid on an object
   /// that has "dropped all references", except operator delete.
   void dropAllReferences();
+
+  /// Delete all of the functions, global variables, aliases and named metadata
+  /// of the module, leaving it empty.  This is a faster way to throw away a
+  /// module than deleting it directly, as the function bodies are released
+  /// with Function::releaseBody.  The module must be valid IR.
+  void dropAllAndRelease();
 /// @}
 };
 
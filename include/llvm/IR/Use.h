@@ -14,9 +14,10 @@
 // Pointer tagging is used to efficiently find the User corresponding
 // to a Use without having to store a User pointer in every Use. A
 // User is preceded in memory by all the Uses corresponding to its
-// operands, and the low bits of one of the fields (Prev) of the Use
-// class are used to encode offsets to be able to find that User given
-// a pointer to any Use. For details, see:
+// operands, and the low bits of one of the fields (Prev, or Next when
+// LLVM_ENABLE_COMPACT_USE_LISTS is set) of the Use class are used to encode
+// offsets to be able to find that User given a pointer to any Use. For
+// details, see:
 //
 //   http://www.llvm.org/docs/ProgrammersManual.html#UserLayout
 //
@@ -26,6 +27,7 @@
 #define LLVM_IR_USE_H
 
 #include "llvm/ADT/PointerIntPair.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/Support/CBindingWrapping.h"
 #include "llvm/Support/Compiler.h"
 #include "llvm-c/Core.h"
@@ -51,6 +53,18 @@ public:
   enum { NumLowBitsAvailable = 2 };
 };
 
+#if LLVM_ENABLE_COMPACT_USE_LISTS
+template<>
+class PointerLikeTypeTraits<Use*> {
+public:
+  static inline void *getAsVoidPointer(Use* P) { return P; }
+  static inline Use *getFromVoidPointer(void *P) {
+    return static_cast<Use*>(P);
+  }
+  enum { NumLowBitsAvailable = 2 };
+};
+#endif
+
 //===----------------------------------------------------------------------===//
 //                                  Use Class
 //===----------------------------------------------------------------------===//
@@ -82,7 +96,7 @@ private:
 
   /// Constructor
   Use(PrevPtrTag tag) : Val(0) {
-    Prev.setInt(tag);
+    setTag(tag);
   }
 
 public:
@@ -99,6 +113,11 @@ public:
 
   inline void set(Value *Val);
 
+  /// forget - Clear this use without unlinking it from the use list of its
+  /// value.  This is only safe when the value is about to be destroyed along
+  /// with the users of all of its uses, see Function::releaseBody.
+  void forget() { Val = 0; }
+
   Value *operator=(Value *RHS) {
     set(RHS);
     return RHS;
@@ -111,7 +130,11 @@ public:
         Value *operator->()       { return Val; }
   const Value *operator->() const { return Val; }
 
+#if LLVM_ENABLE_COMPACT_USE_LISTS
+  Use *getNext() const { return Next.getPointer(); }
+#else
   Use *getNext() const { return Next; }
+#endif
 
   
   /// initTags - initialize the waymarking tags on an array of Uses, so that
@@ -126,9 +149,26 @@ private:
   const Use* getImpliedUser() const;
   
   Value *Val;
+#if LLVM_ENABLE_COMPACT_USE_LISTS
+  // In the compact layout a Use has no pointer back to its predecessor in the
+  // use list, and the waymarking tag is kept in the bottom bits of Next
+  // instead.  This makes each Use a third smaller, at the price of having to
+  // walk the use list of the value to unlink a Use from it.
+  PointerIntPair<Use*, 2, PrevPtrTag> Next;
+
+  PrevPtrTag getTag() const { return Next.getInt(); }
+  void setTag(PrevPtrTag Tag) { Next.setInt(Tag); }
+  void addToList(Use **List) {
+    Next.setPointer(*List);
+    *List = this;
+  }
+  void removeFromList();
+#else
   Use *Next;
   PointerIntPair<Use**, 2, PrevPtrTag> Prev;
 
+  PrevPtrTag getTag() const { return Prev.getInt(); }
+  void setTag(PrevPtrTag Tag) { Prev.setInt(Tag); }
   void setPrev(Use **NewPrev) {
     Prev.setPointer(NewPrev);
   }
@@ -143,6 +183,7 @@ private:
     *StrippedPrev = Next;
     if (Next) Next->setPrev(StrippedPrev);
   }
+#endif
 
   friend class Value;
 };
@@ -110,6 +110,10 @@ public:
   /// All values hold a context through their type.
   LLVMContext &getContext() const;
 
+  /// forgetUses - Empty the use list of this value without unlinking the uses
+  /// on it, which must all have been cleared with Use::forget.
+  void forgetUses() { UseList = 0; }
+
   // All values can potentially be named.
   bool hasName() const { return Name != 0 && SubclassID != MDStringVal; }
   ValueName *getValueName() const { return Name; }
@@ -181,6 +185,13 @@ public:
   ///
   void addUse(Use &U) { U.addToList(&UseList); }
 
+#if LLVM_ENABLE_COMPACT_USE_LISTS
+  /// getUseListHead - This method should only be used by the Use class, to
+  /// unlink a Use from the use list of this value.
+  ///
+  Use **getUseListHead() { return &UseList; }
+#endif
+
   /// An enumeration for keeping track of the concrete subclass of Value that
   /// is actually instantiated. Values of this enumeration are kept in the 
   /// Value classes SubclassID field. They are used for concrete type
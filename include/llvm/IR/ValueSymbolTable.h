@@ -77,6 +77,11 @@ public:
   /// @brief The number of name/type pairs is returned.
   inline unsigned size() const { return unsigned(vmap.size()); }
 
+  /// This method removes and destroys all of the names in the table at once,
+  /// leaving the values that had them unnamed.
+  /// @brief Unname all of the values in the symbol table
+  void dropAllNames();
+
   /// This function can be used from the debugger to display the
   /// content of the symbol table while debugging.
   /// @brief Print out symbol table on stderr
@@ -910,13 +910,30 @@ private:
   bool fragmentNeedsRelaxation(const MCRelaxableFragment *IF,
                                const MCAsmLayout &Layout) const;
 
+  /// The fragments which may change size during relaxation, see
+  /// MCAssembler.cpp.
+  struct RelaxCandidate;
+  struct SectionRelaxState;
+  struct RelaxWorklist;
+
+  /// \brief Collect the fragments of every section which may need relaxing,
+  /// together with the fragments their sizes depend on.
+  void buildRelaxWorklist(RelaxWorklist &WL);
+
+  /// \brief Compute which fragments the size of the relaxable fragment of
+  /// \p C depends on.
+  void computeRelaxDependencies(RelaxCandidate &C,
+                                const SectionRelaxState &S) const;
+
   /// \brief Perform one layout iteration and return true if any offsets
   /// were adjusted.
-  bool layoutOnce(MCAsmLayout &Layout);
+  bool layoutOnce(MCAsmLayout &Layout, RelaxWorklist &WL);
 
   /// \brief Perform one layout iteration of the given section and return true
-  /// if any offsets were adjusted.
-  bool layoutSectionOnce(MCAsmLayout &Layout, MCSectionData &SD);
+  /// if any offsets were adjusted. Only the fragments which may be affected
+  /// by the size changes since they were last checked are revisited.
+  bool layoutSectionOnce(MCAsmLayout &Layout, RelaxWorklist &WL,
+                         SectionRelaxState &S);
 
   bool relaxInstruction(MCAsmLayout &Layout, MCRelaxableFragment &IF);
 
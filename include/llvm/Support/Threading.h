@@ -54,6 +54,26 @@ namespace llvm {
   /// the thread stack.
   void llvm_execute_on_thread(void (*UserFn)(void*), void *UserData,
                               unsigned RequestedStackSize = 0);
+
+  /// llvm_execute_on_threads - Execute the given \p UserFn once for each of
+  /// the \p NumItems pointers in \p UserData, using up to \p NumThreads
+  /// threads (including the calling one), and wait for all of the calls to
+  /// finish.
+  ///
+  /// Items are handed out in order to whichever thread becomes idle first, so
+  /// \p UserFn must not depend on which thread runs a given item.  If LLVM is
+  /// not in multithreaded mode (see llvm_start_multithreaded()) or threads
+  /// cannot be created, the items are processed on the calling thread.
+  ///
+  /// \param UserFn - The callback to execute.
+  /// \param UserData - The arguments to pass to the callback, one per call.
+  /// \param NumItems - The number of elements in \p UserData.
+  /// \param NumThreads - The maximum number of threads to use.
+  /// \param RequestedStackSize - If non-zero, a requested size (in bytes) for
+  /// the stack of each new thread.
+  void llvm_execute_on_threads(void (*UserFn)(void*), void **UserData,
+                               unsigned NumItems, unsigned NumThreads,
+                               unsigned RequestedStackSize = 0);
 }
 
 #endif
@@ -26,6 +26,7 @@ class User;
 class BasicBlock;
 class Function;
 class BranchInst;
+class SwitchInst;
 class Instruction;
 class DbgDeclareInst;
 class StoreInst;
@@ -144,6 +145,28 @@ bool SimplifyCFG(BasicBlock *BB, const TargetTransformInfo &TTI,
 /// destination.
 bool FoldBranchToCommonDest(BranchInst *BI);
 
+/// FoldTwoEntryPHINode - Given a block that starts with the specified two-entry
+/// PHI node, turn the "if" diamond or triangle that feeds it into selects,
+/// provided the instructions hoisted from each arm cost no more than
+/// Threshold.  Returns true if anything changed.
+bool FoldTwoEntryPHINode(PHINode *PN, const DataLayout *TD, unsigned Threshold);
+
+/// SpeculativelyExecuteBB - Hoist the single instruction of ThenBB, which is
+/// conditionally reached from BI and branches to BI's other successor, above
+/// BI and turn the PHI nodes of that successor into selects.  The instruction
+/// may cost at most Threshold.  BI is left in place, with ThenBB empty.
+bool SpeculativelyExecuteBB(BranchInst *BI, BasicBlock *ThenBB,
+                            unsigned Threshold);
+
+/// FoldSwitchToSelects - If every destination of SI is either a common merge
+/// block or an arm that is only reached from SI and branches straight to the
+/// merge block, hoist the arms above SI and turn the PHI nodes of the merge
+/// block into compares and selects.  Each arm may cost at most Threshold, and
+/// SI may have at most Threshold cases.  SI is replaced by a branch to the
+/// merge block and the arms are deleted.
+bool FoldSwitchToSelects(SwitchInst *SI, const DataLayout *TD,
+                         unsigned Threshold);
+
 /// DemoteRegToStack - This function takes a virtual register computed by an
 /// Instruction and replaces it with a slot in the stack frame, allocated via
 /// alloca.  This allows the CFG to be changed around without fear of
@@ -74,6 +74,27 @@ void AliasAnalysis::addEscapingUse(Use &U) {
   AA->addEscapingUse(U);
 }
 
+void AliasAnalysis::beginBatch() {
+  assert(AA && "AA didn't call InitializeAliasAnalysis in its run method!");
+  AA->beginBatch();
+}
+
+void AliasAnalysis::endBatch() {
+  assert(AA && "AA didn't call InitializeAliasAnalysis in its run method!");
+  AA->endBatch();
+}
+
+void AliasAnalysis::alias(ArrayRef<Location> Locs,
+                          SmallVectorImpl<AliasResult> &Result) {
+  Result.clear();
+  Result.reserve(Locs.size() * (Locs.size() - 1) / 2);
+  beginBatch();
+  for (unsigned i = 1, e = Locs.size(); i < e; ++i)
+    for (unsigned j = 0; j != i; ++j)
+      Result.push_back(alias(Locs[i], Locs[j]));
+  endBatch();
+}
+
 
 AliasAnalysis::ModRefResult
 AliasAnalysis::getModRefInfo(ImmutableCallSite CS,
@@ -185,18 +185,22 @@ bool AAEval::runOnFunction(Function &F) {
            << " pointers, " << CallSites.size() << " call sites\n";
 
   // iterate over the worklist, and run the full (n^2)/2 disambiguations
+  SmallVector<AliasAnalysis::Location, 64> Locs;
+  for (SetVector<Value *>::iterator I = Pointers.begin(), E = Pointers.end();
+       I != E; ++I) {
+    uint64_t Size = AliasAnalysis::UnknownSize;
+    Type *ElTy = cast<PointerType>((*I)->getType())->getElementType();
+    if (ElTy->isSized()) Size = AA.getTypeStoreSize(ElTy);
+    Locs.push_back(AliasAnalysis::Location(*I, Size));
+  }
+  SmallVector<AliasAnalysis::AliasResult, 64> Results;
+  AA.alias(Locs, Results);
+
+  unsigned ResultIdx = 0;
   for (SetVector<Value *>::iterator I1 = Pointers.begin(), E = Pointers.end();
        I1 != E; ++I1) {
-    uint64_t I1Size = AliasAnalysis::UnknownSize;
-    Type *I1ElTy = cast<PointerType>((*I1)->getType())->getElementType();
-    if (I1ElTy->isSized()) I1Size = AA.getTypeStoreSize(I1ElTy);
-
     for (SetVector<Value *>::iterator I2 = Pointers.begin(); I2 != I1; ++I2) {
-      uint64_t I2Size = AliasAnalysis::UnknownSize;
-      Type *I2ElTy =cast<PointerType>((*I2)->getType())->getElementType();
-      if (I2ElTy->isSized()) I2Size = AA.getTypeStoreSize(I2ElTy);
-
-      switch (AA.alias(*I1, I1Size, *I2, I2Size)) {
+      switch (Results[ResultIdx++]) {
       case AliasAnalysis::NoAlias:
         PrintResults("NoAlias", PrintNoAlias, *I1, *I2, F.getParent());
         ++NoAlias; break;
@@ -361,8 +361,12 @@ bool AliasSetTracker::add(Instruction *I) {
 }
 
 void AliasSetTracker::add(BasicBlock &BB) {
+  // Nothing changes the block while it is added, so the alias queries can be
+  // made as one batch.
+  AA.beginBatch();
   for (BasicBlock::iterator I = BB.begin(), E = BB.end(); I != E; ++I)
     add(I);
+  AA.endBatch();
 }
 
 void AliasSetTracker::add(const AliasSetTracker &AST) {
@@ -372,6 +376,7 @@ void AliasSetTracker::add(const AliasSetTracker &AST) {
   // Loop over all of the alias sets in AST, adding the pointers contained
   // therein into the current alias sets.  This can cause alias sets to be
   // merged together in the current AST.
+  AA.beginBatch();
   for (const_iterator I = AST.begin(), E = AST.end(); I != E; ++I) {
     if (I->Forward) continue;   // Ignore forwarding alias sets
     
@@ -390,6 +395,7 @@ void AliasSetTracker::add(const AliasSetTracker &AST) {
       if (AS.isVolatile()) NewAS.setVolatile();
     }
   }
+  AA.endBatch();
 }
 
 /// remove - Remove the specified (potentially non-empty) alias set from the
@@ -468,7 +468,7 @@ namespace {
   /// BasicAliasAnalysis - This is the primary alias analysis implementation.
   struct BasicAliasAnalysis : public ImmutablePass, public AliasAnalysis {
     static char ID; // Class identification, replacement for typeinfo
-    BasicAliasAnalysis() : ImmutablePass(ID) {
+    BasicAliasAnalysis() : ImmutablePass(ID), InBatch(false) {
       initializeBasicAliasAnalysisPass(*PassRegistry::getPassRegistry());
     }
 
@@ -486,6 +486,11 @@ namespace {
       assert(AliasCache.empty() && "AliasCache must be cleared after use!");
       assert(notDifferentParent(LocA.Ptr, LocB.Ptr) &&
              "BasicAliasAnalysis doesn't support interprocedural queries.");
+      if (InBatch) {
+        BatchCacheTy::iterator I = BatchCache.find(LocPair(LocA, LocB));
+        if (I != BatchCache.end())
+          return I->second;
+      }
       AliasResult Alias = aliasCheck(LocA.Ptr, LocA.Size, LocA.TBAATag,
                                      LocB.Ptr, LocB.Size, LocB.TBAATag);
       // AliasCache rarely has more than 1 or 2 elements, always use
@@ -493,9 +498,44 @@ namespace {
       // SmallDenseMap if it ever grows larger.
       // FIXME: This should really be shrink_to_inline_capacity_and_clear().
       AliasCache.shrink_and_clear();
+      // Only the final result of a top-level query can be remembered. The
+      // entries of AliasCache may depend on assumptions made while
+      // disambiguating PHIs.
+      if (InBatch)
+        BatchCache[LocPair(LocA, LocB)] = Alias;
       return Alias;
     }
 
+    virtual void beginBatch() {
+      assert(!InBatch && "Alias query batches do not nest!");
+      InBatch = true;
+      AliasAnalysis::beginBatch();
+    }
+
+    virtual void endBatch() {
+      assert(InBatch && "endBatch without beginBatch!");
+      clearBatchCaches();
+      InBatch = false;
+      AliasAnalysis::endBatch();
+    }
+
+    // The program must not change during a batch, but be safe if a client
+    // tells us that it did anyway.
+    virtual void deleteValue(Value *V) {
+      clearBatchCaches();
+      AliasAnalysis::deleteValue(V);
+    }
+
+    virtual void copyValue(Value *From, Value *To) {
+      clearBatchCaches();
+      AliasAnalysis::copyValue(From, To);
+    }
+
+    virtual void addEscapingUse(Use &U) {
+      clearBatchCaches();
+      AliasAnalysis::addEscapingUse(U);
+    }
+
     virtual ModRefResult getModRefInfo(ImmutableCallSite CS,
                                        const Location &Loc);
 
@@ -536,6 +576,34 @@ namespace {
     // Visited - Track instructions visited by pointsToConstantMemory.
     SmallPtrSet<const Value*, 16> Visited;
 
+    // InBatch - True between beginBatch and endBatch.
+    bool InBatch;
+
+    // BatchCache - The results of the top-level queries made during the
+    // current batch.
+    typedef DenseMap<LocPair, AliasResult> BatchCacheTy;
+    BatchCacheTy BatchCache;
+
+    // DecomposedGEP - The result of DecomposeGEPExpression for one pointer.
+    struct DecomposedGEP {
+      const Value *Base;
+      int64_t Offset;
+      SmallVector<VariableGEPIndex, 4> VarIndices;
+    };
+
+    // DecomposedGEPs - The pointers decomposed during the current batch.
+    DenseMap<const Value *, DecomposedGEP> DecomposedGEPs;
+
+    void clearBatchCaches() {
+      BatchCache.clear();
+      DecomposedGEPs.clear();
+    }
+
+    // decomposeGEP - Call DecomposeGEPExpression, or reuse its result for V
+    // when inside a batch.
+    const Value *decomposeGEP(const Value *V, int64_t &BaseOffs,
+                              SmallVectorImpl<VariableGEPIndex> &VarIndices);
+
     // aliasGEP - Provide a bunch of ad-hoc rules to disambiguate a GEP
     // instruction against another.
     AliasResult aliasGEP(const GEPOperator *V1, uint64_t V1Size,
@@ -872,6 +940,26 @@ static bool areVarIndicesEqual(SmallVector<VariableGEPIndex, 4> &Indices1,
   return true;
 }
 
+/// decomposeGEP - Return DecomposeGEPExpression(V), computing it only once per
+/// batch for each pointer.
+const Value *BasicAliasAnalysis::decomposeGEP(
+    const Value *V, int64_t &BaseOffs,
+    SmallVectorImpl<VariableGEPIndex> &VarIndices) {
+  if (!InBatch)
+    return DecomposeGEPExpression(V, BaseOffs, VarIndices, TD);
+
+  assert(VarIndices.empty() && "Decomposing into a non-empty index list!");
+  std::pair<DenseMap<const Value *, DecomposedGEP>::iterator, bool> Pair =
+    DecomposedGEPs.insert(std::make_pair(V, DecomposedGEP()));
+  DecomposedGEP &D = Pair.first->second;
+  if (Pair.second)
+    D.Base = DecomposeGEPExpression(V, D.Offset, D.VarIndices, TD);
+
+  BaseOffs = D.Offset;
+  VarIndices.append(D.VarIndices.begin(), D.VarIndices.end());
+  return D.Base;
+}
+
 /// aliasGEP - Provide a bunch of ad-hoc rules to disambiguate a GEP instruction
 /// against another pointer.  We know that V1 is a GEP, but we don't know
 /// anything about V2.  UnderlyingV1 is GetUnderlyingObject(GEP1, TD),
@@ -908,9 +996,9 @@ BasicAliasAnalysis::aliasGEP(const GEPOperator *GEP1, uint64_t V1Size,
         int64_t GEP2BaseOffset;
         SmallVector<VariableGEPIndex, 4> GEP2VariableIndices;
         const Value *GEP2BasePtr =
-          DecomposeGEPExpression(GEP2, GEP2BaseOffset, GEP2VariableIndices, TD);
+          decomposeGEP(GEP2, GEP2BaseOffset, GEP2VariableIndices);
         const Value *GEP1BasePtr =
-          DecomposeGEPExpression(GEP1, GEP1BaseOffset, GEP1VariableIndices, TD);
+          decomposeGEP(GEP1, GEP1BaseOffset, GEP1VariableIndices);
         // DecomposeGEPExpression and GetUnderlyingObject should return the
         // same result except when DecomposeGEPExpression has no DataLayout.
         if (GEP1BasePtr != UnderlyingV1 || GEP2BasePtr != UnderlyingV2) {
@@ -934,12 +1022,12 @@ BasicAliasAnalysis::aliasGEP(const GEPOperator *GEP1, uint64_t V1Size,
     // exactly, see if the computed offset from the common pointer tells us
     // about the relation of the resulting pointer.
     const Value *GEP1BasePtr =
-      DecomposeGEPExpression(GEP1, GEP1BaseOffset, GEP1VariableIndices, TD);
+      decomposeGEP(GEP1, GEP1BaseOffset, GEP1VariableIndices);
     
     int64_t GEP2BaseOffset;
     SmallVector<VariableGEPIndex, 4> GEP2VariableIndices;
     const Value *GEP2BasePtr =
-      DecomposeGEPExpression(GEP2, GEP2BaseOffset, GEP2VariableIndices, TD);
+      decomposeGEP(GEP2, GEP2BaseOffset, GEP2VariableIndices);
     
     // DecomposeGEPExpression and GetUnderlyingObject should return the
     // same result except when DecomposeGEPExpression has no DataLayout.
@@ -974,7 +1062,7 @@ BasicAliasAnalysis::aliasGEP(const GEPOperator *GEP1, uint64_t V1Size,
       return R;
 
     const Value *GEP1BasePtr =
-      DecomposeGEPExpression(GEP1, GEP1BaseOffset, GEP1VariableIndices, TD);
+      decomposeGEP(GEP1, GEP1BaseOffset, GEP1VariableIndices);
     
     // DecomposeGEPExpression and GetUnderlyingObject should return the
     // same result except when DecomposeGEPExpression has no DataLayout.
@@ -29,6 +29,7 @@
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/LLVMContext.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/PredIteratorCache.h"
 using namespace llvm;
@@ -45,10 +46,20 @@ STATISTIC(NumUncacheNonLocalPtr,
           "Number of uncached non-local ptr responses");
 STATISTIC(NumCacheCompleteNonLocalPtr,
           "Number of block queries that were completely cached");
+STATISTIC(NumNonLocalPtrCutOff,
+          "Number of non-local ptr searches cut off by the block limit");
 
 // Limit for the number of instructions to scan in a block.
 static const int BlockScanLimit = 100;
 
+// Limit for the number of blocks a single non-local pointer query may visit.
+// Without it, load PRE in functions with huge CFGs (e.g. the dispatch loop of
+// an interpreter) walks most of the function for every load.
+static cl::opt<unsigned>
+BlockNumberLimit("memdep-block-number-limit", cl::Hidden, cl::init(1000),
+                 cl::desc("The number of blocks a non-local pointer "
+                          "dependence query may visit (default = 1000)"));
+
 char MemoryDependenceAnalysis::ID = 0;
 
 // Register this pass...
@@ -1040,6 +1051,20 @@ getNonLocalPointerDepFromBB(const PHITransAddr &Pointer,
   while (!Worklist.empty()) {
     BasicBlock *BB = Worklist.pop_back_val();
 
+    // Visited is shared by all the recursive walks of this query, so it
+    // bounds the work done for the whole query. If it has grown too large,
+    // give up and let the caller treat the pointer as unknown.
+    if (Visited.size() > BlockNumberLimit) {
+      ++NumNonLocalPtrCutOff;
+      // Leave the cache sorted for any other walk that uses it.
+      if (Cache && NumSortedEntries != Cache->size())
+        SortNonLocalDepInfoCache(*Cache, NumSortedEntries);
+      // The cache doesn't hold all the results for the query. It can still
+      // answer questions about single blocks, but not take the fast path.
+      CacheInfo->Pair = BBSkipFirstBlockPair();
+      return true;
+    }
+
     // Skip the first block if we have it.
     if (!SkipFirstBlock) {
       // Analyze the dependency of *Pointer in FromBB.  See if we already have
@@ -66,6 +66,8 @@ namespace {
     virtual void deleteValue(Value *V) {}
     virtual void copyValue(Value *From, Value *To) {}
     virtual void addEscapingUse(Use &U) {}
+    virtual void beginBatch() {}
+    virtual void endBatch() {}
     
     /// getAdjustedAnalysisPointer - This method is used when a pass implements
     /// an analysis interface through multiple inheritance.  If needed, it
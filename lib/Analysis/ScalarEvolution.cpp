@@ -111,6 +111,11 @@ static cl::opt<bool>
 VerifySCEV("verify-scev",
            cl::desc("Verify ScalarEvolution's backedge taken counts (slow)"));
 
+static cl::opt<bool>
+ReportSCEVStats("scev-stats", cl::Hidden,
+                cl::desc("Print ScalarEvolution cache sizes and hit rates "
+                         "for each function"));
+
 INITIALIZE_PASS_BEGIN(ScalarEvolution, "scalar-evolution",
                 "Scalar Evolution Analysis", false, true)
 INITIALIZE_PASS_DEPENDENCY(LoopInfo)
@@ -2720,8 +2725,12 @@ const SCEV *ScalarEvolution::getCouldNotCompute() {
 const SCEV *ScalarEvolution::getSCEV(Value *V) {
   assert(isSCEVable(V->getType()) && "Value is not SCEVable!");
 
+  ++NumSCEVLookups;
   ValueExprMapType::const_iterator I = ValueExprMap.find_as(V);
-  if (I != ValueExprMap.end()) return I->second;
+  if (I != ValueExprMap.end()) {
+    ++NumSCEVHits;
+    return I->second;
+  }
   const SCEV *S = createSCEV(V);
 
   // The process of creating a SCEV for V may have caused other SCEVs
@@ -4053,10 +4062,13 @@ ScalarEvolution::getBackedgeTakenInfo(const Loop *L) {
   // update the value. The temporary CouldNotCompute value tells SCEV
   // code elsewhere that it shouldn't attempt to request a new
   // backedge-taken count, which could result in infinite recursion.
+  ++NumBTCLookups;
   std::pair<DenseMap<const Loop *, BackedgeTakenInfo>::iterator, bool> Pair =
     BackedgeTakenCounts.insert(std::make_pair(L, BackedgeTakenInfo()));
-  if (!Pair.second)
+  if (!Pair.second) {
+    ++NumBTCHits;
     return Pair.first->second;
+  }
 
   // ComputeBackedgeTakenCount may allocate memory for its result. Inserting it
   // into the BackedgeTakenCounts map transfers ownership. Otherwise, the result
@@ -4130,6 +4142,7 @@ void ScalarEvolution::forgetLoop(const Loop *L) {
   if (BTCPos != BackedgeTakenCounts.end()) {
     BTCPos->second.clear();
     BackedgeTakenCounts.erase(BTCPos);
+    ++NumBTCForgotten;
   }
 
   // Drop information about expressions based on loop-header PHIs.
@@ -5031,15 +5044,26 @@ const SCEV *ScalarEvolution::ComputeExitCountExhaustively(const Loop *L,
 /// original value V is returned.
 const SCEV *ScalarEvolution::getSCEVAtScope(const SCEV *V, const Loop *L) {
   // Check to see if we've folded this expression at this loop before.
-  std::map<const Loop *, const SCEV *> &Values = ValuesAtScopes[V];
-  std::pair<std::map<const Loop *, const SCEV *>::iterator, bool> Pair =
-    Values.insert(std::make_pair(L, static_cast<const SCEV *>(0)));
-  if (!Pair.second)
-    return Pair.first->second ? Pair.first->second : V;
+  ++NumScopeLookups;
+  ValuesAtScopesEntry &Values = ValuesAtScopes[V];
+  for (unsigned i = 0, e = Values.size(); i != e; ++i)
+    if (Values[i].first == L) {
+      ++NumScopeHits;
+      return Values[i].second ? Values[i].second : V;
+    }
+  // A null entry marks the computation as in progress.
+  Values.push_back(std::make_pair(L, static_cast<const SCEV *>(0)));
 
-  // Otherwise compute it.
+  // Otherwise compute it. This may add to ValuesAtScopes, so look the entry
+  // up again afterwards.
   const SCEV *C = computeSCEVAtScope(V, L);
-  ValuesAtScopes[V][L] = C;
+  ValuesAtScopesEntry &NewValues = ValuesAtScopes[V];
+  for (unsigned i = NewValues.size(); i != 0; --i)
+    if (NewValues[i - 1].first == L) {
+      NewValues[i - 1].second = C;
+      return C;
+    }
+  NewValues.push_back(std::make_pair(L, C));
   return C;
 }
 
@@ -6642,7 +6666,9 @@ ScalarEvolution::SCEVCallbackVH::SCEVCallbackVH(Value *V, ScalarEvolution *se)
 //===----------------------------------------------------------------------===//
 
 ScalarEvolution::ScalarEvolution()
-  : FunctionPass(ID), FirstUnknown(0) {
+  : FunctionPass(ID), F(0), NumSCEVLookups(0), NumSCEVHits(0),
+    NumScopeLookups(0), NumScopeHits(0), NumBTCLookups(0), NumBTCHits(0),
+    NumBTCForgotten(0), FirstUnknown(0) {
   initializeScalarEvolutionPass(*PassRegistry::getPassRegistry());
 }
 
@@ -6655,7 +6681,43 @@ bool ScalarEvolution::runOnFunction(Function &F) {
   return false;
 }
 
+/// printCacheStats - Print one comma separated record describing the caches
+/// for the current function:
+///
+///   scev-stats,<function>,<values>,<unique SCEVs>,<arena bytes>,
+///     <scope entries>,<backedge-taken counts>,<getSCEV lookups>,<hits>,
+///     <getSCEVAtScope lookups>,<hits>,<backedge-taken lookups>,<hits>,
+///     <backedge-taken counts forgotten>
+void ScalarEvolution::printCacheStats() {
+  unsigned NumScopeEntries = 0;
+  for (DenseMap<const SCEV *, ValuesAtScopesEntry>::const_iterator
+         I = ValuesAtScopes.begin(), E = ValuesAtScopes.end(); I != E; ++I)
+    NumScopeEntries += I->second.size();
+
+  errs() << "scev-stats," << F->getName() << ',' << ValueExprMap.size() << ','
+         << UniqueSCEVs.size() << ',' << SCEVAllocator.getTotalMemory() << ','
+         << NumScopeEntries << ',' << BackedgeTakenCounts.size() << ','
+         << NumSCEVLookups << ',' << NumSCEVHits << ','
+         << NumScopeLookups << ',' << NumScopeHits << ','
+         << NumBTCLookups << ',' << NumBTCHits << ','
+         << NumBTCForgotten << '\n';
+}
+
 void ScalarEvolution::releaseMemory() {
+  // releaseMemory can run again without a new runOnFunction, so only the first
+  // call for a function prints a record, and F must not be used after that.
+  if (ReportSCEVStats && F)
+    printCacheStats();
+  F = 0;
+
+  clearCaches();
+
+  NumSCEVLookups = NumSCEVHits = 0;
+  NumScopeLookups = NumScopeHits = 0;
+  NumBTCLookups = NumBTCHits = NumBTCForgotten = 0;
+}
+
+void ScalarEvolution::clearCaches() {
   // Iterate through all the SCEVUnknown instances and call their
   // destructors, so that they release their references to their values.
   for (SCEVUnknown *U = FirstUnknown; U; U = U->Next)
@@ -6997,6 +7059,7 @@ void ScalarEvolution::forgetMemoizedResults(const SCEV *S) {
     if (BEInfo.hasOperand(S, this)) {
       BEInfo.clear();
       BackedgeTakenCounts.erase(I++);
+      ++NumBTCForgotten;
     }
     else
       ++I;
@@ -7051,7 +7114,7 @@ void ScalarEvolution::verifyAnalysis() const {
 
   // Gather stringified backedge taken counts for all loops without using
   // SCEV's caches.
-  SE.releaseMemory();
+  SE.clearCaches();
   for (LoopInfo::reverse_iterator I = LI->rbegin(), E = LI->rend(); I != E; ++I)
     getLoopBackedgeTakenCounts(*I, BackedgeDumpsNew, SE);
 
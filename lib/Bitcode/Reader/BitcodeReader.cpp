@@ -1469,6 +1469,57 @@ bool BitcodeReader::RememberAndSkipFunctionBody() {
   return false;
 }
 
+/// ParseFunctionIndex - Read the positions of all of the function bodies from
+/// the function index, instead of finding them one block at a time. This
+/// leaves the stream after the index, which follows the last function body.
+bool BitcodeReader::ParseFunctionIndex() {
+  Stream.JumpToBit(FunctionIndexBit);
+  BitstreamEntry Entry = Stream.advance();
+  if (Entry.Kind != BitstreamEntry::SubBlock ||
+      Entry.ID != bitc::FUNCTION_INDEX_BLOCK_ID)
+    return Error("Malformed function index");
+
+  // The index holds the start of each FUNCTION_BLOCK, but the deferred
+  // function info records the position after its abbrev and block ids, which
+  // is where ParseFunctionBody expects to find the stream. FUNCTION_BLOCK_ID
+  // fits in a single VBR chunk.
+  uint64_t BlockHeaderBits = Stream.getAbbrevIDWidth() + bitc::BlockIDWidth;
+  if (Stream.EnterSubBlock(bitc::FUNCTION_INDEX_BLOCK_ID))
+    return Error("Malformed block record");
+
+  SmallVector<uint64_t, 1> Record;
+  while (1) {
+    Entry = Stream.advanceSkippingSubblocks();
+
+    switch (Entry.Kind) {
+    case BitstreamEntry::SubBlock: // Handled for us already.
+    case BitstreamEntry::Error:
+      return Error("Malformed function index");
+    case BitstreamEntry::EndBlock:
+      if (!FunctionsWithBodies.empty())
+        return Error("Function index is missing function bodies");
+      return false;
+    case BitstreamEntry::Record:
+      break;
+    }
+
+    Record.clear();
+    switch (Stream.readRecord(Entry.ID, Record)) {
+    default: break;  // Default behavior, ignore unknown content.
+    case bitc::FNINDEX_CODE_ENTRY: { // ENTRY: [offset]
+      if (Record.size() < 1)
+        return Error("Malformed function index entry");
+      if (FunctionsWithBodies.empty())
+        return Error("Insufficient function protos");
+      Function *Fn = FunctionsWithBodies.back();
+      FunctionsWithBodies.pop_back();
+      DeferredFunctionInfo[Fn] = ModuleBodyBit + Record[0] + BlockHeaderBits;
+      break;
+    }
+    }
+  }
+}
+
 bool BitcodeReader::GlobalCleanup() {
   // Patch the initializers for globals and aliases up.
   ResolveGlobalAndAliasInits();
@@ -1500,6 +1551,8 @@ bool BitcodeReader::ParseModule(bool Resume) {
     Stream.JumpToBit(NextUnreadBit);
   else if (Stream.EnterSubBlock(bitc::MODULE_BLOCK_ID))
     return Error("Malformed block record");
+  else
+    ModuleBodyBit = Stream.GetCurrentBitNo();
 
   SmallVector<uint64_t, 64> Record;
   std::vector<std::string> SectionTable;
@@ -1559,6 +1612,15 @@ bool BitcodeReader::ParseModule(bool Resume) {
           if (GlobalCleanup())
             return true;
           SeenFirstFunctionBody = true;
+
+          // With an index, find all of the function bodies at once instead
+          // of skipping over them one by one. Streamed bitcode does not
+          // jump ahead, as that would wait for the whole stream.
+          if (FunctionIndexBit && !LazyStreamer) {
+            if (ParseFunctionIndex())
+              return true;
+            break;
+          }
         }
 
         if (RememberAndSkipFunctionBody())
@@ -1649,6 +1711,14 @@ bool BitcodeReader::ParseModule(bool Resume) {
       GCTable.push_back(S);
       break;
     }
+    case bitc::MODULE_CODE_FNINDEXOFFSET: { // FNINDEXOFFSET: [offset]
+      if (Record.size() < 1)
+        return Error("Invalid MODULE_CODE_FNINDEXOFFSET record");
+      // An offset of 0 is a placeholder that was never filled in.
+      if (Record[0])
+        FunctionIndexBit = ModuleBodyBit + Record[0] * 32;
+      break;
+    }
     // GLOBALVAR: [pointer type, isconst, initid,
     //             linkage, alignment, section, visibility, threadlocal,
     //             unnamed_addr]
@@ -27,6 +27,7 @@
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/Program.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/raw_ostream.h"
 #include <cctype>
 #include <map>
@@ -38,6 +39,12 @@ EnablePreserveUseListOrdering("enable-bc-uselist-preserve",
                                        "use-list order preservation."),
                               cl::init(false), cl::Hidden);
 
+static cl::opt<bool>
+EnableFunctionIndex("bitcode-function-index",
+                    cl::desc("Emit an index of the function bodies, so that "
+                             "lazy readers need not scan for them."),
+                    cl::init(true), cl::Hidden);
+
 /// These are manifest constants used by the bitcode writer. They do not need to
 /// be kept in sync with the reader, but need to be consistent within this file.
 enum {
@@ -1859,15 +1866,163 @@ static void WriteModuleUseLists(const Module *M, ValueEnumerator &VE,
   Stream.ExitBlock();
 }
 
+/// WriteFunctionIndexPlaceholder - Emit a MODULE_CODE_FNINDEXOFFSET record
+/// whose offset is filled in by WriteFunctionIndex, and return the bit at which
+/// that offset starts.
+static uint64_t WriteFunctionIndexPlaceholder(BitstreamWriter &Stream) {
+  BitCodeAbbrev *Abbv = new BitCodeAbbrev();
+  Abbv->Add(BitCodeAbbrevOp(bitc::MODULE_CODE_FNINDEXOFFSET));
+  // The offset is not known yet, so it needs a fixed size field.
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 32));
+  unsigned Abbrev = Stream.EmitAbbrev(Abbv);
+
+  SmallVector<unsigned, 1> Vals;
+  Vals.push_back(0);
+  Stream.EmitRecord(bitc::MODULE_CODE_FNINDEXOFFSET, Vals, Abbrev);
+  return Stream.GetCurrentBitNo() - 32;
+}
+
+/// WriteFunctionIndex - Emit the offsets of the function bodies relative to
+/// ModuleStart, and point the placeholder record at them.
+static void WriteFunctionIndex(ArrayRef<uint64_t> Offsets,
+                               uint64_t ModuleStart, uint64_t Placeholder,
+                               BitstreamWriter &Stream) {
+  // Blocks end on a word boundary.
+  uint64_t IndexOffset = Stream.GetCurrentBitNo() - ModuleStart;
+  assert((IndexOffset & 31) == 0 && "Function index not 32-bit aligned!");
+  Stream.BackpatchBits32(Placeholder, IndexOffset / 32);
+
+  Stream.EnterSubblock(bitc::FUNCTION_INDEX_BLOCK_ID, 3);
+  SmallVector<uint64_t, 1> Vals;
+  for (unsigned i = 0, e = Offsets.size(); i != e; ++i) {
+    Vals.push_back(Offsets[i]);
+    Stream.EmitRecord(bitc::FNINDEX_CODE_ENTRY, Vals);
+    Vals.clear();
+  }
+  Stream.ExitBlock();
+}
+
+namespace {
+/// FunctionBlockJob - A run of consecutive function bodies that one thread
+/// writes to a buffer of its own.
+struct FunctionBlockJob {
+  const ValueEnumerator *ModuleVE;
+  std::vector<const Function*> Functions;
+  SmallVector<char, 0> Buffer;
+  /// The bit range of Buffer holding the function blocks, and the start of
+  /// each block relative to Begin.
+  uint64_t Begin, End;
+  std::vector<uint64_t> Offsets;
+};
+}
+
+static void WriteFunctionBlockJob(void *P) {
+  FunctionBlockJob &Job = *static_cast<FunctionBlockJob*>(P);
+  ValueEnumerator VE(*Job.ModuleVE);
+  BitstreamWriter Stream(Job.Buffer);
+
+  // Function blocks use the BLOCKINFO abbreviations and the abbrev width of
+  // the module block, so recreate both around them.  Only the function blocks
+  // themselves are kept.
+  Stream.EnterSubblock(bitc::MODULE_BLOCK_ID, 3);
+  WriteBlockInfo(VE, Stream);
+  Job.Begin = Stream.GetCurrentBitNo();
+  for (unsigned i = 0, e = Job.Functions.size(); i != e; ++i) {
+    Job.Offsets.push_back(Stream.GetCurrentBitNo() - Job.Begin);
+    WriteFunction(*Job.Functions[i], VE, Stream);
+  }
+  Job.End = Stream.GetCurrentBitNo();
+  Stream.ExitBlock();
+}
+
+/// WriteFunctionBodies - Write the function blocks of M, recording the start
+/// of each relative to ModuleStart in Offsets.  With more than one thread, the
+/// bodies are split into runs of similar size that are written to separate
+/// buffers in parallel and then copied into Stream, in module order.
+static void WriteFunctionBodies(const Module *M, ValueEnumerator &VE,
+                                BitstreamWriter &Stream, uint64_t ModuleStart,
+                                unsigned NumThreads,
+                                std::vector<uint64_t> &Offsets) {
+  std::vector<const Function*> Bodies;
+  uint64_t TotalSize = 0;
+  for (Module::const_iterator F = M->begin(), E = M->end(); F != E; ++F)
+    if (!F->isDeclaration()) {
+      Bodies.push_back(F);
+      TotalSize += F->size();
+    }
+
+  // The first body is written in place.  Blocks end on a word boundary, so
+  // the ones after it can then be copied in as whole words.
+  unsigned NextBody = 0;
+  bool Parallel = NumThreads > 1 && Bodies.size() > 1 &&
+                  llvm_is_multithreaded();
+  do {
+    if (NextBody == Bodies.size())
+      return;
+    Offsets.push_back(Stream.GetCurrentBitNo() - ModuleStart);
+    WriteFunction(*Bodies[NextBody++], VE, Stream);
+  } while (!Parallel);
+
+  // Cut the remaining bodies into one run per thread, with similar numbers of
+  // basic blocks.
+  unsigned NumJobs = std::min<size_t>(NumThreads, Bodies.size() - NextBody);
+  std::vector<FunctionBlockJob> Jobs(NumJobs);
+  uint64_t SizeLeft = TotalSize - Bodies[0]->size();
+  for (unsigned j = 0; j != NumJobs; ++j) {
+    FunctionBlockJob &Job = Jobs[j];
+    Job.ModuleVE = &VE;
+    uint64_t Target = SizeLeft / (NumJobs - j);
+    uint64_t Size = 0;
+    // Leave at least one body for each of the remaining jobs.
+    while (NextBody != Bodies.size() - (NumJobs - j - 1) &&
+           (Job.Functions.empty() || Size < Target)) {
+      Size += Bodies[NextBody]->size();
+      Job.Functions.push_back(Bodies[NextBody++]);
+    }
+    SizeLeft -= Size;
+  }
+
+  std::vector<void*> JobPtrs;
+  for (unsigned j = 0; j != NumJobs; ++j)
+    JobPtrs.push_back(&Jobs[j]);
+  llvm_execute_on_threads(WriteFunctionBlockJob, &JobPtrs[0], NumJobs,
+                          NumThreads);
+
+  for (unsigned j = 0; j != NumJobs; ++j) {
+    FunctionBlockJob &Job = Jobs[j];
+    uint64_t Start = Stream.GetCurrentBitNo() - ModuleStart;
+    for (unsigned i = 0, e = Job.Offsets.size(); i != e; ++i)
+      Offsets.push_back(Start + Job.Offsets[i]);
+    assert((Job.Begin & 31) == 0 && (Job.End & 31) == 0 &&
+           "Function blocks not 32-bit aligned!");
+    Stream.EmitWords(StringRef(Job.Buffer.data() + Job.Begin / 8,
+                               (Job.End - Job.Begin) / 8));
+  }
+}
+
 /// WriteModule - Emit the specified module to the bitstream.
-static void WriteModule(const Module *M, BitstreamWriter &Stream) {
+static void WriteModule(const Module *M, BitstreamWriter &Stream,
+                        unsigned NumThreads) {
   Stream.EnterSubblock(bitc::MODULE_BLOCK_ID, 3);
+  uint64_t ModuleStart = Stream.GetCurrentBitNo();
 
   SmallVector<unsigned, 1> Vals;
   unsigned CurVersion = 1;
   Vals.push_back(CurVersion);
   Stream.EmitRecord(bitc::MODULE_CODE_VERSION, Vals);
 
+  // Only modules with function bodies get an index.
+  bool HasFunctionIndex = false;
+  if (EnableFunctionIndex)
+    for (Module::const_iterator F = M->begin(), E = M->end(); F != E; ++F)
+      if (!F->isDeclaration()) {
+        HasFunctionIndex = true;
+        break;
+      }
+  uint64_t FunctionIndexPlaceholder = 0;
+  if (HasFunctionIndex)
+    FunctionIndexPlaceholder = WriteFunctionIndexPlaceholder(Stream);
+
   // Analyze the module, enumerating globals, functions, etc.
   ValueEnumerator VE(M);
 
@@ -1904,9 +2059,14 @@ static void WriteModule(const Module *M, BitstreamWriter &Stream) {
     WriteModuleUseLists(M, VE, Stream);
 
   // Emit function bodies.
-  for (Module::const_iterator F = M->begin(), E = M->end(); F != E; ++F)
-    if (!F->isDeclaration())
-      WriteFunction(*F, VE, Stream);
+  std::vector<uint64_t> FunctionOffsets;
+  WriteFunctionBodies(M, VE, Stream, ModuleStart, NumThreads, FunctionOffsets);
+
+  // The index must come right after the function bodies, as the reader
+  // resumes reading the module after it.
+  if (HasFunctionIndex)
+    WriteFunctionIndex(FunctionOffsets, ModuleStart, FunctionIndexPlaceholder,
+                       Stream);
 
   Stream.ExitBlock();
 }
@@ -1986,7 +2146,8 @@ static void EmitDarwinBCHeaderAndTrailer(SmallVectorImpl<char> &Buffer,
 
 /// WriteBitcodeToFile - Write the specified module to the specified output
 /// stream.
-void llvm::WriteBitcodeToFile(const Module *M, raw_ostream &Out) {
+void llvm::WriteBitcodeToFile(const Module *M, raw_ostream &Out,
+                              unsigned NumThreads) {
   SmallVector<char, 0> Buffer;
   Buffer.reserve(256*1024);
 
@@ -2009,7 +2170,7 @@ void llvm::WriteBitcodeToFile(const Module *M, raw_ostream &Out) {
     Stream.Emit(0xD, 4);
 
     // Emit the module.
-    WriteModule(M, Stream);
+    WriteModule(M, Stream, NumThreads);
   }
 
   if (TT.isOSDarwin())
@@ -13,12 +13,31 @@
 
 #define DEBUG_TYPE "regalloc"
 #include "InterferenceCache.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/CodeGen/LiveIntervalAnalysis.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetRegisterInfo.h"
+#include <algorithm>
 
 using namespace llvm;
 
+STATISTIC(NumCacheHits,      "Number of interference cache hits");
+STATISTIC(NumCacheMisses,    "Number of interference cache misses");
+STATISTIC(NumCacheEvictions, "Number of interference cache entries reused");
+
+static cl::opt<unsigned>
+CacheEntriesOpt("interference-cache-entries", cl::Hidden,
+  cl::desc("Number of interference cache entries, at most 255 "
+           "(0 = size from the register classes)"),
+  cl::init(0));
+
+static cl::opt<bool>
+PrintCacheStats("print-interference-cache-stats", cl::Hidden,
+  cl::desc("Print the interference cache hit rate of each function"));
+
 // Static member used for null interference cursors.
 InterferenceCache::BlockInterference InterferenceCache::Cursor::NoInterference;
 
@@ -31,29 +50,71 @@ void InterferenceCache::init(MachineFunction *mf,
   LIUArray = liuarray;
   TRI = tri;
   PhysRegEntries.assign(TRI->getNumRegs(), 0);
-  for (unsigned i = 0; i != CacheEntries; ++i)
+
+  // Allow a cursor for every register in the largest allocatable class, so
+  // that a split candidate can be kept for each of them.
+  unsigned NumEntries = CacheEntriesOpt;
+  if (!NumEntries) {
+    NumEntries = MinCacheEntries;
+    for (TargetRegisterInfo::regclass_iterator I = TRI->regclass_begin(),
+         E = TRI->regclass_end(); I != E; ++I)
+      if ((*I)->isAllocatable())
+        NumEntries = std::max(NumEntries, (*I)->getNumRegs());
+    NumEntries = std::min(NumEntries, unsigned(MaxCacheEntries));
+  }
+  // PhysRegEntries holds entry numbers in a byte.
+  NumEntries = std::min(NumEntries, 255u);
+  Entries.resize(NumEntries);
+  for (unsigned i = 0; i != NumEntries; ++i)
     Entries[i].clear(mf, indexes, lis);
+  ClockHand = 0;
+  NumHits = NumMisses = NumEvictions = 0;
+}
+
+void InterferenceCache::finish() {
+  NumCacheHits += NumHits;
+  NumCacheMisses += NumMisses;
+  NumCacheEvictions += NumEvictions;
+  if (!PrintCacheStats)
+    return;
+  unsigned Total = NumHits + NumMisses;
+  errs() << "Interference cache for " << MF->getName() << ": "
+         << Entries.size() << " entries, " << NumHits << " hits, "
+         << NumMisses << " misses, " << NumEvictions << " evictions";
+  if (Total)
+    errs() << ", " << (NumHits * 100ULL / Total) << "% hit rate";
+  errs() << '\n';
 }
 
 InterferenceCache::Entry *InterferenceCache::get(unsigned PhysReg) {
   unsigned E = PhysRegEntries[PhysReg];
-  if (E < CacheEntries && Entries[E].getPhysReg() == PhysReg) {
+  if (E < Entries.size() && Entries[E].getPhysReg() == PhysReg) {
+    ++NumHits;
+    Entries[E].setReferenced(true);
     if (!Entries[E].valid(LIUArray, TRI))
       Entries[E].revalidate(LIUArray, TRI);
     return &Entries[E];
   }
-  // No valid entry exists, pick the next round-robin entry.
-  E = RoundRobin;
-  if (++RoundRobin == CacheEntries)
-    RoundRobin = 0;
-  for (unsigned i = 0; i != CacheEntries; ++i) {
-    // Skip entries that are in use.
-    if (Entries[E].hasRefs()) {
-      if (++E == CacheEntries)
-        E = 0;
+  ++NumMisses;
+
+  // No valid entry exists. Sweep the clock hand over the entries until it
+  // finds one that has not been used since the last sweep. Entries held by
+  // cursors are skipped. Two rounds are enough to clear every referenced bit.
+  unsigned NumEntries = Entries.size();
+  for (unsigned i = 0; i != 2 * NumEntries; ++i) {
+    E = ClockHand;
+    if (++ClockHand == NumEntries)
+      ClockHand = 0;
+    if (Entries[E].hasRefs())
+      continue;
+    if (Entries[E].isReferenced()) {
+      Entries[E].setReferenced(false);
       continue;
     }
+    if (Entries[E].getPhysReg())
+      ++NumEvictions;
     Entries[E].reset(PhysReg, LIUArray, TRI, MF);
+    Entries[E].setReferenced(true);
     PhysRegEntries[PhysReg] = E;
     return &Entries[E];
   }
@@ -48,6 +48,10 @@ class InterferenceCache {
     /// RefCount - The total number of Cursor instances referring to this Entry.
     unsigned RefCount;
 
+    /// Referenced - Set when the entry is used, and cleared when the clock
+    /// hand passes over it.
+    bool Referenced;
+
     /// MF - The current function.
     MachineFunction *MF;
 
@@ -93,11 +97,14 @@ class InterferenceCache {
     void update(unsigned MBBNum);
 
   public:
-    Entry() : PhysReg(0), Tag(0), RefCount(0), Indexes(0), LIS(0) {}
+    Entry()
+      : PhysReg(0), Tag(0), RefCount(0), Referenced(false), Indexes(0),
+        LIS(0) {}
 
     void clear(MachineFunction *mf, SlotIndexes *indexes, LiveIntervals *lis) {
       assert(!hasRefs() && "Cannot clear cache entry with references");
       PhysReg = 0;
+      Referenced = false;
       MF = mf;
       Indexes = indexes;
       LIS = lis;
@@ -109,6 +116,9 @@ class InterferenceCache {
 
     bool hasRefs() const { return RefCount > 0; }
 
+    bool isReferenced() const { return Referenced; }
+    void setReferenced(bool R) { Referenced = R; }
+
     void revalidate(LiveIntervalUnion *LIUArray, const TargetRegisterInfo *TRI);
 
     /// valid - Return true if this is a valid entry for physReg.
@@ -129,33 +139,42 @@ class InterferenceCache {
   };
 
   // We don't keep a cache entry for every physical register, that would use too
-  // much memory. Instead, a fixed number of cache entries are used in a round-
-  // robin manner.
-  enum { CacheEntries = 32 };
+  // much memory. Instead, there are enough entries for the registers of the
+  // largest allocatable register class, within these bounds, and they are
+  // reused with the clock algorithm.
+  enum { MinCacheEntries = 32, MaxCacheEntries = 128 };
 
   // Point to an entry for each physreg. The entry pointed to may not be up to
   // date, and it may have been reused for a different physreg.
   SmallVector<unsigned char, 2> PhysRegEntries;
 
-  // Next round-robin entry to be picked.
-  unsigned RoundRobin;
+  // Next entry the clock hand considers for replacement.
+  unsigned ClockHand;
 
   // The actual cache entries.
-  Entry Entries[CacheEntries];
+  SmallVector<Entry, MinCacheEntries> Entries;
+
+  // Cache behavior in the current function.
+  unsigned NumHits, NumMisses, NumEvictions;
 
   // get - Get a valid entry for PhysReg.
   Entry *get(unsigned PhysReg);
 
 public:
-  InterferenceCache() : TRI(0), LIUArray(0), MF(0), RoundRobin(0) {}
+  InterferenceCache()
+    : TRI(0), LIUArray(0), MF(0), ClockHand(0), NumHits(0), NumMisses(0),
+      NumEvictions(0) {}
 
   /// init - Prepare cache for a new function.
   void init(MachineFunction*, LiveIntervalUnion*, SlotIndexes*, LiveIntervals*,
             const TargetRegisterInfo *);
 
+  /// finish - Report how the cache behaved in the current function.
+  void finish();
+
   /// getMaxCursors - Return the maximum number of concurrent cursors that can
   /// be supported.
-  unsigned getMaxCursors() const { return CacheEntries; }
+  unsigned getMaxCursors() const { return Entries.size(); }
 
   /// Cursor - The primary query interface for the block interference cache.
   class Cursor {
@@ -191,7 +210,7 @@ public:
     /// setPhysReg - Point this cursor to PhysReg's interference.
     void setPhysReg(InterferenceCache &Cache, unsigned PhysReg) {
       // Release reference before getting a new one. That guarantees we can
-      // actually have CacheEntries live cursors.
+      // actually have getMaxCursors() live cursors.
       setEntry(0);
       if (PhysReg)
         setEntry(Cache.get(PhysReg));
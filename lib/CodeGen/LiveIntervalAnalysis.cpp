@@ -32,6 +32,7 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetInstrInfo.h"
 #include "llvm/Target/TargetMachine.h"
@@ -52,6 +53,15 @@ INITIALIZE_PASS_DEPENDENCY(SlotIndexes)
 INITIALIZE_PASS_END(LiveIntervals, "liveintervals",
                 "Live Interval Analysis", false, false)
 
+static cl::opt<unsigned> LiveIntervalThreads(
+  "live-interval-threads", cl::Hidden, cl::init(1),
+  cl::desc("Compute virtual register live intervals on up to this many "
+           "threads"));
+
+/// MinVirtRegsPerChunk - Don't split the virtual registers into chunks smaller
+/// than this for parallel live interval computation.
+static const unsigned MinVirtRegsPerChunk = 16;
+
 #ifndef NDEBUG
 static cl::opt<bool> EnablePrecomputePhysRegs(
   "precompute-phys-liveness", cl::Hidden,
@@ -101,6 +111,7 @@ void LiveIntervals::releaseMemory() {
 
   // Release VNInfo memory regions, VNInfo objects don't need to be dtor'd.
   VNInfoAllocator.Reset();
+  DeleteContainerPointers(ChunkAllocators);
 }
 
 /// runOnMachineFunction - Register allocate the whole function
@@ -185,8 +196,22 @@ void LiveIntervals::computeVirtRegInterval(LiveInterval *LI) {
   LRCalc->extendToUses(LI);
 }
 
+unsigned LiveIntervals::getNumThreads() {
+  return LiveIntervalThreads;
+}
+
 void LiveIntervals::computeVirtRegs() {
-  for (unsigned i = 0, e = MRI->getNumVirtRegs(); i != e; ++i) {
+  unsigned NumVirtRegs = MRI->getNumVirtRegs();
+  if (LiveIntervalThreads > 1) {
+    unsigned NumChunks = std::min(LiveIntervalThreads * 4,
+                                  NumVirtRegs / MinVirtRegsPerChunk);
+    if (NumChunks > 1) {
+      computeVirtRegsInParallel(NumChunks, LiveIntervalThreads);
+      return;
+    }
+  }
+
+  for (unsigned i = 0; i != NumVirtRegs; ++i) {
     unsigned Reg = TargetRegisterInfo::index2VirtReg(i);
     if (MRI->reg_nodbg_empty(Reg))
       continue;
@@ -196,6 +221,60 @@ void LiveIntervals::computeVirtRegs() {
   }
 }
 
+namespace {
+/// VirtRegChunk - A range of virtual register indices whose live intervals are
+/// computed together on one thread, with their own LiveRangeCalc and VNInfo
+/// pool.
+struct VirtRegChunk {
+  LiveIntervals *LIS;
+  unsigned Begin, End;
+  LiveRangeCalc Calc;
+  VNInfo::Allocator *Alloc;
+};
+}
+
+/// computeVirtRegsInParallel - The live range of a virtual register only
+/// depends on its own operands, SlotIndexes and the dominator tree, so the
+/// virtual registers are split into chunks and computed independently.  The
+/// results are identical to computing them one at a time; only the VNInfo
+/// memory differs.
+void LiveIntervals::computeVirtRegsInParallel(unsigned NumChunks,
+                                              unsigned NumThreads) {
+  // Dominance queries update the DFS numbers lazily.  Do it now so the
+  // threads only read the tree.
+  DomTree->updateDFSNumbers();
+
+  unsigned NumVirtRegs = MRI->getNumVirtRegs();
+  SmallVector<VirtRegChunk, 16> Chunks(NumChunks);
+  SmallVector<void*, 16> ChunkPtrs(NumChunks);
+  for (unsigned i = 0; i != NumChunks; ++i) {
+    VirtRegChunk &C = Chunks[i];
+    C.LIS = this;
+    C.Begin = uint64_t(NumVirtRegs) * i / NumChunks;
+    C.End = uint64_t(NumVirtRegs) * (i + 1) / NumChunks;
+    C.Alloc = new VNInfo::Allocator();
+    ChunkAllocators.push_back(C.Alloc);
+    ChunkPtrs[i] = &C;
+  }
+  llvm_execute_on_threads(computeVirtRegChunk, &ChunkPtrs[0], NumChunks,
+                          NumThreads);
+}
+
+void LiveIntervals::computeVirtRegChunk(void *Arg) {
+  VirtRegChunk &C = *static_cast<VirtRegChunk*>(Arg);
+  LiveIntervals &LIS = *C.LIS;
+  for (unsigned i = C.Begin; i != C.End; ++i) {
+    unsigned Reg = TargetRegisterInfo::index2VirtReg(i);
+    if (LIS.MRI->reg_nodbg_empty(Reg))
+      continue;
+    LiveInterval *LI = createInterval(Reg);
+    LIS.VirtRegIntervals[Reg] = LI;
+    C.Calc.reset(LIS.MF, LIS.Indexes, LIS.DomTree, C.Alloc);
+    C.Calc.createDeadDefs(LI);
+    C.Calc.extendToUses(LI);
+  }
+}
+
 void LiveIntervals::computeRegMasks() {
   RegMaskBlocks.resize(MF->getNumBlockIDs());
 
@@ -30,6 +30,7 @@
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/GraphWriter.h"
+#include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetInstrInfo.h"
 #include <queue>
@@ -63,6 +64,9 @@ static cl::opt<bool> EnableMacroFusion("misched-fusion", cl::Hidden,
 static cl::opt<bool> VerifyScheduling("verify-misched", cl::Hidden,
   cl::desc("Verify machine instrs before and after machine scheduling"));
 
+static cl::opt<bool> MISchedReport("misched-report", cl::Hidden,
+  cl::desc("Print a comma-separated record for each scheduled region"));
+
 // DAG subtrees must have at least this many nodes.
 static const unsigned MinSubtreeSize = 8;
 
@@ -174,6 +178,58 @@ nextIfDebug(MachineBasicBlock::iterator I, MachineBasicBlock::iterator End) {
   return I;
 }
 
+/// Return the registered name of a machine scheduler factory.
+static const char *
+getMachineSchedName(MachineSchedRegistry::ScheduleDAGCtor C) {
+  for (MachineSchedRegistry *R = MachineSchedRegistry::getList(); R;
+       R = R->getNext()) {
+    if ((MachineSchedRegistry::ScheduleDAGCtor)R->getCtor() == C)
+      return R->getName();
+  }
+  return "unknown";
+}
+
+/// Print the -misched-report record for the region that was just scheduled:
+///
+///   misched,<scheduler>,<function>,<block>,<nodes>,<edges>,<critical path>,
+///   <max pressure>,<scheduled max pressure>,<excess pressure>,
+///   <scheduled excess pressure>,<microseconds>
+///
+/// Pressure is the largest pressure of any pressure set; excess pressure sums
+/// the units by which each pressure set exceeds its limit. Pressure columns
+/// are empty if the scheduler does not track register pressure.
+static void reportSchedRegion(const char *SchedName, ScheduleDAGInstrs &DAG,
+                              const RegisterClassInfo &RCI, double Seconds) {
+  unsigned NumEdges = 0, CriticalPath = 0;
+  for (std::vector<SUnit>::iterator I = DAG.SUnits.begin(),
+         E = DAG.SUnits.end(); I != E; ++I) {
+    NumEdges += I->Succs.size();
+    CriticalPath = std::max(CriticalPath, I->getDepth() + I->Latency);
+  }
+  raw_ostream &OS = errs();
+  OS << "misched," << SchedName << ',' << DAG.MF.getName() << ','
+     << DAG.begin()->getParent()->getNumber() << ',' << DAG.SUnits.size()
+     << ',' << NumEdges << ',' << CriticalPath << ',';
+
+  std::vector<unsigned> Before, After;
+  if (DAG.getRegionPressure(Before, After)) {
+    unsigned MaxBefore = 0, MaxAfter = 0, ExcessBefore = 0, ExcessAfter = 0;
+    for (unsigned i = 0, e = Before.size(); i != e; ++i) {
+      unsigned Limit = RCI.getRegPressureSetLimit(i);
+      MaxBefore = std::max(MaxBefore, Before[i]);
+      MaxAfter = std::max(MaxAfter, After[i]);
+      if (Before[i] > Limit)
+        ExcessBefore += Before[i] - Limit;
+      if (After[i] > Limit)
+        ExcessAfter += After[i] - Limit;
+    }
+    OS << MaxBefore << ',' << MaxAfter << ',' << ExcessBefore << ','
+       << ExcessAfter;
+  } else
+    OS << ",,,";
+  OS << ',' << (uint64_t)(Seconds * 1e6) << '\n';
+}
+
 /// Top-level MachineScheduler pass driver.
 ///
 /// Visit blocks in function order. Divide each block into scheduling regions
@@ -221,6 +277,7 @@ bool MachineScheduler::runOnMachineFunction(MachineFunction &mf) {
   }
   // Instantiate the selected scheduler.
   OwningPtr<ScheduleDAGInstrs> Scheduler(Ctor(this));
+  const char *SchedName = MISchedReport ? getMachineSchedName(Ctor) : 0;
 
   // Visit all machine basic blocks.
   //
@@ -281,7 +338,15 @@ bool MachineScheduler::runOnMachineFunction(MachineFunction &mf) {
 
       // Schedule a region: possibly reorder instructions.
       // This invalidates 'RegionEnd' and 'I'.
-      Scheduler->schedule();
+      TimeRecord SchedTime;
+      if (MISchedReport) {
+        SchedTime -= TimeRecord::getCurrentTime(true);
+        Scheduler->schedule();
+        SchedTime += TimeRecord::getCurrentTime(false);
+        reportSchedRegion(SchedName, *Scheduler, *RegClassInfo,
+                          SchedTime.getProcessTime());
+      } else
+        Scheduler->schedule();
 
       // Close the current region.
       Scheduler->exitRegion();
@@ -576,6 +641,20 @@ void ScheduleDAGMI::schedule() {
     });
 }
 
+/// getRegionPressure - The region pressure was computed while building the
+/// DAG. The scheduled pressure is the larger of the pressure seen by the top
+/// and bottom trackers as they moved across the scheduled instructions.
+bool ScheduleDAGMI::getRegionPressure(std::vector<unsigned> &Before,
+                                      std::vector<unsigned> &After) const {
+  Before = RegPressure.MaxSetPressure;
+  After = TopPressure.MaxSetPressure;
+  After.resize(Before.size());
+  const std::vector<unsigned> &Bot = BotPressure.MaxSetPressure;
+  for (unsigned i = 0, e = std::min(After.size(), Bot.size()); i != e; ++i)
+    After[i] = std::max(After[i], Bot[i]);
+  return true;
+}
+
 /// Build the DAG and setup three register pressure trackers.
 void ScheduleDAGMI::buildDAGWithRegPressure() {
   // Initialize the register pressure tracker used by buildSchedGraph.
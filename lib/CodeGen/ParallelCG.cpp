@@ -0,0 +1,439 @@
+//===-- ParallelCG.cpp ----------------------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines functions that can be used for parallel code generation.
+//
+// The module is split into partitions of whole global definitions.  Code
+// generation state (the MCContext, MachineModuleInfo and the per-function
+// SelectionDAG and MachineFunction objects) is not thread safe, so rather than
+// sharing one pipeline between threads, every partition is read back from
+// bitcode into its own LLVMContext and compiled by its own TargetMachine.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/CodeGen/ParallelCG.h"
+#include "llvm/ADT/EquivalenceClasses.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/Triple.h"
+#include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/GlobalAlias.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/PassManager.h"
+#include "llvm/Support/FormattedStream.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetLibraryInfo.h"
+#include <algorithm>
+using namespace llvm;
+
+namespace {
+typedef EquivalenceClasses<const GlobalValue*> GVClasses;
+
+/// PartitionJob - Everything a worker thread needs to compile one partition.
+struct PartitionJob {
+  StringRef Bitcode;
+  StringRef ModuleID;
+  unsigned Partition;
+  unsigned NumPartitions;
+  const std::vector<unsigned> *FnParts;
+  const std::vector<unsigned> *GVParts;
+  const std::vector<unsigned> *AliasParts;
+  /// The new names of the functions, global variables and aliases that are
+  /// promoted to hidden externals, or empty strings.
+  const std::vector<std::string> *FnNames;
+  const std::vector<std::string> *GVNames;
+  const std::vector<std::string> *AliasNames;
+  raw_ostream *OS;
+  TargetMachineFactory CreateTM;
+  void *Opaque;
+  TargetMachine::CodeGenFileType FileType;
+  std::string ErrMsg;
+};
+
+/// ClassWeightCompare - Order equivalence classes by decreasing weight, and by
+/// position in the module to break ties.
+struct ClassWeightCompare {
+  const std::vector<uint64_t> &Weights;
+  explicit ClassWeightCompare(const std::vector<uint64_t> &W) : Weights(W) {}
+  bool operator()(unsigned A, unsigned B) const {
+    if (Weights[A] != Weights[B])
+      return Weights[A] > Weights[B];
+    return A < B;
+  }
+};
+} // end anonymous namespace
+
+/// isDefinition - Return true if GV has to be assigned to a partition.
+static bool isDefinition(const GlobalValue *GV) {
+  return !GV->isDeclaration();
+}
+
+/// addUserDefinitions - Collect the global definitions that refer to V, either
+/// directly or through constants.
+static void addUserDefinitions(const Value *V,
+                               SmallPtrSet<const Value*, 16> &Visited,
+                               SmallVectorImpl<const GlobalValue*> &Defs) {
+  for (Value::const_use_iterator UI = V->use_begin(), UE = V->use_end();
+       UI != UE; ++UI) {
+    const User *U = *UI;
+    if (const Instruction *I = dyn_cast<Instruction>(U)) {
+      Defs.push_back(I->getParent()->getParent());
+    } else if (const GlobalValue *GV = dyn_cast<GlobalValue>(U)) {
+      Defs.push_back(GV);
+    } else if (isa<Constant>(U) && Visited.insert(U)) {
+      addUserDefinitions(U, Visited, Defs);
+    }
+  }
+}
+
+/// mergeWithUsers - Put GV in the same class as every definition using it.
+static void mergeWithUsers(GVClasses &GVC, const GlobalValue *GV,
+                           const Value *V) {
+  SmallPtrSet<const Value*, 16> Visited;
+  SmallVector<const GlobalValue*, 16> Defs;
+  addUserDefinitions(V, Visited, Defs);
+  for (unsigned i = 0, e = Defs.size(); i != e; ++i)
+    GVC.unionSets(GV, Defs[i]);
+}
+
+/// getWeight - Estimate the code generation cost of GV.
+static uint64_t getWeight(const GlobalValue *GV) {
+  const Function *F = dyn_cast<Function>(GV);
+  if (!F)
+    return 1;
+  uint64_t Weight = 1;
+  for (Function::const_iterator BB = F->begin(), E = F->end(); BB != E; ++BB)
+    Weight += BB->size();
+  return Weight;
+}
+
+void llvm::partitionModule(const Module &M, unsigned NumPartitions,
+                           std::vector<unsigned> &FnParts,
+                           std::vector<unsigned> &GVParts,
+                           std::vector<unsigned> &AliasParts) {
+  assert(NumPartitions && "Cannot split a module into zero partitions!");
+  SmallVector<const GlobalValue*, 64> Defs;
+  for (Module::const_iterator I = M.begin(), E = M.end(); I != E; ++I)
+    if (isDefinition(I))
+      Defs.push_back(I);
+  for (Module::const_global_iterator I = M.global_begin(),
+       E = M.global_end(); I != E; ++I)
+    if (isDefinition(I))
+      Defs.push_back(I);
+  for (Module::const_alias_iterator I = M.alias_begin(), E = M.alias_end();
+       I != E; ++I)
+    Defs.push_back(I);
+
+  GVClasses GVC;
+  for (unsigned i = 0, e = Defs.size(); i != e; ++i) {
+    const GlobalValue *GV = Defs[i];
+    GVC.insert(GV);
+
+    // The blocks of a function that has its address taken cannot be referenced
+    // from another partition.  Local symbols can, once splitCodeGen has
+    // promoted them.
+    if (isa<Function>(GV))
+      for (Value::const_use_iterator UI = GV->use_begin(),
+           UE = GV->use_end(); UI != UE; ++UI)
+        if (isa<BlockAddress>(*UI))
+          mergeWithUsers(GVC, GV, *UI);
+
+    // An alias must be defined next to its aliasee.
+    if (const GlobalAlias *GA = dyn_cast<GlobalAlias>(GV))
+      if (const GlobalValue *Aliasee = GA->getAliasedGlobal())
+        if (isDefinition(Aliasee))
+          GVC.unionSets(GA, Aliasee);
+  }
+
+  // Number the classes in module order and weigh them.
+  DenseMap<const GlobalValue*, unsigned> ClassOfLeader;
+  std::vector<unsigned> ClassOf(Defs.size());
+  std::vector<uint64_t> Weights;
+  for (unsigned i = 0, e = Defs.size(); i != e; ++i) {
+    const GlobalValue *Leader = GVC.getLeaderValue(Defs[i]);
+    std::pair<DenseMap<const GlobalValue*, unsigned>::iterator, bool> Ins =
+      ClassOfLeader.insert(std::make_pair(Leader, Weights.size()));
+    if (Ins.second)
+      Weights.push_back(0);
+    ClassOf[i] = Ins.first->second;
+    Weights[ClassOf[i]] += getWeight(Defs[i]);
+  }
+
+  // Hand out the heaviest classes first, each to the lightest partition.
+  std::vector<unsigned> Order(Weights.size());
+  for (unsigned i = 0, e = Order.size(); i != e; ++i)
+    Order[i] = i;
+  std::sort(Order.begin(), Order.end(), ClassWeightCompare(Weights));
+
+  std::vector<uint64_t> Load(NumPartitions);
+  std::vector<unsigned> PartOfClass(Weights.size());
+  for (unsigned i = 0, e = Order.size(); i != e; ++i) {
+    unsigned Lightest =
+      std::min_element(Load.begin(), Load.end()) - Load.begin();
+    PartOfClass[Order[i]] = Lightest;
+    Load[Lightest] += Weights[Order[i]];
+  }
+
+  // Write the result out in module order.
+  DenseMap<const GlobalValue*, unsigned> PartOf;
+  for (unsigned i = 0, e = Defs.size(); i != e; ++i)
+    PartOf[Defs[i]] = PartOfClass[ClassOf[i]];
+
+  FnParts.clear();
+  for (Module::const_iterator I = M.begin(), E = M.end(); I != E; ++I)
+    FnParts.push_back(isDefinition(I) ? PartOf.lookup(I) : NumPartitions);
+  GVParts.clear();
+  for (Module::const_global_iterator I = M.global_begin(),
+       E = M.global_end(); I != E; ++I)
+    GVParts.push_back(isDefinition(I) ? PartOf.lookup(I) : NumPartitions);
+  AliasParts.clear();
+  for (Module::const_alias_iterator I = M.alias_begin(), E = M.alias_end();
+       I != E; ++I)
+    AliasParts.push_back(PartOf.lookup(I));
+}
+
+/// getPromotedNames - Choose a new name for every local definition of M that
+/// is used from a partition other than its own, and return the names in
+/// FnNames, GVNames and AliasNames, in module order.  The names of the other
+/// globals are left empty.
+static void getPromotedNames(const Module &M,
+                             const std::vector<unsigned> &FnParts,
+                             const std::vector<unsigned> &GVParts,
+                             const std::vector<unsigned> &AliasParts,
+                             std::vector<std::string> &FnNames,
+                             std::vector<std::string> &GVNames,
+                             std::vector<std::string> &AliasNames) {
+  DenseMap<const GlobalValue*, unsigned> PartOf;
+  SmallVector<const GlobalValue*, 64> Globals;
+  unsigned i = 0;
+  for (Module::const_iterator I = M.begin(), E = M.end(); I != E; ++I, ++i) {
+    PartOf[I] = FnParts[i];
+    Globals.push_back(I);
+  }
+  i = 0;
+  for (Module::const_global_iterator I = M.global_begin(),
+       E = M.global_end(); I != E; ++I, ++i) {
+    PartOf[I] = GVParts[i];
+    Globals.push_back(I);
+  }
+  i = 0;
+  for (Module::const_alias_iterator I = M.alias_begin(), E = M.alias_end();
+       I != E; ++I, ++i) {
+    PartOf[I] = AliasParts[i];
+    Globals.push_back(I);
+  }
+
+  std::vector<std::string> Names(Globals.size());
+  unsigned NextSuffix = 0;
+  for (i = 0; i != Globals.size(); ++i) {
+    const GlobalValue *GV = Globals[i];
+    if (!GV->hasLocalLinkage() || !isDefinition(GV))
+      continue;
+    SmallPtrSet<const Value*, 16> Visited;
+    SmallVector<const GlobalValue*, 16> Users;
+    addUserDefinitions(GV, Visited, Users);
+    unsigned Part = PartOf.lookup(GV);
+    bool UsedElsewhere = false;
+    for (unsigned j = 0, e = Users.size(); j != e && !UsedElsewhere; ++j)
+      UsedElsewhere = PartOf.lookup(Users[j]) != Part;
+    if (!UsedElsewhere)
+      continue;
+
+    // Every name of this form has a different suffix, so only the names
+    // already in M can clash.
+    StringRef Base = GV->hasName() ? GV->getName() : "anon";
+    do
+      Names[i] = (Base + ".llvm." + utostr(NextSuffix++)).str();
+    while (M.getNamedValue(Names[i]));
+  }
+
+  std::vector<std::string>::iterator FnEnd = Names.begin() + FnParts.size();
+  std::vector<std::string>::iterator GVEnd = FnEnd + GVParts.size();
+  FnNames.assign(Names.begin(), FnEnd);
+  GVNames.assign(FnEnd, GVEnd);
+  AliasNames.assign(GVEnd, Names.end());
+}
+
+/// promote - Give GV the name chosen by getPromotedNames, if any, and make it
+/// a hidden external.
+static void promote(GlobalValue *GV, const std::string &Name) {
+  if (Name.empty())
+    return;
+  GV->setName(Name);
+  GV->setLinkage(GlobalValue::ExternalLinkage);
+  GV->setVisibility(GlobalValue::HiddenVisibility);
+}
+
+/// replaceAliasWithDeclaration - Replace GA with an external declaration of
+/// the same name and type.
+static void replaceAliasWithDeclaration(GlobalAlias *GA) {
+  Module *M = GA->getParent();
+  Type *Ty = GA->getType()->getElementType();
+  GlobalValue *Decl;
+  if (FunctionType *FTy = dyn_cast<FunctionType>(Ty)) {
+    Decl = Function::Create(FTy, GlobalValue::ExternalLinkage, "", M);
+  } else {
+    GlobalVariable::ThreadLocalMode TLM = GlobalVariable::NotThreadLocal;
+    if (const GlobalVariable *GV =
+          dyn_cast_or_null<GlobalVariable>(GA->resolveAliasedGlobal(false)))
+      TLM = GV->getThreadLocalMode();
+    Decl = new GlobalVariable(*M, Ty, false, GlobalValue::ExternalLinkage, 0,
+                              "", 0, TLM, GA->getType()->getAddressSpace());
+  }
+  Decl->setVisibility(GA->getVisibility());
+  Decl->takeName(GA);
+  GA->replaceAllUsesWith(Decl);
+  GA->eraseFromParent();
+}
+
+/// loadPartition - Read the bitcode of the whole module lazily into Context,
+/// and only keep the definitions that belong to Job's partition.
+static Module *loadPartition(PartitionJob &Job, LLVMContext &Context) {
+  MemoryBuffer *Buffer =
+    MemoryBuffer::getMemBuffer(Job.Bitcode, Job.ModuleID, false);
+  Module *M = getLazyBitcodeModule(Buffer, Context, &Job.ErrMsg);
+  if (!M) {
+    delete Buffer;
+    return 0;
+  }
+
+  // Function bodies that are not materialized are never read, so the other
+  // partitions' functions are left as declarations.
+  unsigned i = 0;
+  for (Module::iterator I = M->begin(), E = M->end(); I != E; ++i, ++I) {
+    promote(I, (*Job.FnNames)[i]);
+    unsigned Part = (*Job.FnParts)[i];
+    if (Part == Job.Partition) {
+      if (I->Materialize(&Job.ErrMsg)) {
+        delete M;
+        return 0;
+      }
+    } else if (Part != Job.NumPartitions) {
+      I->setLinkage(GlobalValue::ExternalLinkage);
+    }
+  }
+
+  i = 0;
+  for (Module::global_iterator I = M->global_begin(), E = M->global_end();
+       I != E; ++i, ++I) {
+    promote(I, (*Job.GVNames)[i]);
+    unsigned Part = (*Job.GVParts)[i];
+    if (Part == Job.Partition || Part == Job.NumPartitions)
+      continue;
+    I->setInitializer(0);
+    I->setLinkage(GlobalValue::ExternalLinkage);
+  }
+
+  i = 0;
+  for (Module::alias_iterator I = M->alias_begin(), E = M->alias_end();
+       I != E; ++i) {
+    GlobalAlias *GA = I++;
+    promote(GA, (*Job.AliasNames)[i]);
+    if ((*Job.AliasParts)[i] != Job.Partition)
+      replaceAliasWithDeclaration(GA);
+  }
+
+  // Module level inline asm is emitted once, with the first partition.
+  if (Job.Partition != 0)
+    M->setModuleInlineAsm("");
+  return M;
+}
+
+/// codeGenPartition - Load and compile one partition.  This runs on a worker
+/// thread, so it must only touch the state owned by its PartitionJob.
+static void codeGenPartition(void *Arg) {
+  PartitionJob &Job = *static_cast<PartitionJob*>(Arg);
+  LLVMContext Context;
+  OwningPtr<Module> M(loadPartition(Job, Context));
+  if (!M)
+    return;
+
+  OwningPtr<TargetMachine> TM(Job.CreateTM(Job.Opaque));
+  if (!TM) {
+    Job.ErrMsg = "could not allocate target machine";
+    return;
+  }
+
+  PassManager PM;
+  PM.add(new TargetLibraryInfo(Triple(M->getTargetTriple())));
+  TM->addAnalysisPasses(PM);
+  if (const DataLayout *TD = TM->getDataLayout())
+    PM.add(new DataLayout(*TD));
+  else
+    PM.add(new DataLayout(M.get()));
+
+  formatted_raw_ostream FOS(*Job.OS);
+  if (TM->addPassesToEmitFile(PM, FOS, Job.FileType,
+                              /*DisableVerify=*/true)) {
+    Job.ErrMsg = "target does not support generation of this file type";
+    return;
+  }
+  PM.run(*M);
+}
+
+bool llvm::splitCodeGen(const Module &M, ArrayRef<raw_ostream *> OSs,
+                        unsigned NumThreads, TargetMachineFactory CreateTM,
+                        void *Opaque, TargetMachine::CodeGenFileType FileType,
+                        std::string &ErrMsg) {
+  assert(!OSs.empty() && "No partitions to generate!");
+  std::vector<unsigned> FnParts, GVParts, AliasParts;
+  partitionModule(M, OSs.size(), FnParts, GVParts, AliasParts);
+  std::vector<std::string> FnNames, GVNames, AliasNames;
+  getPromotedNames(M, FnParts, GVParts, AliasParts, FnNames, GVNames,
+                   AliasNames);
+
+  // Every partition is read back from this one copy of the module.
+  SmallString<0> Bitcode;
+  {
+    raw_svector_ostream BOS(Bitcode);
+    WriteBitcodeToFile(&M, BOS);
+  }
+
+  std::vector<PartitionJob> Jobs(OSs.size());
+  std::vector<void*> JobPtrs(OSs.size());
+  for (unsigned i = 0, e = OSs.size(); i != e; ++i) {
+    PartitionJob &Job = Jobs[i];
+    Job.Bitcode = Bitcode.str();
+    Job.ModuleID = M.getModuleIdentifier();
+    Job.Partition = i;
+    Job.NumPartitions = e;
+    Job.FnParts = &FnParts;
+    Job.GVParts = &GVParts;
+    Job.AliasParts = &AliasParts;
+    Job.FnNames = &FnNames;
+    Job.GVNames = &GVNames;
+    Job.AliasNames = &AliasNames;
+    Job.OS = OSs[i];
+    Job.CreateTM = CreateTM;
+    Job.Opaque = Opaque;
+    Job.FileType = FileType;
+    JobPtrs[i] = &Job;
+  }
+
+  llvm_execute_on_threads(codeGenPartition, &JobPtrs[0], JobPtrs.size(),
+                          NumThreads);
+
+  for (unsigned i = 0, e = Jobs.size(); i != e; ++i)
+    if (!Jobs[i].ErrMsg.empty()) {
+      ErrMsg = Jobs[i].ErrMsg;
+      return true;
+    }
+  return false;
+}
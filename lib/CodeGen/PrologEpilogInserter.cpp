@@ -25,6 +25,7 @@
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallSet.h"
 #include "llvm/ADT/Statistic.h"
+#include "llvm/CodeGen/MachineBlockFrequencyInfo.h"
 #include "llvm/CodeGen/MachineDominators.h"
 #include "llvm/CodeGen/MachineFrameInfo.h"
 #include "llvm/CodeGen/MachineInstr.h"
@@ -53,10 +54,21 @@ WarnStackSize("warn-stack-size", cl::Hidden, cl::init((unsigned)-1),
               cl::desc("Warn for stack size bigger than the given"
                        " number"));
 
+static cl::opt<bool>
+CompactStackFrame("compact-stack-frame", cl::Hidden,
+                  cl::desc("Order stack objects by access frequency and pack "
+                           "them into alignment padding"));
+
+static cl::opt<bool>
+ReportFrameCompaction("compact-stack-frame-report", cl::Hidden,
+                      cl::desc("Print the stack size of each function with "
+                               "and without -compact-stack-frame"));
+
 INITIALIZE_PASS_BEGIN(PEI, "prologepilog",
                 "Prologue/Epilogue Insertion", false, false)
 INITIALIZE_PASS_DEPENDENCY(MachineLoopInfo)
 INITIALIZE_PASS_DEPENDENCY(MachineDominatorTree)
+INITIALIZE_PASS_DEPENDENCY(MachineBlockFrequencyInfo)
 INITIALIZE_PASS_DEPENDENCY(TargetPassConfig)
 INITIALIZE_PASS_END(PEI, "prologepilog",
                     "Prologue/Epilogue Insertion & Frame Finalization",
@@ -65,6 +77,12 @@ INITIALIZE_PASS_END(PEI, "prologepilog",
 STATISTIC(NumScavengedRegs, "Number of frame index regs scavenged");
 STATISTIC(NumBytesStackSpace,
           "Number of bytes used for stack in all functions");
+STATISTIC(NumBytesCompacted,
+          "Number of stack bytes saved by frame compaction");
+
+PEI::PEI() : MachineFunctionPass(ID), CompactFrame(CompactStackFrame) {
+  initializePEIPass(*PassRegistry::getPassRegistry());
+}
 
 /// runOnMachineFunction - Insert prolog/epilog code and replace abstract
 /// frame indexes with appropriate references.
@@ -110,7 +128,23 @@ bool PEI::runOnMachineFunction(MachineFunction &Fn) {
   TFI->processFunctionBeforeFrameFinalized(Fn, RS);
 
   // Calculate actual frame offsets for all abstract stack objects...
-  calculateFrameObjectOffsets(Fn);
+  MachineFrameInfo *MFI = Fn.getFrameInfo();
+  if (CompactFrame && (ReportFrameCompaction || AreStatisticsEnabled())) {
+    // Lay the frame out without compaction first to measure the savings.
+    // calculateFrameObjectOffsets only assigns the offsets of non-fixed
+    // objects and the stack size, so the second layout replaces all of it.
+    calculateFrameObjectOffsets(Fn, /*Compact=*/false);
+    uint64_t DefaultSize = MFI->getStackSize();
+    calculateFrameObjectOffsets(Fn, /*Compact=*/true);
+    uint64_t CompactSize = MFI->getStackSize();
+    if (CompactSize < DefaultSize)
+      NumBytesCompacted += DefaultSize - CompactSize;
+    if (ReportFrameCompaction)
+      errs() << "frame-compaction," << Fn.getName() << ',' << DefaultSize
+             << ',' << CompactSize << '\n';
+  } else
+    calculateFrameObjectOffsets(Fn, CompactFrame);
+  NumBytesStackSpace += MFI->getStackSize();
 
   // Add prolog and epilog code to the function.  This function is required
   // to align the stack frame as necessary for any stack variables or
@@ -136,7 +170,6 @@ bool PEI::runOnMachineFunction(MachineFunction &Fn) {
   Fn.getRegInfo().clearVirtRegs();
 
   // Warn on stack size when we exceeds the given limit.
-  MachineFrameInfo *MFI = Fn.getFrameInfo();
   if (WarnStackSize.getNumOccurrences() > 0 &&
       WarnStackSize < MFI->getStackSize())
     errs() << "warning: Stack size limit exceeded (" << MFI->getStackSize()
@@ -487,10 +520,112 @@ AdjustStackOffset(MachineFrameInfo *MFI, int FrameIdx,
   }
 }
 
+/// PackStackObjects - Assign offsets to the frame objects in Objs, in order,
+/// like AdjustStackOffset. An object that fits in the alignment padding left
+/// before an earlier object is placed there instead of at the end.
+static void
+PackStackObjects(MachineFrameInfo *MFI, ArrayRef<int> Objs,
+                 bool StackGrowsDown, int64_t &Offset, unsigned &MaxAlign) {
+  // Unused [Begin, End) ranges, measured like Offset in the direction of
+  // stack growth.
+  SmallVector<std::pair<int64_t, int64_t>, 8> Holes;
+
+  for (ArrayRef<int>::iterator I = Objs.begin(), E = Objs.end(); I != E; ++I) {
+    int FrameIdx = *I;
+    int64_t Size = MFI->getObjectSize(FrameIdx);
+    unsigned Align = MFI->getObjectAlignment(FrameIdx);
+    MaxAlign = std::max(MaxAlign, Align);
+
+    // The object occupies [Begin, Begin + Size). When the stack grows down,
+    // the end of that range is what must be aligned.
+    int64_t Begin = 0;
+    bool Placed = false;
+    for (unsigned h = 0, he = Holes.size(); h != he && !Placed; ++h) {
+      int64_t HoleBegin = Holes[h].first, HoleEnd = Holes[h].second;
+      if (StackGrowsDown)
+        Begin = RoundUpToAlignment(HoleBegin + Size, Align) - Size;
+      else
+        Begin = RoundUpToAlignment(HoleBegin, Align);
+      if (Begin + Size > HoleEnd)
+        continue;
+      Holes.erase(Holes.begin() + h);
+      if (Begin + Size < HoleEnd)
+        Holes.insert(Holes.begin() + h, std::make_pair(Begin + Size, HoleEnd));
+      if (HoleBegin < Begin)
+        Holes.insert(Holes.begin() + h, std::make_pair(HoleBegin, Begin));
+      Placed = true;
+    }
+
+    if (!Placed) {
+      if (StackGrowsDown)
+        Begin = RoundUpToAlignment(Offset + Size, Align) - Size;
+      else
+        Begin = RoundUpToAlignment(Offset, Align);
+      if (Offset < Begin)
+        Holes.push_back(std::make_pair(Offset, Begin));
+      Offset = Begin + Size;
+    }
+
+    int64_t ObjOffset = StackGrowsDown ? -(Begin + Size) : Begin;
+    DEBUG(dbgs() << "alloc FI(" << FrameIdx << ") at SP[" << ObjOffset
+          << "]\n");
+    MFI->setObjectOffset(FrameIdx, ObjOffset);
+  }
+}
+
+namespace {
+/// Orders frame objects by decreasing access frequency, then by decreasing
+/// alignment so that padding is only needed between frequency classes.
+struct FrameObjectCompare {
+  const MachineFrameInfo *MFI;
+  const DenseMap<int, uint64_t> &Freq;
+
+  FrameObjectCompare(const MachineFrameInfo *MFI,
+                     const DenseMap<int, uint64_t> &Freq)
+    : MFI(MFI), Freq(Freq) {}
+
+  bool operator()(int A, int B) const {
+    uint64_t FA = Freq.lookup(A), FB = Freq.lookup(B);
+    if (FA != FB)
+      return FA > FB;
+    return MFI->getObjectAlignment(A) > MFI->getObjectAlignment(B);
+  }
+};
+} // end anonymous namespace
+
+/// orderFrameObjectsByFrequency - Sort Objs so the most frequently accessed
+/// objects get the smallest offsets from the register used to address them.
+/// Frame objects are addressed from the frame pointer when there is one and
+/// the stack isn't realigned, and from the stack pointer otherwise.
+void PEI::orderFrameObjectsByFrequency(MachineFunction &Fn,
+                                       SmallVectorImpl<int> &Objs) {
+  const MachineBlockFrequencyInfo &MBFI =
+    getAnalysis<MachineBlockFrequencyInfo>();
+  DenseMap<int, uint64_t> Freq;
+  for (MachineFunction::iterator BB = Fn.begin(), E = Fn.end(); BB != E; ++BB) {
+    uint64_t BlockFreq = MBFI.getBlockFreq(BB).getFrequency();
+    for (MachineBasicBlock::iterator I = BB->begin(); I != BB->end(); ++I)
+      for (unsigned i = 0, e = I->getNumOperands(); i != e; ++i)
+        if (I->getOperand(i).isFI())
+          Freq[I->getOperand(i).getIndex()] += BlockFreq;
+  }
+
+  std::stable_sort(Objs.begin(), Objs.end(),
+                   FrameObjectCompare(Fn.getFrameInfo(), Freq));
+
+  // The objects laid out last are the closest to the stack pointer.
+  const TargetRegisterInfo *RegInfo = Fn.getTarget().getRegisterInfo();
+  if (!Fn.getTarget().getFrameLowering()->hasFP(Fn) ||
+      RegInfo->needsStackRealignment(Fn))
+    std::reverse(Objs.begin(), Objs.end());
+}
+
 /// calculateFrameObjectOffsets - Calculate actual frame offsets for all of the
-/// abstract stack objects.
+/// abstract stack objects. With Compact, the objects that are not laid out
+/// specially are ordered by access frequency and packed into the alignment
+/// padding between them.
 ///
-void PEI::calculateFrameObjectOffsets(MachineFunction &Fn) {
+void PEI::calculateFrameObjectOffsets(MachineFunction &Fn, bool Compact) {
   const TargetFrameLowering &TFI = *Fn.getTarget().getFrameLowering();
 
   bool StackGrowsDown =
@@ -625,6 +760,7 @@ void PEI::calculateFrameObjectOffsets(MachineFunction &Fn) {
 
   // Then assign frame offsets to stack objects that are not used to spill
   // callee saved registers.
+  SmallVector<int, 16> Objs;
   for (unsigned i = 0, e = MFI->getObjectIndexEnd(); i != e; ++i) {
     if (MFI->isObjectPreAllocated(i) &&
         MFI->getUseLocalStackAllocationBlock())
@@ -640,7 +776,15 @@ void PEI::calculateFrameObjectOffsets(MachineFunction &Fn) {
     if (LargeStackObjs.count(i))
       continue;
 
-    AdjustStackOffset(MFI, i, StackGrowsDown, Offset, MaxAlign);
+    Objs.push_back(i);
+  }
+
+  if (Compact) {
+    orderFrameObjectsByFrequency(Fn, Objs);
+    PackStackObjects(MFI, Objs, StackGrowsDown, Offset, MaxAlign);
+  } else {
+    for (unsigned i = 0, e = Objs.size(); i != e; ++i)
+      AdjustStackOffset(MFI, Objs[i], StackGrowsDown, Offset, MaxAlign);
   }
 
   // Make sure the special register scavenging spill slot is closest to the
@@ -683,7 +827,6 @@ void PEI::calculateFrameObjectOffsets(MachineFunction &Fn) {
   // Update frame info to pretend that this is part of the stack...
   int64_t StackSize = Offset - LocalAreaOffset;
   MFI->setStackSize(StackSize);
-  NumBytesStackSpace += StackSize;
 }
 
 /// insertPrologEpilogCode - Scan the function for modified callee saved
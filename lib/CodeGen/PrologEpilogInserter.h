@@ -36,9 +36,7 @@ namespace llvm {
   class PEI : public MachineFunctionPass {
   public:
     static char ID;
-    PEI() : MachineFunctionPass(ID) {
-      initializePEIPass(*PassRegistry::getPassRegistry());
-    }
+    PEI();
 
     virtual void getAnalysisUsage(AnalysisUsage &AU) const;
 
@@ -50,6 +48,10 @@ namespace llvm {
   private:
     RegScavenger *RS;
 
+    // CompactFrame - Set from -compact-stack-frame when the pass is created,
+    // so that getAnalysisUsage knows whether block frequencies are needed.
+    bool CompactFrame;
+
     // MinCSFrameIndex, MaxCSFrameIndex - Keeps the range of callee saved
     // stack frame indexes.
     unsigned MinCSFrameIndex, MaxCSFrameIndex;
@@ -125,7 +127,9 @@ namespace llvm {
     void calculateCallsInformation(MachineFunction &Fn);
     void calculateCalleeSavedRegisters(MachineFunction &Fn);
     void insertCSRSpillsAndRestores(MachineFunction &Fn);
-    void calculateFrameObjectOffsets(MachineFunction &Fn);
+    void calculateFrameObjectOffsets(MachineFunction &Fn, bool Compact);
+    void orderFrameObjectsByFrequency(MachineFunction &Fn,
+                                      SmallVectorImpl<int> &Objs);
     void replaceFrameIndices(MachineFunction &Fn);
     void scavengeFrameVirtualRegs(MachineFunction &Fn);
     void insertPrologEpilogCode(MachineFunction &Fn);
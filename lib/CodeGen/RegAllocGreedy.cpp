@@ -49,6 +49,14 @@ using namespace llvm;
 STATISTIC(NumGlobalSplits, "Number of split global live ranges");
 STATISTIC(NumLocalSplits,  "Number of split local live ranges");
 STATISTIC(NumEvicted,      "Number of interferences evicted");
+STATISTIC(NumBudgetNoRegionSplit,
+          "Number of functions allocated without region splitting past the "
+          "work budget");
+STATISTIC(NumBudgetSpillEverywhere,
+          "Number of functions that fell back to spilling past the work "
+          "budget");
+STATISTIC(NumBudgetSpills,
+          "Number of live ranges spilled without splitting to stay in budget");
 
 static cl::opt<SplitEditor::ComplementSpillMode>
 SplitSpillMode("split-spill-mode", cl::Hidden,
@@ -59,6 +67,13 @@ SplitSpillMode("split-spill-mode", cl::Hidden,
              clEnumValEnd),
   cl::init(SplitEditor::SM_Partition));
 
+static cl::opt<unsigned>
+GreedyWorkBudget("greedy-work-budget", cl::Hidden,
+  cl::desc("Amount of work the greedy allocator may spend on a function "
+           "before it stops region splitting, and then at twice the amount, "
+           "spills whatever cannot be assigned right away (0 = unlimited)"),
+  cl::init(0));
+
 static RegisterRegAlloc greedyRegAlloc("greedy", "greedy register allocator",
                                        createGreedyRegisterAllocator);
 
@@ -84,6 +99,22 @@ class RAGreedy : public MachineFunctionPass,
   std::priority_queue<std::pair<unsigned, unsigned> > Queue;
   unsigned NextCascade;
 
+  // On huge functions, the allocator degrades in tiers to bound compile time.
+  // The work spent on the function is counted in units of roughly one
+  // interference check or one block visited while splitting, and compared to
+  // GreedyWorkBudget.
+  enum BudgetTier {
+    /// Work is within budget, try everything.
+    BT_Full,
+    /// Past the budget, skip region splitting.
+    BT_NoRegionSplit,
+    /// Past twice the budget, spill live ranges that cannot be assigned
+    /// without evicting or splitting anything, like RegAllocBasic.
+    BT_SpillEverywhere
+  };
+  BudgetTier Tier;
+  uint64_t Work;
+
   // Live ranges pass through a number of stages as we try to allocate them.
   // Some of the stages may also create new live ranges:
   //
@@ -263,6 +294,7 @@ private:
   bool canEvictInterference(LiveInterval&, unsigned, bool, EvictionCost&);
   void evictInterference(LiveInterval&, unsigned,
                          SmallVectorImpl<LiveInterval*>&);
+  void chargeWork(unsigned Units);
 
   unsigned tryAssign(LiveInterval&, AllocationOrder&,
                      SmallVectorImpl<LiveInterval*>&);
@@ -431,6 +463,24 @@ LiveInterval *RAGreedy::dequeue() {
   return LI;
 }
 
+/// chargeWork - Account for Units of work on the current function, and move
+/// to the next tier when the work budget runs out.
+void RAGreedy::chargeWork(unsigned Units) {
+  Work += Units;
+  if (!GreedyWorkBudget || Tier == BT_SpillEverywhere)
+    return;
+  if (Tier == BT_Full && Work > GreedyWorkBudget) {
+    DEBUG(dbgs() << "Work budget exceeded, no more region splitting.\n");
+    Tier = BT_NoRegionSplit;
+    ++NumBudgetNoRegionSplit;
+  }
+  if (Tier == BT_NoRegionSplit && Work > 2 * uint64_t(GreedyWorkBudget)) {
+    DEBUG(dbgs() << "Work budget exceeded twice, spilling everywhere.\n");
+    Tier = BT_SpillEverywhere;
+    ++NumBudgetSpillEverywhere;
+  }
+}
+
 
 //===----------------------------------------------------------------------===//
 //                            Direct Assignment
@@ -662,6 +712,7 @@ unsigned RAGreedy::tryEvict(LiveInterval &VirtReg,
 
   Order.rewind();
   while (unsigned PhysReg = Order.nextWithDups(OrderLimit)) {
+    chargeWork(1);
     if (TRI->getCostPerUse(PhysReg) >= CostPerUseLimit)
       continue;
     // The first use of a callee-saved register in a function has cost 1.
@@ -1159,6 +1210,7 @@ unsigned RAGreedy::tryRegionSplit(LiveInterval &VirtReg, AllocationOrder &Order,
       GlobalCand.resize(NumCands+1);
     GlobalSplitCandidate &Cand = GlobalCand[NumCands];
     Cand.reset(IntfCache, PhysReg);
+    chargeWork(SA->getNumLiveBlocks());
 
     SpillPlacer->prepare(Cand.LiveBundles);
     float Cost;
@@ -1669,6 +1721,7 @@ unsigned RAGreedy::trySplit(LiveInterval &VirtReg, AllocationOrder &Order,
   if (LIS->intervalIsInOneMBB(VirtReg)) {
     NamedRegionTimer T("Local Splitting", TimerGroupName, TimePassesIsEnabled);
     SA->analyze(&VirtReg);
+    chargeWork(SA->getUseSlots().size());
     unsigned PhysReg = tryLocalSplit(VirtReg, Order, NewVRegs);
     if (PhysReg || !NewVRegs.empty())
       return PhysReg;
@@ -1678,6 +1731,7 @@ unsigned RAGreedy::trySplit(LiveInterval &VirtReg, AllocationOrder &Order,
   NamedRegionTimer T("Global Splitting", TimerGroupName, TimePassesIsEnabled);
 
   SA->analyze(&VirtReg);
+  chargeWork(SA->getNumLiveBlocks());
 
   // FIXME: SplitAnalysis may repair broken live ranges coming from the
   // coalescer. That may cause the range to become allocatable which means that
@@ -1692,8 +1746,9 @@ unsigned RAGreedy::trySplit(LiveInterval &VirtReg, AllocationOrder &Order,
 
   // First try to split around a region spanning multiple blocks. RS_Split2
   // ranges already made dubious progress with region splitting, so they go
-  // straight to single block splitting.
-  if (getStage(VirtReg) < RS_Split2) {
+  // straight to single block splitting. So does everything once the work
+  // budget has run out.
+  if (getStage(VirtReg) < RS_Split2 && Tier == BT_Full) {
     unsigned PhysReg = tryRegionSplit(VirtReg, Order, NewVRegs);
     if (PhysReg || !NewVRegs.empty())
       return PhysReg;
@@ -1719,35 +1774,43 @@ unsigned RAGreedy::selectOrSplit(LiveInterval &VirtReg,
   DEBUG(dbgs() << StageName[Stage]
                << " Cascade " << ExtraRegInfo[VirtReg.reg].Cascade << '\n');
 
-  // Try to evict a less worthy live range, but only for ranges from the primary
-  // queue. The RS_Split ranges already failed to do this, and they should not
-  // get a second chance until they have been split.
-  if (Stage != RS_Split)
-    if (unsigned PhysReg = tryEvict(VirtReg, Order, NewVRegs))
-      return PhysReg;
+  // Once the work budget has run out twice, spill right away whatever we are
+  // allowed to spill. Unspillable ranges still evict, or they would never be
+  // allocated.
+  if (Tier == BT_SpillEverywhere && Stage < RS_Done && VirtReg.isSpillable()) {
+    DEBUG(dbgs() << "spilling to stay in budget\n");
+    ++NumBudgetSpills;
+  } else {
+    // Try to evict a less worthy live range, but only for ranges from the
+    // primary queue. The RS_Split ranges already failed to do this, and they
+    // should not get a second chance until they have been split.
+    if (Stage != RS_Split)
+      if (unsigned PhysReg = tryEvict(VirtReg, Order, NewVRegs))
+        return PhysReg;
+
+    assert(NewVRegs.empty() && "Cannot append to existing NewVRegs");
+
+    // The first time we see a live range, don't try to split or spill.
+    // Wait until the second time, when all smaller ranges have been allocated.
+    // This gives a better picture of the interference to split around.
+    if (Stage < RS_Split) {
+      setStage(VirtReg, RS_Split);
+      DEBUG(dbgs() << "wait for second round\n");
+      NewVRegs.push_back(&VirtReg);
+      return 0;
+    }
 
-  assert(NewVRegs.empty() && "Cannot append to existing NewVRegs");
+    // If we couldn't allocate a register from spilling, there is probably some
+    // invalid inline assembly. The base class wil report it.
+    if (Stage >= RS_Done || !VirtReg.isSpillable())
+      return ~0u;
 
-  // The first time we see a live range, don't try to split or spill.
-  // Wait until the second time, when all smaller ranges have been allocated.
-  // This gives a better picture of the interference to split around.
-  if (Stage < RS_Split) {
-    setStage(VirtReg, RS_Split);
-    DEBUG(dbgs() << "wait for second round\n");
-    NewVRegs.push_back(&VirtReg);
-    return 0;
+    // Try splitting VirtReg or interferences.
+    unsigned PhysReg = trySplit(VirtReg, Order, NewVRegs);
+    if (PhysReg || !NewVRegs.empty())
+      return PhysReg;
   }
 
-  // If we couldn't allocate a register from spilling, there is probably some
-  // invalid inline assembly. The base class wil report it.
-  if (Stage >= RS_Done || !VirtReg.isSpillable())
-    return ~0u;
-
-  // Try splitting VirtReg or interferences.
-  unsigned PhysReg = trySplit(VirtReg, Order, NewVRegs);
-  if (PhysReg || !NewVRegs.empty())
-    return PhysReg;
-
   // Finally spill VirtReg itself.
   NamedRegionTimer T("Spiller", TimerGroupName, TimePassesIsEnabled);
   LiveRangeEdit LRE(&VirtReg, NewVRegs, *MF, *LIS, VRM, this);
@@ -1787,10 +1850,13 @@ bool RAGreedy::runOnMachineFunction(MachineFunction &mf) {
   ExtraRegInfo.clear();
   ExtraRegInfo.resize(MRI->getNumVirtRegs());
   NextCascade = 1;
+  Tier = BT_Full;
+  Work = 0;
   IntfCache.init(MF, Matrix->getLiveUnions(), Indexes, LIS, TRI);
   GlobalCand.resize(32);  // This will grow as needed.
 
   allocatePhysRegs();
+  IntfCache.finish();
   releaseMemory();
   return true;
 }
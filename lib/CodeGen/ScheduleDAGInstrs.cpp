@@ -17,6 +17,7 @@
 #include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallSet.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/Analysis/ValueTracking.h"
 #include "llvm/CodeGen/LiveIntervalAnalysis.h"
@@ -38,10 +39,22 @@
 #include "llvm/Target/TargetSubtargetInfo.h"
 using namespace llvm;
 
+STATISTIC(NumMemDeps,     "Number of memory dependence edges");
+STATISTIC(NumMemBarriers, "Number of barriers inserted to cap memory tracking");
+
 static cl::opt<bool> EnableAASchedMI("enable-aa-sched-mi", cl::Hidden,
     cl::ZeroOrMore, cl::init(false),
     cl::desc("Enable use of AA during MI GAD construction"));
 
+// Every memory operation is checked against the memory operations tracked
+// below it, so long blocks of memory operations make DAG construction
+// quadratic. Once more than this many are tracked, the current one becomes a
+// barrier for all of them and tracking starts over.
+static cl::opt<unsigned> MemDepsLimit("sched-mem-deps-limit", cl::Hidden,
+    cl::init(512),
+    cl::desc("Number of memory operations tracked while building the "
+             "scheduling DAG before a barrier is inserted"));
+
 ScheduleDAGInstrs::ScheduleDAGInstrs(MachineFunction &mf,
                                      const MachineLoopInfo &mli,
                                      const MachineDominatorTree &mdt,
@@ -546,6 +559,12 @@ static bool MIsNeedChainEdge(AliasAnalysis *AA, const MachineFrameInfo *MFI,
   return (AAResult != AliasAnalysis::NoAlias);
 }
 
+/// addMemDep - Add a memory ordering edge to SUb and count it.
+static inline void addMemDep(SUnit *SUb, const SDep &Dep) {
+  if (SUb->addPred(Dep))
+    ++NumMemDeps;
+}
+
 /// This recursive function iterates over chain deps of SUb looking for
 /// "latest" node that needs a chain edge to SUa.
 static unsigned
@@ -577,7 +596,7 @@ iterateChainSucc(AliasAnalysis *AA, const MachineFrameInfo *MFI,
   // and stop descending.
   if (*Depth > 200 ||
       MIsNeedChainEdge(AA, MFI, SUa->getInstr(), SUb->getInstr())) {
-    SUb->addPred(SDep(SUa, SDep::MayAliasMem));
+    addMemDep(SUb, SDep(SUa, SDep::MayAliasMem));
     return *Depth;
   }
   // Track current depth.
@@ -610,7 +629,7 @@ static void adjustChainDeps(AliasAnalysis *AA, const MachineFrameInfo *MFI,
     if (MIsNeedChainEdge(AA, MFI, SU->getInstr(), (*I)->getInstr())) {
       SDep Dep(SU, SDep::MayAliasMem);
       Dep.setLatency(((*I)->getInstr()->mayLoad()) ? LatencyToLoad : 0);
-      (*I)->addPred(Dep);
+      addMemDep(*I, Dep);
     }
     // Now go through all the chain successors and iterate from them.
     // Keep track of visited nodes.
@@ -636,7 +655,7 @@ void addChainDependency (AliasAnalysis *AA, const MachineFrameInfo *MFI,
       MIsNeedChainEdge(AA, MFI, SUa->getInstr(), SUb->getInstr())) {
     SDep Dep(SUa, isNormalMemory ? SDep::MayAliasMem : SDep::Barrier);
     Dep.setLatency(TrueMemOrderLatency);
-    SUb->addPred(Dep);
+    addMemDep(SUb, Dep);
   }
   else {
     // Duplicate entries should be ignored.
@@ -647,6 +666,35 @@ void addChainDependency (AliasAnalysis *AA, const MachineFrameInfo *MFI,
   }
 }
 
+/// Make every node tracked in a memory def map depend on the barrier SU.
+static void addBarrierDeps(SUnit *SU, MapVector<const Value *, SUnit *> &Map,
+                           unsigned Latency) {
+  for (MapVector<const Value *, SUnit *>::iterator I = Map.begin(),
+         E = Map.end(); I != E; ++I) {
+    if (I->second == SU)
+      continue;
+    SDep Dep(SU, SDep::Barrier);
+    Dep.setLatency(Latency);
+    addMemDep(I->second, Dep);
+  }
+}
+
+/// Make every node tracked in a memory use map depend on the barrier SU.
+static void addBarrierDeps(SUnit *SU,
+                           MapVector<const Value *, std::vector<SUnit *> > &Map,
+                           unsigned Latency) {
+  for (MapVector<const Value *, std::vector<SUnit *> >::iterator
+         I = Map.begin(), E = Map.end(); I != E; ++I) {
+    for (unsigned i = 0, e = I->second.size(); i != e; ++i) {
+      if (I->second[i] == SU)
+        continue;
+      SDep Dep(SU, SDep::Barrier);
+      Dep.setLatency(Latency);
+      addMemDep(I->second[i], Dep);
+    }
+  }
+}
+
 /// Create an SUnit for each real instruction, numbered in top-down toplological
 /// order. The instruction order A < B, implies that no edge exists from B to A.
 ///
@@ -700,6 +748,9 @@ void ScheduleDAGInstrs::buildSchedGraph(AliasAnalysis *AA,
   MapVector<const Value *, SUnit *> AliasMemDefs, NonAliasMemDefs;
   MapVector<const Value *, std::vector<SUnit *> > AliasMemUses, NonAliasMemUses;
   std::set<SUnit*> RejectMemNodes;
+  // Number of nodes in the may-alias and no-alias maps (and PendingLoads),
+  // checked against MemDepsLimit.
+  unsigned NumAliasMemNodes = 0, NumNonAliasMemNodes = 0;
 
   // Remove any stale debug info; sometimes BuildSchedGraph is called again
   // without emitting the info from the previous call.
@@ -794,19 +845,19 @@ void ScheduleDAGInstrs::buildSchedGraph(AliasAnalysis *AA,
       // references, even those that are known to not alias.
       for (MapVector<const Value *, SUnit *>::iterator I =
              NonAliasMemDefs.begin(), E = NonAliasMemDefs.end(); I != E; ++I) {
-        I->second->addPred(SDep(SU, SDep::Barrier));
+        addMemDep(I->second, SDep(SU, SDep::Barrier));
       }
       for (MapVector<const Value *, std::vector<SUnit *> >::iterator I =
              NonAliasMemUses.begin(), E = NonAliasMemUses.end(); I != E; ++I) {
         for (unsigned i = 0, e = I->second.size(); i != e; ++i) {
           SDep Dep(SU, SDep::Barrier);
           Dep.setLatency(TrueMemOrderLatency);
-          I->second[i]->addPred(Dep);
+          addMemDep(I->second[i], Dep);
         }
       }
       // Add SU to the barrier chain.
       if (BarrierChain)
-        BarrierChain->addPred(SDep(SU, SDep::Barrier));
+        addMemDep(BarrierChain, SDep(SU, SDep::Barrier));
       BarrierChain = SU;
       // This is a barrier event that acts as a pivotal node in the DAG,
       // so it is safe to clear list of exposed nodes.
@@ -815,6 +866,7 @@ void ScheduleDAGInstrs::buildSchedGraph(AliasAnalysis *AA,
       RejectMemNodes.clear();
       NonAliasMemDefs.clear();
       NonAliasMemUses.clear();
+      NumNonAliasMemNodes = 0;
 
       // fall-through
     new_alias_chain:
@@ -844,6 +896,7 @@ void ScheduleDAGInstrs::buildSchedGraph(AliasAnalysis *AA,
       PendingLoads.clear();
       AliasMemDefs.clear();
       AliasMemUses.clear();
+      NumAliasMemNodes = 0;
     } else if (MI->mayStore()) {
       SmallVector<std::pair<const Value *, bool>, 4> Objs;
       getUnderlyingObjectsForInstr(MI, MFI, Objs);
@@ -872,10 +925,13 @@ void ScheduleDAGInstrs::buildSchedGraph(AliasAnalysis *AA,
           addChainDependency(AA, MFI, SU, I->second, RejectMemNodes, 0, true);
           I->second = SU;
         } else {
-          if (ThisMayAlias)
+          if (ThisMayAlias) {
             AliasMemDefs[V] = SU;
-          else
+            ++NumAliasMemNodes;
+          } else {
             NonAliasMemDefs[V] = SU;
+            ++NumNonAliasMemNodes;
+          }
         }
         // Handle the uses in MemUses, if there are any.
         MapVector<const Value *, std::vector<SUnit *> >::iterator J =
@@ -886,6 +942,8 @@ void ScheduleDAGInstrs::buildSchedGraph(AliasAnalysis *AA,
           for (unsigned i = 0, e = J->second.size(); i != e; ++i)
             addChainDependency(AA, MFI, SU, J->second[i], RejectMemNodes,
                                TrueMemOrderLatency, true);
+          (ThisMayAlias ? NumAliasMemNodes : NumNonAliasMemNodes) -=
+            J->second.size();
           J->second.clear();
         }
       }
@@ -908,7 +966,7 @@ void ScheduleDAGInstrs::buildSchedGraph(AliasAnalysis *AA,
       // SU and barrier _could_ be reordered, they should not. In addition,
       // we have lost all RejectMemNodes below barrier.
       if (BarrierChain)
-        BarrierChain->addPred(SDep(SU, SDep::Barrier));
+        addMemDep(BarrierChain, SDep(SU, SDep::Barrier));
 
       if (!ExitSU.isPred(SU))
         // Push store's up a bit to avoid them getting in between cmp
@@ -930,6 +988,7 @@ void ScheduleDAGInstrs::buildSchedGraph(AliasAnalysis *AA,
             addChainDependency(AA, MFI, SU, I->second, RejectMemNodes);
 
           PendingLoads.push_back(SU);
+          ++NumAliasMemNodes;
           MayAlias = true;
         } else {
           MayAlias = false;
@@ -950,10 +1009,13 @@ void ScheduleDAGInstrs::buildSchedGraph(AliasAnalysis *AA,
             ((ThisMayAlias) ? AliasMemDefs.end() : NonAliasMemDefs.end());
           if (I != IE)
             addChainDependency(AA, MFI, SU, I->second, RejectMemNodes, 0, true);
-          if (ThisMayAlias)
+          if (ThisMayAlias) {
             AliasMemUses[V].push_back(SU);
-          else
+            ++NumAliasMemNodes;
+          } else {
             NonAliasMemUses[V].push_back(SU);
+            ++NumNonAliasMemNodes;
+          }
         }
         if (MayAlias)
           adjustChainDeps(AA, MFI, SU, &ExitSU, RejectMemNodes, /*Latency=*/0);
@@ -961,9 +1023,43 @@ void ScheduleDAGInstrs::buildSchedGraph(AliasAnalysis *AA,
         if (MayAlias && AliasChain)
           addChainDependency(AA, MFI, SU, AliasChain, RejectMemNodes);
         if (BarrierChain)
-          BarrierChain->addPred(SDep(SU, SDep::Barrier));
+          addMemDep(BarrierChain, SDep(SU, SDep::Barrier));
       }
     }
+
+    // Too many memory operations are being tracked: make SU a barrier for all
+    // of them so that the operations above it only need an edge to SU.
+    if (NumAliasMemNodes + NumNonAliasMemNodes > MemDepsLimit) {
+      DEBUG(dbgs() << "Memory tracking limit reached at SU(" << SU->NodeNum
+            << ")\n");
+      ++NumMemBarriers;
+      addBarrierDeps(SU, AliasMemDefs, 0);
+      addBarrierDeps(SU, NonAliasMemDefs, 0);
+      addBarrierDeps(SU, AliasMemUses, TrueMemOrderLatency);
+      addBarrierDeps(SU, NonAliasMemUses, TrueMemOrderLatency);
+      for (unsigned k = 0, m = PendingLoads.size(); k != m; ++k) {
+        if (PendingLoads[k] == SU)
+          continue;
+        SDep Dep(SU, SDep::Barrier);
+        Dep.setLatency(TrueMemOrderLatency);
+        addMemDep(PendingLoads[k], Dep);
+      }
+      if (AliasChain && AliasChain != SU)
+        addMemDep(AliasChain, SDep(SU, SDep::Barrier));
+      if (BarrierChain && BarrierChain != SU)
+        addMemDep(BarrierChain, SDep(SU, SDep::Barrier));
+      BarrierChain = SU;
+      AliasChain = 0;
+      adjustChainDeps(AA, MFI, SU, &ExitSU, RejectMemNodes,
+                      TrueMemOrderLatency);
+      RejectMemNodes.clear();
+      PendingLoads.clear();
+      AliasMemDefs.clear();
+      AliasMemUses.clear();
+      NonAliasMemDefs.clear();
+      NonAliasMemUses.clear();
+      NumAliasMemNodes = NumNonAliasMemNodes = 0;
+    }
   }
   if (DbgMI)
     FirstDbgValue = DbgMI;
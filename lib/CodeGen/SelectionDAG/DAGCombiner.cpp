@@ -18,6 +18,7 @@
 
 #define DEBUG_TYPE "dagcombine"
 #include "llvm/CodeGen/SelectionDAG.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/Analysis/AliasAnalysis.h"
@@ -30,12 +31,14 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetLowering.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Target/TargetOptions.h"
 #include <algorithm>
+#include <map>
 using namespace llvm;
 
 STATISTIC(NodesCombined   , "Number of dag nodes combined");
@@ -53,6 +56,17 @@ namespace {
     CombinerGlobalAA("combiner-global-alias-analysis", cl::Hidden,
                cl::desc("Include global information in alias analysis"));
 
+  static cl::opt<bool>
+    CombinerStats("dag-combine-stats", cl::Hidden,
+               cl::desc("Print the number of nodes visited and combined per "
+                        "opcode after each DAG combine"));
+
+  static cl::opt<bool>
+    CombinerTopological("combiner-topological-order", cl::Hidden,
+               cl::init(false),
+               cl::desc("Seed the DAG combine worklist so that operands are "
+                        "visited before their users (experimental)"));
+
 //------------------------------ DAGCombiner ---------------------------------//
 
   class DAGCombiner {
@@ -70,18 +84,30 @@ namespace {
     // also only appear once. The naive approach to this takes
     // linear time.
     //
-    // To reduce the insert/remove time to logarithmic, we use
-    // a set and a vector to maintain our worklist.
-    //
-    // The set contains the items on the worklist, but does not
-    // maintain the order they should be visited.
-    //
-    // The vector maintains the order nodes should be visited, but may
-    // contain duplicate or removed nodes. When choosing a node to
-    // visit, we pop off the order stack until we find an item that is
-    // also in the contents set. All operations are O(log N).
-    SmallPtrSet<SDNode*, 64> WorkListContents;
-    SmallVector<SDNode*, 64> WorkListOrder;
+    // Instead, the vector holds the nodes in the order they should be
+    // visited, last first, and the map holds the position of each node on the
+    // worklist. Adding a node that is already on the worklist clears its old
+    // slot before pushing it again, and removing a node clears its slot.
+    // Cleared slots are skipped when choosing a node to visit, and squeezed
+    // out once they make up most of the vector, so each node is on the vector
+    // at most once and all operations take constant time.
+    SmallVector<SDNode*, 64> WorkList;
+    DenseMap<SDNode*, unsigned> WorkListMap;
+
+    /// compactWorkList - Squeeze the cleared slots out of the worklist.
+    void compactWorkList();
+
+    /// Visits and combines of each opcode in the current run, used for
+    /// -dag-combine-stats.
+    struct OpcodeStats {
+      std::string Name;
+      unsigned Visits;
+      unsigned Combined;
+      OpcodeStats() : Visits(0), Combined(0) {}
+    };
+    std::map<unsigned, OpcodeStats> CombineStats;
+
+    void printCombineStats();
 
     // AA - Used for DAG load/store alias analysis.
     AliasAnalysis &AA;
@@ -104,14 +130,28 @@ namespace {
     /// AddToWorkList - Add to the work list making sure its instance is at the
     /// back (next to be processed.)
     void AddToWorkList(SDNode *N) {
-      WorkListContents.insert(N);
-      WorkListOrder.push_back(N);
+      std::pair<DenseMap<SDNode*, unsigned>::iterator, bool> IP =
+        WorkListMap.insert(std::make_pair(N, WorkList.size()));
+      if (!IP.second) {
+        // Already the next node to be processed.
+        if (IP.first->second + 1 == WorkList.size())
+          return;
+        WorkList[IP.first->second] = 0;
+        IP.first->second = WorkList.size();
+      }
+      WorkList.push_back(N);
+      if (WorkList.size() > 2 * WorkListMap.size() + 64)
+        compactWorkList();
     }
 
     /// removeFromWorkList - remove all instances of N from the worklist.
     ///
     void removeFromWorkList(SDNode *N) {
-      WorkListContents.erase(N);
+      DenseMap<SDNode*, unsigned>::iterator I = WorkListMap.find(N);
+      if (I == WorkListMap.end())
+        return;
+      WorkList[I->second] = 0;
+      WorkListMap.erase(I);
     }
 
     SDValue CombineTo(SDNode *N, const SDValue *To, unsigned NumTo,
@@ -993,16 +1033,71 @@ bool DAGCombiner::PromoteLoad(SDValue Op) {
 //  Main DAG Combiner implementation
 //===----------------------------------------------------------------------===//
 
+void DAGCombiner::compactWorkList() {
+  unsigned NewSize = 0;
+  for (unsigned i = 0, e = WorkList.size(); i != e; ++i) {
+    SDNode *N = WorkList[i];
+    if (!N)
+      continue;
+    WorkList[NewSize] = N;
+    WorkListMap[N] = NewSize++;
+  }
+  WorkList.resize(NewSize);
+}
+
+static const char *getCombineLevelName(CombineLevel Level) {
+  switch (Level) {
+  case BeforeLegalizeTypes:    return "before type legalization";
+  case AfterLegalizeTypes:     return "after type legalization";
+  case AfterLegalizeVectorOps: return "after vector op legalization";
+  case AfterLegalizeDAG:       return "after DAG legalization";
+  }
+  llvm_unreachable("Unknown combine level");
+}
+
+void DAGCombiner::printCombineStats() {
+  // Sort the opcodes by decreasing number of visits, then by opcode.
+  std::vector<std::pair<unsigned, unsigned> > Sorted;
+  unsigned TotalVisits = 0, TotalCombined = 0;
+  for (std::map<unsigned, OpcodeStats>::const_iterator I = CombineStats.begin(),
+       E = CombineStats.end(); I != E; ++I) {
+    Sorted.push_back(std::make_pair(~I->second.Visits, I->first));
+    TotalVisits += I->second.Visits;
+    TotalCombined += I->second.Combined;
+  }
+  std::sort(Sorted.begin(), Sorted.end());
+
+  errs() << "DAG combine of '" << DAG.getMachineFunction().getName()
+         << "' " << getCombineLevelName(Level) << ": " << TotalVisits
+         << " visits, " << TotalCombined << " combined\n";
+  for (unsigned i = 0, e = Sorted.size(); i != e; ++i) {
+    const OpcodeStats &S = CombineStats[Sorted[i].second];
+    errs() << format("%10u %10u  ", S.Visits, S.Combined) << S.Name << '\n';
+  }
+  CombineStats.clear();
+}
+
 void DAGCombiner::Run(CombineLevel AtLevel) {
   // set the instance variables, so that the various visit routines may use it.
   Level = AtLevel;
   LegalOperations = Level >= AfterLegalizeVectorOps;
   LegalTypes = Level >= AfterLegalizeTypes;
 
-  // Add all the dag nodes to the worklist.
-  for (SelectionDAG::allnodes_iterator I = DAG.allnodes_begin(),
-       E = DAG.allnodes_end(); I != E; ++I)
-    AddToWorkList(I);
+  // Add all the dag nodes to the worklist.  The last node added is visited
+  // first, so -combiner-topological-order adds them in reverse topological
+  // order to combine operands before their users.  That is not the default:
+  // it doesn't save visits, and many combines (rotates, bswaps, ...) match a
+  // user before its operands have been simplified.
+  if (CombinerTopological) {
+    DAG.AssignTopologicalOrder();
+    for (SelectionDAG::allnodes_iterator I = DAG.allnodes_end(),
+         B = DAG.allnodes_begin(); I != B;)
+      AddToWorkList(--I);
+  } else {
+    for (SelectionDAG::allnodes_iterator I = DAG.allnodes_begin(),
+         E = DAG.allnodes_end(); I != E; ++I)
+      AddToWorkList(I);
+  }
 
   // Create a dummy node (which is not added to allnodes), that adds a reference
   // to the root node, preventing it from being deleted, and tracking any
@@ -1015,15 +1110,13 @@ void DAGCombiner::Run(CombineLevel AtLevel) {
 
   // while the worklist isn't empty, find a node and
   // try and combine it.
-  while (!WorkListContents.empty()) {
+  while (!WorkListMap.empty()) {
     SDNode *N;
-    // The WorkListOrder holds the SDNodes in order, but it may contain duplicates.
-    // In order to avoid a linear scan, we use a set (O(log N)) to hold what the
-    // worklist *should* contain, and check the node we want to visit is should
-    // actually be visited.
+    // Skip the slots of nodes that were removed or added again.
     do {
-      N = WorkListOrder.pop_back_val();
-    } while (!WorkListContents.erase(N));
+      N = WorkList.pop_back_val();
+    } while (!N);
+    WorkListMap.erase(N);
 
     // If N has no uses, it is dead.  Make sure to revisit all N's operands once
     // N is deleted from the DAG, since they too may now be dead or may have a
@@ -1036,12 +1129,22 @@ void DAGCombiner::Run(CombineLevel AtLevel) {
       continue;
     }
 
+    OpcodeStats *Stats = 0;
+    if (CombinerStats) {
+      Stats = &CombineStats[N->getOpcode()];
+      if (!Stats->Visits)
+        Stats->Name = N->getOperationName(&DAG);
+      ++Stats->Visits;
+    }
+
     SDValue RV = combine(N);
 
     if (RV.getNode() == 0)
       continue;
 
     ++NodesCombined;
+    if (Stats)
+      ++Stats->Combined;
 
     // If we get back the same node we passed in, rather than a new node or
     // zero, we know that the node must have defined multiple values and
@@ -1095,6 +1198,12 @@ void DAGCombiner::Run(CombineLevel AtLevel) {
     }
   }
 
+  // Only cleared slots can be left on the worklist.
+  WorkList.clear();
+
+  if (CombinerStats)
+    printCombineStats();
+
   // If the root changed (e.g. it was a dead load, update the root).
   DAG.setRoot(Dummy.getValue());
   DAG.RemoveDeadNodes();
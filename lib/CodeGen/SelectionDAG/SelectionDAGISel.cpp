@@ -44,6 +44,7 @@
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetInstrInfo.h"
@@ -154,6 +155,11 @@ static cl::opt<bool>
 EnableFastISelAbortArgs("fast-isel-abort-args", cl::Hidden,
           cl::desc("Enable abort calls when \"fast\" instruction selection "
                    "fails to lower a formal argument"));
+static cl::opt<bool>
+EnableFastISelReport("fast-isel-report", cl::Hidden,
+          cl::desc("Print how often the \"fast\" instruction selector fell "
+                   "back to SelectionDAG, by opcode and a likely reason "
+                   "guessed from the instruction's types"));
 
 static cl::opt<bool>
 UseMBPI("use-mbpi",
@@ -283,7 +289,8 @@ SelectionDAGISel::SelectionDAGISel(TargetMachine &tm,
   SDB(new SelectionDAGBuilder(*CurDAG, *FuncInfo, OL)),
   GFI(),
   OptLevel(OL),
-  DAGSize(0) {
+  DAGSize(0),
+  NumFastISelSelected(0) {
     initializeGCModuleInfoPass(*PassRegistry::getPassRegistry());
     initializeAliasAnalysisAnalysisGroup(*PassRegistry::getPassRegistry());
     initializeBranchProbabilityInfoPass(*PassRegistry::getPassRegistry());
@@ -929,6 +936,119 @@ static void collectFailStats(const Instruction *I) {
 }
 #endif
 
+/// getFastISelMissReason - Give a likely reason for FastISel not selecting I,
+/// based on the types and operation involved.  This is a heuristic: the
+/// target's selectors do not report why they gave up, so the reason is
+/// guessed from the instruction after the fact.
+static const char *getFastISelMissReason(const Instruction *I,
+                                         const TargetLowering *TLI) {
+  if (const CallInst *CI = dyn_cast<CallInst>(I)) {
+    if (isa<InlineAsm>(CI->getCalledValue()))
+      return "inline asm";
+    if (isa<IntrinsicInst>(CI))
+      return "unsupported intrinsic";
+  }
+  if (const LoadInst *LI = dyn_cast<LoadInst>(I))
+    if (LI->isAtomic())
+      return "atomic";
+  if (const StoreInst *SI = dyn_cast<StoreInst>(I))
+    if (SI->isAtomic())
+      return "atomic";
+  if (isa<AtomicRMWInst>(I) || isa<AtomicCmpXchgInst>(I) || isa<FenceInst>(I))
+    return "atomic";
+
+  // Look at the result type and the operand types.  Switch case values are
+  // stored as constant arrays, so only the condition is interesting there.
+  unsigned NumOperands = isa<SwitchInst>(I) ? 1 : I->getNumOperands();
+  for (unsigned i = 0, e = NumOperands + 1; i != e; ++i) {
+    Type *Ty = i == 0 ? I->getType() : I->getOperand(i - 1)->getType();
+    if (Ty->isVoidTy() || Ty->isLabelTy() || Ty->isMetadataTy())
+      continue;
+    if (Ty->isVectorTy())
+      return "vector type";
+    if (Ty->isAggregateType())
+      return "aggregate type";
+    EVT VT = TLI->getValueType(Ty, /*AllowUnknown=*/true);
+    if (!VT.isSimple())
+      return "illegal type";
+    TargetLowering::LegalizeTypeAction Action =
+      TLI->getTypeAction(I->getContext(), VT);
+    if (Action != TargetLowering::TypeLegal &&
+        Action != TargetLowering::TypePromoteInteger)
+      return "illegal type";
+  }
+  return "unsupported";
+}
+
+/// recordFastISelMiss - Record that FastISel could not select I, and handed
+/// NumInstrs instructions to SelectionDAG because of it.  A null I stands for
+/// the formal arguments.
+void SelectionDAGISel::recordFastISelMiss(const Instruction *I,
+                                          unsigned NumInstrs) {
+  std::pair<std::string, std::string> Key;
+  if (!I) {
+    Key.first = "<arguments>";
+    Key.second = "unsupported";
+  } else {
+    if (const IntrinsicInst *II = dyn_cast<IntrinsicInst>(I))
+      Key.first = Intrinsic::getName(II->getIntrinsicID());
+    else
+      Key.first = I->getOpcodeName();
+    Key.second = getFastISelMissReason(I, getTargetLowering());
+  }
+  std::pair<unsigned, unsigned> &Count = FastISelMisses[Key];
+  ++Count.first;
+  Count.second += NumInstrs;
+}
+
+namespace {
+/// FastISelMissOrder - Order -fast-isel-report rows by the number of
+/// instructions handed to SelectionDAG, most first.
+struct FastISelMissOrder {
+  typedef std::pair<std::pair<std::string, std::string>,
+                    std::pair<unsigned, unsigned> > Row;
+  bool operator()(const Row &A, const Row &B) const {
+    if (A.second.second != B.second.second)
+      return A.second.second > B.second.second;
+    if (A.second.first != B.second.first)
+      return A.second.first > B.second.first;
+    return A.first < B.first;
+  }
+};
+}
+
+void SelectionDAGISel::printFastISelReport(raw_ostream &OS) {
+  std::vector<FastISelMissOrder::Row> Rows(FastISelMisses.begin(),
+                                           FastISelMisses.end());
+  std::sort(Rows.begin(), Rows.end(), FastISelMissOrder());
+
+  unsigned NumHandedOver = 0;
+  for (unsigned i = 0, e = Rows.size(); i != e; ++i)
+    NumHandedOver += Rows[i].second.second;
+  unsigned Total = NumFastISelSelected + NumHandedOver;
+
+  OS << "===" << std::string(73, '-') << "===\n"
+     << "                      FastISel Fallback Report\n"
+     << "===" << std::string(73, '-') << "===\n";
+  OS << format("  %u instructions selected by FastISel, %u handed to "
+               "SelectionDAG (%.1f%%)\n\n", NumFastISelSelected, NumHandedOver,
+               Total ? 100.0 * NumHandedOver / Total : 0.0);
+  OS << "  Misses   Instrs  Opcode                    Likely reason\n";
+  for (unsigned i = 0, e = Rows.size(); i != e; ++i)
+    OS << format("%8u %8u  %-25s ", Rows[i].second.first,
+                 Rows[i].second.second, Rows[i].first.first.c_str())
+       << Rows[i].first.second << '\n';
+}
+
+bool SelectionDAGISel::doFinalization(Module &M) {
+  if (EnableFastISelReport && TM.Options.EnableFastISel) {
+    printFastISelReport(errs());
+    FastISelMisses.clear();
+    NumFastISelSelected = 0;
+  }
+  return MachineFunctionPass::doFinalization(M);
+}
+
 void SelectionDAGISel::SelectAllBasicBlocks(const Function &Fn) {
   // Initialize the Fast-ISel state, if needed.
   FastISel *FastIS = 0;
@@ -988,6 +1108,8 @@ void SelectionDAGISel::SelectAllBasicBlocks(const Function &Fn) {
         if (!FastIS->LowerArguments()) {
           // Fast isel failed to lower these arguments
           ++NumFastIselFailLowerArguments;
+          if (EnableFastISelReport)
+            recordFastISelMiss(0, 0);
           if (EnableFastISelAbortArgs)
             llvm_unreachable("FastISel didn't lower all arguments");
 
@@ -1026,6 +1148,7 @@ void SelectionDAGISel::SelectAllBasicBlocks(const Function &Fn) {
         if (FastIS->SelectInstruction(Inst)) {
           --NumFastIselRemaining;
           ++NumFastIselSuccess;
+          ++NumFastISelSelected;
           // If fast isel succeeded, skip over all the folded instructions, and
           // then see if there is a load right before the selected instructions.
           // Try to fold the load if so.
@@ -1042,6 +1165,7 @@ void SelectionDAGISel::SelectAllBasicBlocks(const Function &Fn) {
             BI = llvm::next(BasicBlock::const_iterator(BeforeInst));
             --NumFastIselRemaining;
             ++NumFastIselSuccess;
+            ++NumFastISelSelected;
           }
           continue;
         }
@@ -1072,6 +1196,8 @@ void SelectionDAGISel::SelectAllBasicBlocks(const Function &Fn) {
           // If the call was emitted as a tail call, we're done with the block.
           // We also need to delete any previously emitted instructions.
           if (HadTailCall) {
+            if (EnableFastISelReport)
+              recordFastISelMiss(Inst, NumFastIselRemaining);
             FastIS->removeDeadCode(SavedInsertPt, FuncInfo->MBB->end());
             --BI;
             break;
@@ -1081,10 +1207,15 @@ void SelectionDAGISel::SelectAllBasicBlocks(const Function &Fn) {
           // selection may have handled the call, input args, etc.
           unsigned RemainingNow = std::distance(Begin, BI);
           NumFastIselFailures += NumFastIselRemaining - RemainingNow;
+          if (EnableFastISelReport)
+            recordFastISelMiss(Inst, NumFastIselRemaining - RemainingNow);
           NumFastIselRemaining = RemainingNow;
           continue;
         }
 
+        if (EnableFastISelReport)
+          recordFastISelMiss(Inst, NumFastIselRemaining);
+
         if (isa<TerminatorInst>(Inst) && !isa<BranchInst>(Inst)) {
           // Don't abort, and use a different message for terminator misses.
           NumFastIselFailures += NumFastIselRemaining;
@@ -40,6 +40,7 @@
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SparseBitVector.h"
 #include "llvm/ADT/Statistic.h"
+#include "llvm/CodeGen/MachineBlockFrequencyInfo.h"
 #include "llvm/CodeGen/MachineDominators.h"
 #include "llvm/CodeGen/MachineFrameInfo.h"
 #include "llvm/CodeGen/MachineInstr.h"
@@ -90,6 +91,8 @@ void PEI::getAnalysisUsage(AnalysisUsage &AU) const {
     AU.addRequired<MachineLoopInfo>();
     AU.addRequired<MachineDominatorTree>();
   }
+  if (CompactFrame)
+    AU.addRequired<MachineBlockFrequencyInfo>();
   AU.addPreserved<MachineLoopInfo>();
   AU.addPreserved<MachineDominatorTree>();
   AU.addRequired<TargetPassConfig>();
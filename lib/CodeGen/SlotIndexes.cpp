@@ -12,7 +12,10 @@
 #include "llvm/CodeGen/SlotIndexes.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/CodeGen/MachineFunction.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetInstrInfo.h"
 
@@ -25,6 +28,15 @@ INITIALIZE_PASS(SlotIndexes, "slotindexes",
 STATISTIC(NumLocalRenum,  "Number of local renumberings");
 STATISTIC(NumGlobalRenum, "Number of global renumberings");
 
+static cl::opt<unsigned> QueryBenchmark("slotindexes-benchmark", cl::Hidden,
+  cl::init(0), cl::value_desc("rounds"),
+  cl::desc("Time the common SlotIndexes queries on every function and print "
+           "one comma-separated record per query"));
+
+// Query results of -slotindexes-benchmark end up here so they are not
+// optimized away.
+static volatile unsigned QueryBenchmarkSink;
+
 void SlotIndexes::getAnalysisUsage(AnalysisUsage &au) const {
   au.setPreservesAll();
   MachineFunctionPass::getAnalysisUsage(au);
@@ -66,7 +78,7 @@ bool SlotIndexes::runOnMachineFunction(MachineFunction &fn) {
   MBBRanges.resize(mf->getNumBlockIDs());
   idx2MBBMap.reserve(mf->size());
 
-  indexList.push_back(createEntry(0, index));
+  indexList.push_back(createEntry(0, index, 0));
 
   // Iterate over the function.
   for (MachineFunction::iterator mbbItr = mf->begin(), mbbEnd = mf->end();
@@ -75,6 +87,7 @@ bool SlotIndexes::runOnMachineFunction(MachineFunction &fn) {
 
     // Insert an index for the MBB start.
     SlotIndex blockStartIndex(&indexList.back(), SlotIndex::Slot_Block);
+    indexList.back().setMBB(mbb);
 
     for (MachineBasicBlock::iterator miItr = mbb->begin(), miEnd = mbb->end();
          miItr != miEnd; ++miItr) {
@@ -83,7 +96,7 @@ bool SlotIndexes::runOnMachineFunction(MachineFunction &fn) {
         continue;
 
       // Insert a store index for the instr.
-      indexList.push_back(createEntry(mi, index += SlotIndex::InstrDist));
+      indexList.push_back(createEntry(mi, index += SlotIndex::InstrDist, mbb));
 
       // Save this base index in the maps.
       mi2iMap.insert(std::make_pair(mi, SlotIndex(&indexList.back(),
@@ -91,7 +104,7 @@ bool SlotIndexes::runOnMachineFunction(MachineFunction &fn) {
     }
 
     // We insert one blank instructions between basic blocks.
-    indexList.push_back(createEntry(0, index += SlotIndex::InstrDist));
+    indexList.push_back(createEntry(0, index += SlotIndex::InstrDist, 0));
 
     MBBRanges[mbb->getNumber()].first = blockStartIndex;
     MBBRanges[mbb->getNumber()].second = SlotIndex(&indexList.back(),
@@ -104,10 +117,95 @@ bool SlotIndexes::runOnMachineFunction(MachineFunction &fn) {
 
   DEBUG(mf->print(dbgs(), this));
 
+  if (QueryBenchmark)
+    runQueryBenchmark(QueryBenchmark);
+
   // And we're done!
   return false;
 }
 
+namespace {
+/// Times one kind of query for -slotindexes-benchmark.
+class QueryTimer {
+  const char *Query;
+  const MachineFunction &MF;
+  unsigned Count;
+  TimeRecord Time;
+
+public:
+  QueryTimer(const char *Query, const MachineFunction &MF)
+    : Query(Query), MF(MF), Count(0) {
+    Time -= TimeRecord::getCurrentTime(true);
+  }
+
+  void count(unsigned N) { Count += N; }
+
+  /// Print function,query,queries,nanoseconds per query.
+  ~QueryTimer() {
+    Time += TimeRecord::getCurrentTime(false);
+    double NS = Count ? Time.getWallTime() * 1e9 / Count : 0;
+    errs() << "slotindexes," << MF.getName() << ',' << Query << ',' << Count
+           << ',' << format("%.2f", NS) << '\n';
+  }
+};
+} // end anonymous namespace
+
+/// runQueryBenchmark - Run the queries that LiveIntervals, SplitKit and the
+/// register allocators make most often against every instruction, block and
+/// index in the function.
+void SlotIndexes::runQueryBenchmark(unsigned Rounds) const {
+  unsigned Sink = 0;
+
+  {
+    QueryTimer T("getInstructionIndex", *mf);
+    for (unsigned R = 0; R != Rounds; ++R)
+      for (Mi2IndexMap::const_iterator I = mi2iMap.begin(), E = mi2iMap.end();
+           I != E; ++I) {
+        Sink += getInstructionIndex(I->first).getIndex();
+        T.count(1);
+      }
+  }
+  {
+    QueryTimer T("getInstructionFromIndex", *mf);
+    for (unsigned R = 0; R != Rounds; ++R)
+      for (IndexList::const_iterator I = indexList.begin(),
+             E = indexList.end(); I != E; ++I) {
+        SlotIndex Idx(const_cast<IndexListEntry*>(&*I), SlotIndex::Slot_Block);
+        Sink += getInstructionFromIndex(Idx) != 0;
+        T.count(1);
+      }
+  }
+  {
+    QueryTimer T("getMBBFromIndex", *mf);
+    for (unsigned R = 0; R != Rounds; ++R)
+      for (IndexList::const_iterator I = indexList.begin(),
+             E = prior(indexList.end()); I != E; ++I) {
+        SlotIndex Idx(const_cast<IndexListEntry*>(&*I), SlotIndex::Slot_Block);
+        Sink += getMBBFromIndex(Idx)->getNumber();
+        T.count(1);
+      }
+  }
+  {
+    QueryTimer T("getMBBRange", *mf);
+    for (unsigned R = 0; R != Rounds; ++R)
+      for (MachineFunction::const_iterator I = mf->begin(), E = mf->end();
+           I != E; ++I) {
+        Sink += getMBBStartIdx(I).getIndex() + getMBBEndIdx(I).getIndex();
+        T.count(1);
+      }
+  }
+  {
+    QueryTimer T("getIndexBefore", *mf);
+    for (unsigned R = 0; R != Rounds; ++R)
+      for (Mi2IndexMap::const_iterator I = mi2iMap.begin(), E = mi2iMap.end();
+           I != E; ++I) {
+        Sink += getIndexBefore(I->first).getIndex();
+        T.count(1);
+      }
+  }
+  QueryBenchmarkSink = Sink;
+}
+
 void SlotIndexes::renumberIndexes() {
   // Renumber updates the index of every element of the index list.
   DEBUG(dbgs() << "\n*** Renumbering SlotIndexes ***\n");
@@ -238,10 +238,32 @@ DWARFCompileUnit::buildAddressRangeTable(DWARFDebugAranges *debug_aranges,
                                          bool clear_dies_if_already_not_parsed){
   // This function is usually called if there in no .debug_aranges section
   // in order to produce a compile unit level set of address ranges that
-  // is accurate. If the DIEs weren't parsed, then we don't want all dies for
-  // all compile units to stay loaded when they weren't needed. So we can end
-  // up parsing the DWARF and then throwing them all away to keep memory usage
-  // down.
+  // is accurate. If the compile unit DIE describes the ranges of the whole
+  // unit, use them, so that the other DIEs don't need to be parsed at all.
+  if (const DWARFDebugInfoEntryMinimal *CUDie = getCompileUnitDIE()) {
+    uint64_t LowPC, HighPC;
+    if (CUDie->getLowAndHighPC(this, LowPC, HighPC) && LowPC < HighPC) {
+      debug_aranges->appendRange(getOffset(), LowPC, HighPC);
+      return;
+    }
+    uint32_t RangesOffset =
+      CUDie->getAttributeValueAsReference(this, DW_AT_ranges, -1U);
+    DWARFDebugRangeList RangeList;
+    if (RangesOffset != -1U && extractRangeList(RangesOffset, RangeList)) {
+      std::vector<std::pair<uint64_t, uint64_t> > Ranges;
+      RangeList.getAbsoluteRanges(getBaseAddress(), Ranges);
+      for (size_t i = 0, e = Ranges.size(); i != e; ++i)
+        debug_aranges->appendRange(getOffset(), Ranges[i].first,
+                                   Ranges[i].second);
+      if (!Ranges.empty())
+        return;
+    }
+  }
+
+  // Otherwise collect the ranges of the subprograms. If the DIEs weren't
+  // parsed, then we don't want all dies for all compile units to stay loaded
+  // when they weren't needed. So we can end up parsing the DWARF and then
+  // throwing them all away to keep memory usage down.
   const bool clear_dies = extractDIEsIfNeeded(false) > 1 &&
                           clear_dies_if_already_not_parsed;
   DieArray[0].buildAddressRangeTable(this, debug_aranges);
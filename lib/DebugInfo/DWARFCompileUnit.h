@@ -129,6 +129,19 @@ public:
 
   void clearDIEs(bool keep_compile_unit_die);
 
+  /// hasAllDIEs - Returns true if all DIEs of the compile unit, rather than
+  /// just the compile unit DIE, have been extracted.
+  bool hasAllDIEs() const { return DieArray.size() > 1; }
+
+  /// getDIEMemoryUsage - Returns the number of bytes taken by the extracted
+  /// DIEs.
+  size_t getDIEMemoryUsage() const {
+    return DieArray.capacity() * sizeof(DWARFDebugInfoEntryMinimal);
+  }
+
+  /// buildAddressRangeTable - Adds the address ranges of the compile unit to
+  /// debug_aranges. The ranges are taken from the compile unit DIE if it has
+  /// them, and computed from the subprogram DIEs otherwise.
   void buildAddressRangeTable(DWARFDebugAranges *debug_aranges,
                               bool clear_dies_if_already_not_parsed);
 
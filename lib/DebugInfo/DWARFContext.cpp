@@ -316,7 +316,36 @@ DWARFCompileUnit *DWARFContext::getCompileUnitForAddress(uint64_t Address) {
   // First, get the offset of the compile unit.
   uint32_t CUOffset = getDebugAranges()->findAddress(Address);
   // Retrieve the compile unit.
-  return getCompileUnitForOffset(CUOffset);
+  DWARFCompileUnit *CU = getCompileUnitForOffset(CUOffset);
+  if (CU)
+    touchCompileUnit(CU);
+  return CU;
+}
+
+void DWARFContext::touchCompileUnit(DWARFCompileUnit *CU) {
+  if (MemoryBudget == 0)
+    return;
+
+  // Only the DIEs of the units used by earlier lookups are freed here, the
+  // caller is about to use the ones of CU.
+  std::vector<DWARFCompileUnit *>::iterator I =
+    std::find(LookupCUs.begin(), LookupCUs.end(), CU);
+  if (I != LookupCUs.end())
+    LookupCUs.erase(I);
+
+  uint64_t Usage = CU->getDIEMemoryUsage();
+  for (unsigned i = 0, e = LookupCUs.size(); i != e; ++i)
+    Usage += LookupCUs[i]->getDIEMemoryUsage();
+
+  unsigned NumFreed = 0;
+  while (Usage > MemoryBudget && NumFreed != LookupCUs.size()) {
+    DWARFCompileUnit *LRU = LookupCUs[NumFreed++];
+    Usage -= LRU->getDIEMemoryUsage();
+    LRU->clearDIEs(true);
+    Usage += LRU->getDIEMemoryUsage();
+  }
+  LookupCUs.erase(LookupCUs.begin(), LookupCUs.begin() + NumFreed);
+  LookupCUs.push_back(CU);
 }
 
 static bool getFileNameForCompileUnit(DWARFCompileUnit *CU,
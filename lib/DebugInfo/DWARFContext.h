@@ -37,6 +37,13 @@ class DWARFContext : public DIContext {
   SmallVector<DWARFCompileUnit, 1> DWOCUs;
   OwningPtr<DWARFDebugAbbrev> AbbrevDWO;
 
+  /// The compile units whose DIEs were extracted for address lookups, least
+  /// recently used first.
+  std::vector<DWARFCompileUnit *> LookupCUs;
+  /// The number of bytes of DIEs kept alive for address lookups, or 0 if
+  /// there's no limit.
+  uint64_t MemoryBudget;
+
   DWARFContext(DWARFContext &) LLVM_DELETED_FUNCTION;
   DWARFContext &operator=(DWARFContext &) LLVM_DELETED_FUNCTION;
 
@@ -48,9 +55,11 @@ class DWARFContext : public DIContext {
   void parseDWOCompileUnits();
 
 public:
-  DWARFContext() {}
+  DWARFContext() : MemoryBudget(0) {}
   virtual void dump(raw_ostream &OS, DIDumpType DumpType = DIDT_All);
 
+  virtual void setMemoryBudget(uint64_t Bytes) { MemoryBudget = Bytes; }
+
   /// Get the number of compile units in this context.
   unsigned getNumCompileUnits() {
     if (CUs.empty())
@@ -139,6 +148,11 @@ private:
   /// Return the compile unit which contains instruction with provided
   /// address.
   DWARFCompileUnit *getCompileUnitForAddress(uint64_t Address);
+
+  /// Mark CU as the most recently used compile unit for address lookups, and
+  /// free the DIEs of the least recently used ones while the memory budget
+  /// is exceeded.
+  void touchCompileUnit(DWARFCompileUnit *CU);
 };
 
 /// DWARFContextInMemory is the simplest possible implementation of a
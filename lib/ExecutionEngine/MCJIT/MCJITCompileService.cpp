@@ -0,0 +1,148 @@
+//===-- MCJITCompileService.cpp - Parallel MCJIT compilation --------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the MCJITCompileService class.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ExecutionEngine/MCJITCompileService.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ExecutionEngine/ExecutionEngine.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/MutexGuard.h"
+#include "llvm/Support/Threading.h"
+
+using namespace llvm;
+
+MCJITCompileService::MCJITCompileService(unsigned NumThreads,
+                                         CodeGenOpt::Level OptLevel)
+  : NumThreads(NumThreads ? NumThreads : 1), OptLevel(OptLevel),
+    FirstPending(0) {
+}
+
+MCJITCompileService::~MCJITCompileService() {
+  for (unsigned i = 0, e = Jobs.size(); i != e; ++i) {
+    // An engine owns its module; modules that never got one are still ours.
+    if (Jobs[i]->EE)
+      delete Jobs[i]->EE;
+    else
+      delete Jobs[i]->M;
+    delete Jobs[i];
+  }
+}
+
+MCJITCompileService::Ticket
+MCJITCompileService::addModule(Module *M, StringRef FunctionName) {
+  Job *J = new Job();
+  J->M = M;
+  J->FunctionName = FunctionName;
+  J->EE = 0;
+  J->Address = 0;
+  J->Compiled = false;
+  MutexGuard Locked(Lock);
+  Jobs.push_back(J);
+  return Jobs.size() - 1;
+}
+
+bool MCJITCompileService::isCompiled(Ticket T) const {
+  MutexGuard Locked(Lock);
+  return Jobs[T]->Compiled;
+}
+
+void *MCJITCompileService::getFunctionAddress(Ticket T) const {
+  MutexGuard Locked(Lock);
+  const Job &J = *Jobs[T];
+  return J.Compiled ? J.Address : 0;
+}
+
+std::string MCJITCompileService::getErrorMessage(Ticket T) const {
+  MutexGuard Locked(Lock);
+  const Job &J = *Jobs[T];
+  return J.Compiled ? J.ErrMsg : std::string();
+}
+
+ExecutionEngine *MCJITCompileService::getExecutionEngine(Ticket T) const {
+  MutexGuard Locked(Lock);
+  const Job &J = *Jobs[T];
+  return J.Compiled ? J.EE : 0;
+}
+
+/// compileJob - Create an engine for J's module, compile and finalize it.
+/// Several of these run at the same time, so this must only touch J and
+/// state owned by J's LLVMContext.
+void MCJITCompileService::compileJob(Job &J, CodeGenOpt::Level OptLevel) {
+  Function *F = J.M->getFunction(J.FunctionName);
+  if (!F || F->isDeclaration()) {
+    J.ErrMsg = "function '" + J.FunctionName + "' is not defined";
+    return;
+  }
+
+  EngineBuilder EB(J.M);
+  EB.setEngineKind(EngineKind::JIT)
+    .setUseMCJIT(true)
+    .setErrorStr(&J.ErrMsg)
+    .setOptLevel(OptLevel);
+  J.EE = EB.create();
+  if (!J.EE) {
+    if (J.ErrMsg.empty())
+      J.ErrMsg = "could not create an MCJIT execution engine";
+    return;
+  }
+
+  J.Address = J.EE->getPointerToFunction(F);
+  J.EE->finalizeObject();
+}
+
+void MCJITCompileService::compileJobGroup(void *Group) {
+  JobGroup &G = *static_cast<JobGroup*>(Group);
+  for (unsigned i = 0, e = G.Jobs.size(); i != e; ++i)
+    compileJob(*G.Jobs[i], G.OptLevel);
+}
+
+void MCJITCompileService::compilePending() {
+  MutexGuard Compiling(CompileLock);
+
+  // Claim the jobs queued so far.  Jobs added from now on are left for the
+  // next call.
+  std::vector<Job*> Pending;
+  {
+    MutexGuard Locked(Lock);
+    Pending.assign(Jobs.begin() + FirstPending, Jobs.end());
+    FirstPending = Jobs.size();
+  }
+  if (Pending.empty())
+    return;
+
+  // Group the pending jobs by LLVMContext, in the order the contexts were
+  // first seen, since a context must only be used by one thread at a time.
+  DenseMap<LLVMContext*, unsigned> GroupOfContext;
+  std::vector<JobGroup> Groups;
+  for (unsigned i = 0, e = Pending.size(); i != e; ++i) {
+    std::pair<DenseMap<LLVMContext*, unsigned>::iterator, bool> Ins =
+      GroupOfContext.insert(std::make_pair(&Pending[i]->M->getContext(),
+                                           Groups.size()));
+    if (Ins.second) {
+      Groups.push_back(JobGroup());
+      Groups.back().OptLevel = OptLevel;
+    }
+    Groups[Ins.first->second].Jobs.push_back(Pending[i]);
+  }
+
+  std::vector<void*> GroupPtrs;
+  for (unsigned i = 0, e = Groups.size(); i != e; ++i)
+    GroupPtrs.push_back(&Groups[i]);
+  llvm_execute_on_threads(compileJobGroup, &GroupPtrs[0], GroupPtrs.size(),
+                          NumThreads);
+
+  // Publish the results.
+  MutexGuard Locked(Lock);
+  for (unsigned i = 0, e = Pending.size(); i != e; ++i)
+    Pending[i]->Compiled = true;
+}
@@ -9,6 +9,7 @@
 
 #include "JITRegistrar.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/Support/Atomic.h"
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/Mutex.h"
@@ -199,16 +200,23 @@ namespace llvm {
 
 JITRegistrar& JITRegistrar::getGDBRegistrar() {
   static GDBJITRegistrar* sRegistrar = NULL;
-  if (sRegistrar == NULL) {
+  GDBJITRegistrar* Registrar = sRegistrar;
+  sys::MemoryFence();
+  if (Registrar == NULL) {
     // The mutex is here so that it won't slow down access once the registrar
     // is instantiated
     llvm::MutexGuard locked(JITDebugLock);
     // Check again to be sure another thread didn't create this while we waited
     if (sRegistrar == NULL) {
-      sRegistrar = new GDBJITRegistrar;
+      Registrar = new GDBJITRegistrar;
+      // Make sure the registrar is fully constructed before other threads
+      // can see it.
+      sys::MemoryFence();
+      sRegistrar = Registrar;
     }
+    Registrar = sRegistrar;
   }
-  return *sRegistrar;
+  return *Registrar;
 }
 
 } // namespace llvm
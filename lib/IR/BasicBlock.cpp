@@ -14,6 +14,7 @@
 #include "llvm/IR/BasicBlock.h"
 #include "SymbolTableListTraitsImpl.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/IntrinsicInst.h"
@@ -174,8 +175,14 @@ BasicBlock::iterator BasicBlock::getFirstInsertionPt() {
 }
 
 void BasicBlock::dropAllReferences() {
+#if LLVM_ENABLE_COMPACT_USE_LISTS
+  // Walk the instructions backwards, see Module::dropAllReferences.
+  for(reverse_iterator I = rbegin(), E = rend(); I != E; ++I)
+    I->dropAllReferences();
+#else
   for(iterator I = begin(), E = end(); I != E; ++I)
     I->dropAllReferences();
+#endif
 }
 
 /// getSinglePredecessor - If this basic block has a single predecessor block,
@@ -18,6 +18,7 @@
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/CodeGen/ValueTypes.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/IR/DerivedTypes.h"
 #include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/LLVMContext.h"
@@ -260,8 +261,14 @@ void Function::setParent(Module *parent) {
 // delete.
 //
 void Function::dropAllReferences() {
+#if LLVM_ENABLE_COMPACT_USE_LISTS
+  // Walk the blocks backwards, see Module::dropAllReferences.
+  for (iterator I = end(), B = begin(); I != B;)
+    (--I)->dropAllReferences();
+#else
   for (iterator I = begin(), E = end(); I != E; ++I)
     I->dropAllReferences();
+#endif
 
   // Delete all basic blocks. They are now unused, except possibly by
   // blockaddresses, but BasicBlock's destructor takes care of those.
@@ -269,6 +276,74 @@ void Function::dropAllReferences() {
     BasicBlocks.begin()->eraseFromParent();
 }
 
+/// isReleasedWithBody - Return true if V is only used from within F's body,
+/// and is going away with it.  A block whose address is taken is also used by
+/// a blockaddress constant, which outlives the function.
+static bool isReleasedWithBody(const Value *V, const Function *F) {
+  if (const Instruction *I = dyn_cast<Instruction>(V)) {
+    assert(I->getParent()->getParent() == F && "Use from another function!");
+    (void)I;
+    return true;
+  }
+  if (isa<Argument>(V)) {
+    assert(cast<Argument>(V)->getParent() == F && "Use from another function!");
+    return true;
+  }
+  if (const BasicBlock *BB = dyn_cast<BasicBlock>(V))
+    return BB->getParent() == F && !BB->hasAddressTaken();
+  return false;
+}
+
+/// releaseOperands - Drop the operands of I, an instruction in the body of F
+/// that is being released.
+static void releaseOperands(Instruction &I, const Function *F) {
+  for (User::op_iterator OI = I.op_begin(), OE = I.op_end(); OI != OE; ++OI) {
+    if (!*OI)
+      continue;
+    if (isReleasedWithBody(*OI, F))
+      OI->forget();
+    else
+      OI->set(0);
+  }
+}
+
+void Function::releaseBody() {
+  // Drop the references of the body.  Uses of values that go away along with
+  // the body are just forgotten; only the use lists of the values that stay,
+  // such as constants and globals, need to be kept up to date.
+#if LLVM_ENABLE_COMPACT_USE_LISTS
+  // Walk the body backwards, see Module::dropAllReferences.
+  for (iterator BB = end(), BB0 = begin(); BB != BB0;) {
+    --BB;
+    for (BasicBlock::reverse_iterator I = BB->rbegin(), IE = BB->rend();
+         I != IE; ++I)
+      releaseOperands(*I, this);
+  }
+#else
+  for (iterator BB = begin(), BE = end(); BB != BE; ++BB)
+    for (BasicBlock::iterator I = BB->begin(), IE = BB->end(); I != IE; ++I)
+      releaseOperands(*I, this);
+#endif
+
+  // Every use of those values has now been forgotten.
+  for (arg_iterator AI = arg_begin(), AE = arg_end(); AI != AE; ++AI)
+    AI->forgetUses();
+  for (iterator BB = begin(), BE = end(); BB != BE; ++BB) {
+    if (!BB->hasAddressTaken())
+      BB->forgetUses();
+    for (BasicBlock::iterator I = BB->begin(), IE = BB->end(); I != IE; ++I)
+      I->forgetUses();
+  }
+
+  // Drop the local names all at once, so that deleting the values does not
+  // remove them from the symbol table one by one.
+  if (SymTab)
+    SymTab->dropAllNames();
+
+  while (!BasicBlocks.empty())
+    BasicBlocks.begin()->eraseFromParent();
+}
+
 void Function::addAttribute(unsigned i, Attribute::AttrKind attr) {
   AttributeSet PAL = getAttributes();
   PAL = PAL.addAttribute(getContext(), i, attr);
@@ -17,6 +17,7 @@
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringExtras.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/GVMaterializer.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DerivedTypes.h"
@@ -423,8 +424,16 @@ bool Module::MaterializeAllPermanently(std::string *ErrInfo) {
 // has "dropped all references", except operator delete.
 //
 void Module::dropAllReferences() {
+#if LLVM_ENABLE_COMPACT_USE_LISTS
+  // Drop the references of the functions in reverse order.  Uses are pushed
+  // onto the front of use lists, so this tends to unlink each use from the
+  // front of its use list, which is what a compact Use can do cheaply.
+  for(Module::iterator I = end(), B = begin(); I != B;)
+    (--I)->dropAllReferences();
+#else
   for(Module::iterator I = begin(), E = end(); I != E; ++I)
     I->dropAllReferences();
+#endif
 
   for(Module::global_iterator I = global_begin(), E = global_end(); I != E; ++I)
     I->dropAllReferences();
@@ -432,3 +441,24 @@ void Module::dropAllReferences() {
   for(Module::alias_iterator I = alias_begin(), E = alias_end(); I != E; ++I)
     I->dropAllReferences();
 }
+
+// dropAllAndRelease() - Delete everything in the module, as the destructor
+// would, but release the function bodies with Function::releaseBody first so
+// that uses inside a body are not unlinked one at a time.  The module is left
+// empty and can still be used.
+//
+void Module::dropAllAndRelease() {
+#if LLVM_ENABLE_COMPACT_USE_LISTS
+  // Release the bodies in reverse, see dropAllReferences.
+  for (iterator I = end(), B = begin(); I != B;)
+    (--I)->releaseBody();
+#else
+  for (iterator I = begin(), E = end(); I != E; ++I)
+    I->releaseBody();
+#endif
+  dropAllReferences();
+  GlobalList.clear();
+  FunctionList.clear();
+  AliasList.clear();
+  NamedMDList.clear();
+}
@@ -45,6 +45,29 @@ void Use::swap(Use &RHS) {
   }
 }
 
+//===----------------------------------------------------------------------===//
+//                         Use removeFromList Implementation
+//===----------------------------------------------------------------------===//
+
+#if LLVM_ENABLE_COMPACT_USE_LISTS
+void Use::removeFromList() {
+  Use **List = Val->getUseListHead();
+  if (*List == this) {
+    *List = getNext();
+    return;
+  }
+  // Without a Prev pointer the predecessor has to be found by walking the use
+  // list.  New uses go to the front of the list, so this is linear in the
+  // number of uses added to the value after this one.
+  Use *Pred = *List;
+  while (Pred->getNext() != this) {
+    assert(Pred->getNext() && "Use is not on the use list of its value!");
+    Pred = Pred->getNext();
+  }
+  Pred->Next.setPointer(getNext());
+}
+#endif
+
 //===----------------------------------------------------------------------===//
 //                         Use getImpliedUser Implementation
 //===----------------------------------------------------------------------===//
@@ -53,7 +76,7 @@ const Use *Use::getImpliedUser() const {
   const Use *Current = this;
 
   while (true) {
-    unsigned Tag = (Current++)->Prev.getInt();
+    unsigned Tag = (Current++)->getTag();
     switch (Tag) {
       case zeroDigitTag:
       case oneDigitTag:
@@ -63,7 +86,7 @@ const Use *Use::getImpliedUser() const {
         ++Current;
         ptrdiff_t Offset = 1;
         while (true) {
-          unsigned Tag = Current->Prev.getInt();
+          unsigned Tag = Current->getTag();
           switch (Tag) {
             case zeroDigitTag:
             case oneDigitTag:
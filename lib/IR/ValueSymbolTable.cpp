@@ -31,6 +31,13 @@ ValueSymbolTable::~ValueSymbolTable() {
 #endif
 }
 
+// Unname all of the values, then destroy their names along with the map.
+void ValueSymbolTable::dropAllNames() {
+  for (iterator VI = vmap.begin(), VE = vmap.end(); VI != VE; ++VI)
+    VI->getValue()->Name = 0;
+  vmap.clear();
+}
+
 // Insert a value into the symbol table with the specified name...
 //
 void ValueSymbolTable::reinsertValue(Value* V) {
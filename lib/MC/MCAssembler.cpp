@@ -51,6 +51,11 @@ STATISTIC(FragmentLayouts, "Number of fragment layouts");
 STATISTIC(ObjectBytes, "Number of emitted object file bytes");
 STATISTIC(RelaxationSteps, "Number of assembler layout and relaxation steps");
 STATISTIC(RelaxedInstructions, "Number of relaxed instructions");
+STATISTIC(RelaxedFragments,
+          "Number of fragments which changed size during relaxation");
+STATISTIC(RelaxationChecks, "Number of fragments checked for relaxation");
+STATISTIC(SkippedRelaxationChecks,
+          "Number of relaxation checks skipped by the worklist");
 }
 }
 
@@ -749,6 +754,65 @@ uint64_t MCAssembler::handleFixup(const MCAsmLayout &Layout,
    return FixedValue;
  }
 
+/// RelaxCandidate - A fragment which may change size during relaxation.
+///
+/// The size of a relaxable instruction only depends on the values of its
+/// fixups. When all of those refer to symbols in the instruction's own
+/// section, the values only change if a fragment in the range [Lo, Hi) of
+/// layout orders changes size, so the instruction doesn't have to be checked
+/// again after the other fragments of the section were relaxed. Everything
+/// else (dwarf and LEB fragments, fixups referring to other sections) is
+/// checked again whenever any fragment of the assembler changed size.
+struct MCAssembler::RelaxCandidate {
+  MCFragment *F;
+
+  /// Whether the size of F only depends on fragments in [Lo, Hi) of its own
+  /// section.
+  bool IsLocal;
+
+  /// Whether [Lo, Hi) contains an alignment fragment, whose size can change
+  /// when any fragment before it is resized.
+  bool HasAlignInRange;
+
+  unsigned Lo, Hi;
+
+  /// The value of RelaxWorklist::Generation when F was last checked, or ~0U
+  /// if it was never checked.
+  unsigned Generation;
+
+  /// Whether F can't change size anymore.
+  bool IsDone;
+
+  /// Return true if the size of F may have to change because of the fragments
+  /// which changed size since it was last checked.
+  bool needsCheck(const SectionRelaxState &S, unsigned CurGeneration) const;
+};
+
+struct MCAssembler::SectionRelaxState {
+  MCSectionData *SD;
+
+  /// The relaxation candidates of SD, in layout order.
+  std::vector<RelaxCandidate> Candidates;
+
+  /// The layout orders of the fragments which changed size during the last
+  /// iteration over SD, in increasing order.
+  SmallVector<unsigned, 16> Changed;
+
+  /// For every layout order I, the number of alignment fragments before I.
+  std::vector<unsigned> NumAlignBefore;
+
+  /// Whether SD has fragments (.org, bundle padding) whose size can depend on
+  /// anything, in which case no candidate of SD is local.
+  bool HasUnknownSizes;
+};
+
+struct MCAssembler::RelaxWorklist {
+  std::vector<SectionRelaxState> Sections;
+
+  /// Incremented every time a fragment changes size.
+  unsigned Generation;
+};
+
 void MCAssembler::Finish() {
   DEBUG_WITH_TYPE("mc-dump", {
       llvm::errs() << "assembler backend - pre-layout\n--\n";
@@ -780,7 +844,9 @@ void MCAssembler::Finish() {
   }
 
   // Layout until everything fits.
-  while (layoutOnce(Layout))
+  RelaxWorklist WL;
+  buildRelaxWorklist(WL);
+  while (layoutOnce(Layout, WL))
     continue;
 
   DEBUG_WITH_TYPE("mc-dump", {
@@ -936,55 +1002,207 @@ bool MCAssembler::relaxDwarfCallFrameFragment(MCAsmLayout &Layout,
   return OldSize != Data.size();
 }
 
-bool MCAssembler::layoutSectionOnce(MCAsmLayout &Layout, MCSectionData &SD) {
+/// collectSymbolRefs - Collect the symbols referred to by \p Expr. Return
+/// false if \p Expr contains something which isn't understood.
+static bool collectSymbolRefs(const MCExpr *Expr,
+                              SmallVectorImpl<const MCSymbol*> &Syms) {
+  switch (Expr->getKind()) {
+  case MCExpr::Constant:
+    return true;
+  case MCExpr::SymbolRef:
+    Syms.push_back(&cast<MCSymbolRefExpr>(Expr)->getSymbol());
+    return true;
+  case MCExpr::Unary:
+    return collectSymbolRefs(cast<MCUnaryExpr>(Expr)->getSubExpr(), Syms);
+  case MCExpr::Binary: {
+    const MCBinaryExpr *BE = cast<MCBinaryExpr>(Expr);
+    return collectSymbolRefs(BE->getLHS(), Syms) &&
+           collectSymbolRefs(BE->getRHS(), Syms);
+  }
+  case MCExpr::Target:
+    return false;
+  }
+  llvm_unreachable("Invalid assembly expression kind!");
+}
+
+void MCAssembler::computeRelaxDependencies(RelaxCandidate &C,
+                                           const SectionRelaxState &S) const {
+  const MCRelaxableFragment &RF = *cast<MCRelaxableFragment>(C.F);
+  C.IsDone = !getBackend().mayNeedRelaxation(RF.getInst());
+  C.IsLocal = false;
+  if (C.IsDone || S.HasUnknownSizes)
+    return;
+
+  unsigned Order = RF.getLayoutOrder();
+  C.Lo = Order;
+  C.Hi = Order;
+  SmallVector<const MCSymbol*, 4> Syms;
+  for (MCRelaxableFragment::const_fixup_iterator it = RF.fixup_begin(),
+         ie = RF.fixup_end(); it != ie; ++it) {
+    Syms.clear();
+    if (!collectSymbolRefs(it->getValue(), Syms))
+      return;
+    // Absolute references depend on the offset of the symbol in its section,
+    // and so do PC-relative ones which align the PC.
+    unsigned Flags = getBackend().getFixupKindInfo(it->getKind()).Flags;
+    if (!(Flags & MCFixupKindInfo::FKF_IsPCRel) ||
+        (Flags & MCFixupKindInfo::FKF_IsAlignedDownTo32Bits))
+      C.Lo = 0;
+    for (unsigned i = 0, e = Syms.size(); i != e; ++i) {
+      if (Syms[i]->isVariable() || Syms[i]->isUndefined())
+        return;
+      const MCSymbolData *SD = SymbolMap.lookup(Syms[i]);
+      if (!SD || !SD->getFragment() || SD->getFragment()->getParent() != S.SD)
+        return;
+      unsigned TargetOrder = SD->getFragment()->getLayoutOrder();
+      C.Lo = std::min(C.Lo, TargetOrder);
+      C.Hi = std::max(C.Hi, TargetOrder);
+    }
+  }
+
+  C.IsLocal = true;
+  C.HasAlignInRange = S.NumAlignBefore[C.Hi] != S.NumAlignBefore[C.Lo];
+}
+
+void MCAssembler::buildRelaxWorklist(RelaxWorklist &WL) {
+  WL.Generation = 0;
+  WL.Sections.resize(size());
+
+  unsigned Index = 0;
+  for (iterator it = begin(), ie = end(); it != ie; ++it, ++Index) {
+    SectionRelaxState &S = WL.Sections[Index];
+    S.SD = &*it;
+    S.HasUnknownSizes = isBundlingEnabled();
+    S.NumAlignBefore.reserve(it->getFragmentList().size() + 1);
+    S.NumAlignBefore.push_back(0);
+
+    for (MCSectionData::iterator I = it->begin(), IE = it->end(); I != IE;
+         ++I) {
+      unsigned NumAlign = S.NumAlignBefore.back();
+      switch (I->getKind()) {
+      case MCFragment::FT_Align:
+        ++NumAlign;
+        break;
+      case MCFragment::FT_Org:
+        S.HasUnknownSizes = true;
+        break;
+      case MCFragment::FT_Relaxable:
+        assert(!getRelaxAll() &&
+               "Did not expect a MCRelaxableFragment in RelaxAll mode");
+        // Fall through.
+      case MCFragment::FT_Dwarf:
+      case MCFragment::FT_DwarfFrame:
+      case MCFragment::FT_LEB: {
+        RelaxCandidate C;
+        C.F = &*I;
+        C.IsLocal = false;
+        C.IsDone = false;
+        C.Generation = ~0U;
+        S.Candidates.push_back(C);
+        break;
+      }
+      default:
+        break;
+      }
+      S.NumAlignBefore.push_back(NumAlign);
+    }
+  }
+
+  // The dependencies can only be computed once the whole section was scanned.
+  for (unsigned i = 0, e = WL.Sections.size(); i != e; ++i) {
+    SectionRelaxState &S = WL.Sections[i];
+    for (unsigned j = 0, je = S.Candidates.size(); j != je; ++j)
+      if (isa<MCRelaxableFragment>(S.Candidates[j].F))
+        computeRelaxDependencies(S.Candidates[j], S);
+  }
+}
+
+bool MCAssembler::RelaxCandidate::needsCheck(const SectionRelaxState &S,
+                                             unsigned CurGeneration) const {
+  if (Generation == CurGeneration)
+    return false;
+  if (!IsLocal || Generation == ~0U)
+    return true;
+  if (S.Changed.empty())
+    return false;
+
+  // Any resized fragment before an alignment in range may move the fragments
+  // after that alignment.
+  if (HasAlignInRange && S.Changed.front() < Hi)
+    return true;
+  const unsigned *I = std::lower_bound(S.Changed.begin(), S.Changed.end(), Lo);
+  return I != S.Changed.end() && *I < Hi;
+}
+
+bool MCAssembler::layoutSectionOnce(MCAsmLayout &Layout, RelaxWorklist &WL,
+                                    SectionRelaxState &S) {
   // Holds the first fragment which needed relaxing during this layout. It will
   // remain NULL if none were relaxed.
   // When a fragment is relaxed, all the fragments following it should get
   // invalidated because their offset is going to change.
   MCFragment *FirstRelaxedFragment = NULL;
+  SmallVector<unsigned, 16> Changed;
+
+  // Attempt to relax the fragments of the section which may have been
+  // affected by the last changes.
+  for (unsigned i = 0, e = S.Candidates.size(); i != e; ++i) {
+    RelaxCandidate &C = S.Candidates[i];
+    if (C.IsDone)
+      continue;
+    if (!C.needsCheck(S, WL.Generation)) {
+      ++stats::SkippedRelaxationChecks;
+      continue;
+    }
+    C.Generation = WL.Generation;
+    ++stats::RelaxationChecks;
 
-  // Attempt to relax all the fragments in the section.
-  for (MCSectionData::iterator I = SD.begin(), IE = SD.end(); I != IE; ++I) {
     // Check if this is a fragment that needs relaxation.
     bool RelaxedFrag = false;
-    switch(I->getKind()) {
+    switch(C.F->getKind()) {
     default:
-      break;
+      llvm_unreachable("Unexpected fragment kind in the relaxation worklist");
     case MCFragment::FT_Relaxable:
-      assert(!getRelaxAll() &&
-             "Did not expect a MCRelaxableFragment in RelaxAll mode");
-      RelaxedFrag = relaxInstruction(Layout, *cast<MCRelaxableFragment>(I));
+      RelaxedFrag = relaxInstruction(Layout, *cast<MCRelaxableFragment>(C.F));
+      // The relaxed instruction may refer to different symbols.
+      if (RelaxedFrag)
+        computeRelaxDependencies(C, S);
       break;
     case MCFragment::FT_Dwarf:
       RelaxedFrag = relaxDwarfLineAddr(Layout,
-                                       *cast<MCDwarfLineAddrFragment>(I));
+                                       *cast<MCDwarfLineAddrFragment>(C.F));
       break;
     case MCFragment::FT_DwarfFrame:
       RelaxedFrag =
         relaxDwarfCallFrameFragment(Layout,
-                                    *cast<MCDwarfCallFrameFragment>(I));
+                                    *cast<MCDwarfCallFrameFragment>(C.F));
       break;
     case MCFragment::FT_LEB:
-      RelaxedFrag = relaxLEB(Layout, *cast<MCLEBFragment>(I));
+      RelaxedFrag = relaxLEB(Layout, *cast<MCLEBFragment>(C.F));
       break;
     }
-    if (RelaxedFrag && !FirstRelaxedFragment)
-      FirstRelaxedFragment = I;
+    if (!RelaxedFrag)
+      continue;
+    ++stats::RelaxedFragments;
+    Changed.push_back(C.F->getLayoutOrder());
+    if (!FirstRelaxedFragment)
+      FirstRelaxedFragment = C.F;
   }
+
+  S.Changed.swap(Changed);
   if (FirstRelaxedFragment) {
+    ++WL.Generation;
     Layout.invalidateFragmentsFrom(FirstRelaxedFragment);
     return true;
   }
   return false;
 }
 
-bool MCAssembler::layoutOnce(MCAsmLayout &Layout) {
+bool MCAssembler::layoutOnce(MCAsmLayout &Layout, RelaxWorklist &WL) {
   ++stats::RelaxationSteps;
 
   bool WasRelaxed = false;
-  for (iterator it = begin(), ie = end(); it != ie; ++it) {
-    MCSectionData &SD = *it;
-    while (layoutSectionOnce(Layout, SD))
+  for (unsigned i = 0, e = WL.Sections.size(); i != e; ++i) {
+    while (layoutSectionOnce(Layout, WL, WL.Sections[i]))
       WasRelaxed = true;
   }
 
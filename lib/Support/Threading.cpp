@@ -16,6 +16,7 @@
 #include "llvm/Support/Atomic.h"
 #include "llvm/Support/Mutex.h"
 #include <cassert>
+#include <vector>
 
 using namespace llvm;
 
@@ -63,6 +64,27 @@ void llvm::llvm_release_global_lock() {
   if (multithreaded_mode) global_lock->release();
 }
 
+namespace {
+/// ThreadGroupInfo - The work shared by the threads of one
+/// llvm_execute_on_threads() call.
+struct ThreadGroupInfo {
+  void (*UserFn)(void *);
+  void **UserData;
+  unsigned NumItems;
+  volatile sys::cas_flag NextItem;
+};
+}
+
+/// RunThreadGroupItems - Claim items from TGI until there are none left.
+static void RunThreadGroupItems(ThreadGroupInfo *TGI) {
+  for (;;) {
+    unsigned Item = sys::AtomicIncrement(&TGI->NextItem) - 1;
+    if (Item >= TGI->NumItems)
+      return;
+    TGI->UserFn(TGI->UserData[Item]);
+  }
+}
+
 #if LLVM_ENABLE_THREADS != 0 && defined(HAVE_PTHREAD_H)
 #include <pthread.h>
 
@@ -102,6 +124,46 @@ void llvm::llvm_execute_on_thread(void (*Fn)(void*), void *UserData,
  error:
   ::pthread_attr_destroy(&Attr);
 }
+
+static void *ExecuteOnThreads_Dispatch(void *Arg) {
+  RunThreadGroupItems(reinterpret_cast<ThreadGroupInfo*>(Arg));
+  return 0;
+}
+
+void llvm::llvm_execute_on_threads(void (*Fn)(void*), void **UserData,
+                                   unsigned NumItems, unsigned NumThreads,
+                                   unsigned RequestedStackSize) {
+  ThreadGroupInfo Info = { Fn, UserData, NumItems, 0 };
+  std::vector<pthread_t> Threads;
+  pthread_attr_t Attr;
+
+  // Don't create more threads than there are items, and only create threads
+  // at all if LLVM has been made safe for it.
+  if (NumThreads > NumItems)
+    NumThreads = NumItems;
+  if (NumThreads > 1 && llvm_is_multithreaded() &&
+      ::pthread_attr_init(&Attr) == 0) {
+    if (RequestedStackSize == 0 ||
+        ::pthread_attr_setstacksize(&Attr, RequestedStackSize) == 0) {
+      // The calling thread is the first worker, so create one thread less.
+      for (unsigned i = 1; i != NumThreads; ++i) {
+        pthread_t Thread;
+        if (::pthread_create(&Thread, &Attr, ExecuteOnThreads_Dispatch,
+                             &Info) != 0)
+          break;
+        Threads.push_back(Thread);
+      }
+    }
+    ::pthread_attr_destroy(&Attr);
+  }
+
+  // Whatever threads could not be created, the calling thread picks up the
+  // remaining items.
+  RunThreadGroupItems(&Info);
+
+  for (unsigned i = 0, e = Threads.size(); i != e; ++i)
+    ::pthread_join(Threads[i], 0);
+}
 #elif LLVM_ENABLE_THREADS!=0 && defined(LLVM_ON_WIN32)
 #include "Windows/Windows.h"
 #include <process.h>
@@ -136,6 +198,39 @@ void llvm::llvm_execute_on_thread(void (*Fn)(void*), void *UserData,
     ::CloseHandle(hThread);
   }
 }
+
+static unsigned __stdcall ThreadGroupCallback(void *param) {
+  RunThreadGroupItems(reinterpret_cast<ThreadGroupInfo *>(param));
+  return 0;
+}
+
+void llvm::llvm_execute_on_threads(void (*Fn)(void*), void **UserData,
+                                   unsigned NumItems, unsigned NumThreads,
+                                   unsigned RequestedStackSize) {
+  ThreadGroupInfo Info = { Fn, UserData, NumItems, 0 };
+  std::vector<HANDLE> Threads;
+
+  if (NumThreads > NumItems)
+    NumThreads = NumItems;
+  if (llvm_is_multithreaded()) {
+    // The calling thread is the first worker, so create one thread less.
+    for (unsigned i = 1; i < NumThreads; ++i) {
+      HANDLE hThread = (HANDLE)::_beginthreadex(NULL, RequestedStackSize,
+                                                ThreadGroupCallback, &Info,
+                                                0, NULL);
+      if (!hThread)
+        break;
+      Threads.push_back(hThread);
+    }
+  }
+
+  RunThreadGroupItems(&Info);
+
+  for (unsigned i = 0, e = Threads.size(); i != e; ++i) {
+    (void)::WaitForSingleObject(Threads[i], INFINITE);
+    ::CloseHandle(Threads[i]);
+  }
+}
 #else
 // Support for non-Win32, non-pthread implementation.
 void llvm::llvm_execute_on_thread(void (*Fn)(void*), void *UserData,
@@ -144,4 +239,13 @@ void llvm::llvm_execute_on_thread(void (*Fn)(void*), void *UserData,
   Fn(UserData);
 }
 
+void llvm::llvm_execute_on_threads(void (*Fn)(void*), void **UserData,
+                                   unsigned NumItems, unsigned NumThreads,
+                                   unsigned RequestedStackSize) {
+  (void) NumThreads;
+  (void) RequestedStackSize;
+  ThreadGroupInfo Info = { Fn, UserData, NumItems, 0 };
+  RunThreadGroupItems(&Info);
+}
+
 #endif
@@ -1674,7 +1674,7 @@ bool ARMFastISel::SelectSelect(const Instruction *I) {
     return false;
 
   // Things need to be register sized for register moves.
-  if (VT != MVT::i32) return false;
+  if (VT != MVT::i32 && VT != MVT::f32 && VT != MVT::f64) return false;
 
   unsigned CondReg = getRegForValue(I->getOperand(0));
   if (CondReg == 0) return false;
@@ -1708,7 +1708,13 @@ bool ARMFastISel::SelectSelect(const Instruction *I) {
 
   unsigned MovCCOpc;
   const TargetRegisterClass *RC;
-  if (!UseImm) {
+  if (VT == MVT::f32) {
+    RC = &ARM::SPRRegClass;
+    MovCCOpc = ARM::VMOVScc;
+  } else if (VT == MVT::f64) {
+    RC = &ARM::DPRRegClass;
+    MovCCOpc = ARM::VMOVDcc;
+  } else if (!UseImm) {
     RC = isThumb2 ? &ARM::tGPRRegClass : &ARM::GPRRegClass;
     MovCCOpc = isThumb2 ? ARM::t2MOVCCr : ARM::MOVCCr;
   } else {
@@ -2529,14 +2535,13 @@ bool ARMFastISel::SelectIntrinsicCall(const IntrinsicInst &I) {
   case Intrinsic::memcpy:
   case Intrinsic::memmove: {
     const MemTransferInst &MTI = cast<MemTransferInst>(I);
-    // Don't handle volatile.
-    if (MTI.isVolatile())
-      return false;
 
     // Disable inlining for memmove before calls to ComputeAddress.  Otherwise,
     // we would emit dead code because we don't currently handle memmoves.
+    // Volatile copies are never expanded inline; they become library calls,
+    // as they do in SelectionDAG when the length is unknown.
     bool isMemCpy = (I.getIntrinsicID() == Intrinsic::memcpy);
-    if (isa<ConstantInt>(MTI.getLength()) && isMemCpy) {
+    if (isa<ConstantInt>(MTI.getLength()) && isMemCpy && !MTI.isVolatile()) {
       // Small memcpy's are common enough that we want to do them without a call
       // if possible.
       uint64_t Len = cast<ConstantInt>(MTI.getLength())->getZExtValue();
@@ -2562,9 +2567,6 @@ bool ARMFastISel::SelectIntrinsicCall(const IntrinsicInst &I) {
   }
   case Intrinsic::memset: {
     const MemSetInst &MSI = cast<MemSetInst>(I);
-    // Don't handle volatile.
-    if (MSI.isVolatile())
-      return false;
 
     if (!MSI.getLength()->getType()->isIntegerTy(32))
       return false;
@@ -77,10 +77,13 @@ public:
 private:
   bool X86FastEmitCompare(const Value *LHS, const Value *RHS, EVT VT);
 
-  bool X86FastEmitLoad(EVT VT, const X86AddressMode &AM, unsigned &RR);
+  bool X86FastEmitLoad(EVT VT, const X86AddressMode &AM, unsigned &RR,
+                       unsigned Alignment = 1);
 
-  bool X86FastEmitStore(EVT VT, const Value *Val, const X86AddressMode &AM);
-  bool X86FastEmitStore(EVT VT, unsigned Val, const X86AddressMode &AM);
+  bool X86FastEmitStore(EVT VT, const Value *Val, const X86AddressMode &AM,
+                        unsigned Alignment = 1);
+  bool X86FastEmitStore(EVT VT, unsigned Val, const X86AddressMode &AM,
+                        unsigned Alignment = 1);
 
   bool X86FastEmitExtend(ISD::NodeType Opc, EVT DstVT, unsigned Src, EVT SrcVT,
                          unsigned &ResultReg);
@@ -100,6 +103,8 @@ private:
 
   bool X86SelectBranch(const Instruction *I);
 
+  bool X86SelectSwitch(const Instruction *I);
+
   bool X86SelectShift(const Instruction *I);
 
   bool X86SelectDivRem(const Instruction *I);
@@ -173,12 +178,15 @@ bool X86FastISel::isTypeLegal(Type *Ty, MVT &VT, bool AllowI1) {
 
 /// X86FastEmitLoad - Emit a machine instruction to load a value of type VT.
 /// The address is either pre-computed, i.e. Ptr, or a GlobalAddress, i.e. GV.
+/// Alignment picks between aligned and unaligned vector loads.
 /// Return true and the result register by reference if it is possible.
 bool X86FastISel::X86FastEmitLoad(EVT VT, const X86AddressMode &AM,
-                                  unsigned &ResultReg) {
+                                  unsigned &ResultReg, unsigned Alignment) {
   // Get opcode and regclass of the output for the given load instruction.
   unsigned Opc = 0;
   const TargetRegisterClass *RC = NULL;
+  bool HasAVX = Subtarget->hasAVX();
+  bool IsAligned = Alignment >= VT.getStoreSize();
   switch (VT.getSimpleVT().SimpleTy) {
   default: return false;
   case MVT::i1:
@@ -220,6 +228,45 @@ bool X86FastISel::X86FastEmitLoad(EVT VT, const X86AddressMode &AM,
   case MVT::f80:
     // No f80 support yet.
     return false;
+  case MVT::v4f32:
+    if (IsAligned)
+      Opc = HasAVX ? X86::VMOVAPSrm : X86::MOVAPSrm;
+    else
+      Opc = HasAVX ? X86::VMOVUPSrm : X86::MOVUPSrm;
+    RC  = &X86::VR128RegClass;
+    break;
+  case MVT::v2f64:
+    if (IsAligned)
+      Opc = HasAVX ? X86::VMOVAPDrm : X86::MOVAPDrm;
+    else
+      Opc = HasAVX ? X86::VMOVUPDrm : X86::MOVUPDrm;
+    RC  = &X86::VR128RegClass;
+    break;
+  case MVT::v4i32:
+  case MVT::v2i64:
+  case MVT::v8i16:
+  case MVT::v16i8:
+    if (IsAligned)
+      Opc = HasAVX ? X86::VMOVDQArm : X86::MOVDQArm;
+    else
+      Opc = HasAVX ? X86::VMOVDQUrm : X86::MOVDQUrm;
+    RC  = &X86::VR128RegClass;
+    break;
+  case MVT::v8f32:
+    Opc = IsAligned ? X86::VMOVAPSYrm : X86::VMOVUPSYrm;
+    RC  = &X86::VR256RegClass;
+    break;
+  case MVT::v4f64:
+    Opc = IsAligned ? X86::VMOVAPDYrm : X86::VMOVUPDYrm;
+    RC  = &X86::VR256RegClass;
+    break;
+  case MVT::v8i32:
+  case MVT::v4i64:
+  case MVT::v16i16:
+  case MVT::v32i8:
+    Opc = IsAligned ? X86::VMOVDQAYrm : X86::VMOVDQUYrm;
+    RC  = &X86::VR256RegClass;
+    break;
   }
 
   ResultReg = createResultReg(RC);
@@ -231,11 +278,15 @@ bool X86FastISel::X86FastEmitLoad(EVT VT, const X86AddressMode &AM,
 /// X86FastEmitStore - Emit a machine instruction to store a value Val of
 /// type VT. The address is either pre-computed, consisted of a base ptr, Ptr
 /// and a displacement offset, or a GlobalAddress,
-/// i.e. V. Return true if it is possible.
+/// i.e. V. Alignment picks between aligned and unaligned vector stores.
+/// Return true if it is possible.
 bool
-X86FastISel::X86FastEmitStore(EVT VT, unsigned Val, const X86AddressMode &AM) {
+X86FastISel::X86FastEmitStore(EVT VT, unsigned Val, const X86AddressMode &AM,
+                              unsigned Alignment) {
   // Get opcode and regclass of the output for the given store instruction.
   unsigned Opc = 0;
+  bool HasAVX = Subtarget->hasAVX();
+  bool IsAligned = Alignment >= VT.getStoreSize();
   switch (VT.getSimpleVT().SimpleTy) {
   case MVT::f80: // No f80 support yet.
   default: return false;
@@ -260,16 +311,37 @@ X86FastISel::X86FastEmitStore(EVT VT, unsigned Val, const X86AddressMode &AM) {
           (Subtarget->hasAVX() ? X86::VMOVSDmr : X86::MOVSDmr) : X86::ST_Fp64m;
     break;
   case MVT::v4f32:
-    Opc = X86::MOVAPSmr;
+    if (IsAligned)
+      Opc = HasAVX ? X86::VMOVAPSmr : X86::MOVAPSmr;
+    else
+      Opc = HasAVX ? X86::VMOVUPSmr : X86::MOVUPSmr;
     break;
   case MVT::v2f64:
-    Opc = X86::MOVAPDmr;
+    if (IsAligned)
+      Opc = HasAVX ? X86::VMOVAPDmr : X86::MOVAPDmr;
+    else
+      Opc = HasAVX ? X86::VMOVUPDmr : X86::MOVUPDmr;
     break;
   case MVT::v4i32:
   case MVT::v2i64:
   case MVT::v8i16:
   case MVT::v16i8:
-    Opc = X86::MOVDQAmr;
+    if (IsAligned)
+      Opc = HasAVX ? X86::VMOVDQAmr : X86::MOVDQAmr;
+    else
+      Opc = HasAVX ? X86::VMOVDQUmr : X86::MOVDQUmr;
+    break;
+  case MVT::v8f32:
+    Opc = IsAligned ? X86::VMOVAPSYmr : X86::VMOVUPSYmr;
+    break;
+  case MVT::v4f64:
+    Opc = IsAligned ? X86::VMOVAPDYmr : X86::VMOVUPDYmr;
+    break;
+  case MVT::v8i32:
+  case MVT::v4i64:
+  case MVT::v16i16:
+  case MVT::v32i8:
+    Opc = IsAligned ? X86::VMOVDQAYmr : X86::VMOVDQUYmr;
     break;
   }
 
@@ -279,7 +351,8 @@ X86FastISel::X86FastEmitStore(EVT VT, unsigned Val, const X86AddressMode &AM) {
 }
 
 bool X86FastISel::X86FastEmitStore(EVT VT, const Value *Val,
-                                   const X86AddressMode &AM) {
+                                   const X86AddressMode &AM,
+                                   unsigned Alignment) {
   // Handle 'null' like i32/i64 0.
   if (isa<ConstantPointerNull>(Val))
     Val = Constant::getNullValue(TD.getIntPtrType(Val->getContext()));
@@ -314,7 +387,7 @@ bool X86FastISel::X86FastEmitStore(EVT VT, const Value *Val,
   if (ValReg == 0)
     return false;
 
-  return X86FastEmitStore(VT, ValReg, AM);
+  return X86FastEmitStore(VT, ValReg, AM, Alignment);
 }
 
 /// X86FastEmitExtend - Emit a machine instruction to extend a value Src of
@@ -696,7 +769,11 @@ bool X86FastISel::X86SelectStore(const Instruction *I) {
   if (!X86SelectAddress(I->getOperand(1), AM))
     return false;
 
-  return X86FastEmitStore(VT, I->getOperand(0), AM);
+  unsigned Alignment = S->getAlignment();
+  if (Alignment == 0)
+    Alignment = TD.getABITypeAlignment(I->getOperand(0)->getType());
+
+  return X86FastEmitStore(VT, I->getOperand(0), AM, Alignment);
 }
 
 /// X86SelectRet - Select and emit code to implement ret instructions.
@@ -832,7 +909,8 @@ bool X86FastISel::X86SelectRet(const Instruction *I) {
 ///
 bool X86FastISel::X86SelectLoad(const Instruction *I)  {
   // Atomic loads need special handling.
-  if (cast<LoadInst>(I)->isAtomic())
+  const LoadInst *LI = cast<LoadInst>(I);
+  if (LI->isAtomic())
     return false;
 
   MVT VT;
@@ -843,8 +921,12 @@ bool X86FastISel::X86SelectLoad(const Instruction *I)  {
   if (!X86SelectAddress(I->getOperand(0), AM))
     return false;
 
+  unsigned Alignment = LI->getAlignment();
+  if (Alignment == 0)
+    Alignment = TD.getABITypeAlignment(LI->getType());
+
   unsigned ResultReg = 0;
-  if (X86FastEmitLoad(VT, AM, ResultReg)) {
+  if (X86FastEmitLoad(VT, AM, ResultReg, Alignment)) {
     UpdateValueMap(I, ResultReg);
     return true;
   }
@@ -1179,6 +1261,74 @@ bool X86FastISel::X86SelectBranch(const Instruction *I) {
   return true;
 }
 
+/// X86SelectSwitch - Select a switch whose cases all lead to the same block,
+/// as a compare of the condition with each case value and one conditional
+/// branch.  A block can only end in one conditional branch, so switches with
+/// several destinations are left to SelectionDAG, as are large ones, for which
+/// it can build jump tables and bit tests.
+bool X86FastISel::X86SelectSwitch(const Instruction *I) {
+  const SwitchInst *SI = cast<SwitchInst>(I);
+  if (SI->getNumCases() >= 4)
+    return false;
+
+  MVT VT;
+  if (!isTypeLegal(SI->getCondition()->getType(), VT))
+    return false;
+
+  // Make sure every case is a single value that can be folded into the
+  // compare, and that they all share a destination, before emitting anything.
+  const BasicBlock *CaseBB = 0;
+  for (SwitchInst::ConstCaseIt Case = SI->case_begin(), E = SI->case_end();
+       Case != E; ++Case) {
+    if (!Case.getCaseValueEx().isSingleNumber() ||
+        !X86ChooseCmpImmediateOpcode(VT, Case.getCaseValue()))
+      return false;
+    if (CaseBB && Case.getCaseSuccessor() != CaseBB)
+      return false;
+    CaseBB = Case.getCaseSuccessor();
+  }
+
+  MachineBasicBlock *DefaultMBB = FuncInfo.MBBMap[SI->getDefaultDest()];
+  if (!CaseBB || CaseBB == SI->getDefaultDest()) {
+    FastEmitBranch(DefaultMBB, DL);
+    return true;
+  }
+  MachineBasicBlock *CaseMBB = FuncInfo.MBBMap[CaseBB];
+
+  unsigned BranchOpc = X86::JE_4;
+  if (SI->getNumCases() > 1) {
+    // Or together the results of the individual compares.
+    unsigned MatchReg = 0;
+    for (SwitchInst::ConstCaseIt Case = SI->case_begin(), E = SI->case_end();
+         Case != E; ++Case) {
+      if (!X86FastEmitCompare(SI->getCondition(), Case.getCaseValue(), VT))
+        return false;
+      unsigned SetReg = createResultReg(&X86::GR8RegClass);
+      BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DL, TII.get(X86::SETEr),
+              SetReg);
+      if (MatchReg) {
+        unsigned OrReg = createResultReg(&X86::GR8RegClass);
+        BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DL, TII.get(X86::OR8rr),
+                OrReg).addReg(MatchReg).addReg(SetReg);
+        SetReg = OrReg;
+      }
+      MatchReg = SetReg;
+    }
+    BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DL, TII.get(X86::TEST8rr))
+      .addReg(MatchReg).addReg(MatchReg);
+    BranchOpc = X86::JNE_4;
+  } else if (!X86FastEmitCompare(SI->getCondition(),
+                                 SI->case_begin().getCaseValue(), VT)) {
+    return false;
+  }
+
+  BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DL, TII.get(BranchOpc))
+    .addMBB(CaseMBB);
+  FastEmitBranch(DefaultMBB, DL);
+  FuncInfo.MBB->addSuccessor(CaseMBB);
+  return true;
+}
+
 bool X86FastISel::X86SelectShift(const Instruction *I) {
   unsigned CReg = 0, OpReg = 0;
   const TargetRegisterClass *RC = NULL;
@@ -1387,7 +1537,7 @@ bool X86FastISel::X86SelectDivRem(const Instruction *I) {
 
 bool X86FastISel::X86SelectSelect(const Instruction *I) {
   MVT VT;
-  if (!isTypeLegal(I->getType(), VT))
+  if (!isTypeLegal(I->getType(), VT, /*AllowI1=*/true))
     return false;
 
   // We only use cmov here, if we don't have a cmov instruction bail.
@@ -1395,7 +1545,14 @@ bool X86FastISel::X86SelectSelect(const Instruction *I) {
 
   unsigned Opc = 0;
   const TargetRegisterClass *RC = NULL;
-  if (VT == MVT::i16) {
+  // There is no 8-bit cmov, so i1 and i8 selects are done in 32-bit
+  // registers.
+  bool Widen = false;
+  if (VT == MVT::i1 || VT == MVT::i8) {
+    Opc = X86::CMOVE32rr;
+    RC = &X86::GR32RegClass;
+    Widen = true;
+  } else if (VT == MVT::i16) {
     Opc = X86::CMOVE16rr;
     RC = &X86::GR16RegClass;
   } else if (VT == MVT::i32) {
@@ -1415,11 +1572,38 @@ bool X86FastISel::X86SelectSelect(const Instruction *I) {
   unsigned Op2Reg = getRegForValue(I->getOperand(2));
   if (Op2Reg == 0) return false;
 
-  BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DL, TII.get(X86::TEST8rr))
-    .addReg(Op0Reg).addReg(Op0Reg);
+  if (Widen) {
+    unsigned Ext1Reg = createResultReg(RC);
+    BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DL, TII.get(X86::MOVZX32rr8),
+            Ext1Reg).addReg(Op1Reg);
+    unsigned Ext2Reg = createResultReg(RC);
+    BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DL, TII.get(X86::MOVZX32rr8),
+            Ext2Reg).addReg(Op2Reg);
+    Op1Reg = Ext1Reg;
+    Op2Reg = Ext2Reg;
+  }
+
+  // Only the low bit of an i1 is defined.
+  BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DL, TII.get(X86::TEST8ri))
+    .addReg(Op0Reg).addImm(1);
   unsigned ResultReg = createResultReg(RC);
   BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DL, TII.get(Opc), ResultReg)
     .addReg(Op1Reg).addReg(Op2Reg);
+
+  if (Widen) {
+    // On x86-32 only the ABCD registers have an addressable low byte.
+    if (!Subtarget->is64Bit()) {
+      unsigned CopyReg = createResultReg(&X86::GR32_ABCDRegClass);
+      BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DL,
+              TII.get(TargetOpcode::COPY), CopyReg).addReg(ResultReg);
+      ResultReg = CopyReg;
+    }
+    ResultReg = FastEmitInst_extractsubreg(MVT::i8, ResultReg, /*Kill=*/true,
+                                           X86::sub_8bit);
+    if (!ResultReg)
+      return false;
+  }
+
   UpdateValueMap(I, ResultReg);
   return true;
 }
@@ -1552,13 +1736,14 @@ bool X86FastISel::X86VisitIntrinsicCall(const IntrinsicInst &I) {
   // FIXME: Handle more intrinsics.
   switch (I.getIntrinsicID()) {
   default: return false;
-  case Intrinsic::memcpy: {
-    const MemCpyInst &MCI = cast<MemCpyInst>(I);
-    // Don't handle volatile or variable length memcpys.
-    if (MCI.isVolatile())
-      return false;
-
-    if (isa<ConstantInt>(MCI.getLength())) {
+  case Intrinsic::memcpy:
+  case Intrinsic::memmove: {
+    const MemTransferInst &MCI = cast<MemTransferInst>(I);
+    bool IsMemCpy = I.getIntrinsicID() == Intrinsic::memcpy;
+
+    // Volatile copies and memmoves are never expanded inline; they become
+    // library calls, as they do in SelectionDAG when the length is unknown.
+    if (IsMemCpy && !MCI.isVolatile() && isa<ConstantInt>(MCI.getLength())) {
       // Small memcpy's are common enough that we want to do them
       // without a call if possible.
       uint64_t Len = cast<ConstantInt>(MCI.getLength())->getZExtValue();
@@ -1579,14 +1764,11 @@ bool X86FastISel::X86VisitIntrinsicCall(const IntrinsicInst &I) {
     if (MCI.getSourceAddressSpace() > 255 || MCI.getDestAddressSpace() > 255)
       return false;
 
-    return DoSelectCall(&I, "memcpy");
+    return DoSelectCall(&I, IsMemCpy ? "memcpy" : "memmove");
   }
   case Intrinsic::memset: {
     const MemSetInst &MSI = cast<MemSetInst>(I);
 
-    if (MSI.isVolatile())
-      return false;
-
     unsigned SizeWidth = Subtarget->is64Bit() ? 64 : 32;
     if (!MSI.getLength()->getType()->isIntegerTy(SizeWidth))
       return false;
@@ -1627,11 +1809,16 @@ bool X86FastISel::X86VisitIntrinsicCall(const IntrinsicInst &I) {
     return true;
   }
   case Intrinsic::sadd_with_overflow:
-  case Intrinsic::uadd_with_overflow: {
+  case Intrinsic::uadd_with_overflow:
+  case Intrinsic::ssub_with_overflow:
+  case Intrinsic::usub_with_overflow:
+  case Intrinsic::smul_with_overflow:
+  case Intrinsic::umul_with_overflow: {
     // FIXME: Should fold immediates.
 
-    // Replace "add with overflow" intrinsics with an "add" instruction followed
-    // by a seto/setc instruction.
+    // Replace "op with overflow" intrinsics with the arithmetic instruction
+    // followed by a seto/setb instruction.
+    Intrinsic::ID IID = I.getIntrinsicID();
     const Function *Callee = I.getCalledFunction();
     Type *RetTy =
       cast<StructType>(Callee->getReturnType())->getTypeAtIndex(unsigned(0));
@@ -1649,24 +1836,54 @@ bool X86FastISel::X86VisitIntrinsicCall(const IntrinsicInst &I) {
       // FIXME: Handle values *not* in registers.
       return false;
 
-    unsigned OpC = 0;
-    if (VT == MVT::i32)
-      OpC = X86::ADD32rr;
-    else if (VT == MVT::i64)
-      OpC = X86::ADD64rr;
-    else
+    if (VT != MVT::i32 && VT != MVT::i64)
       return false;
+    bool Is64 = VT == MVT::i64;
 
     // The call to CreateRegs builds two sequential registers, to store the
     // both the returned values.
     unsigned ResultReg = FuncInfo.CreateRegs(I.getType());
-    BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DL, TII.get(OpC), ResultReg)
-      .addReg(Reg1).addReg(Reg2);
+    unsigned SetOpc = X86::SETOr;
+    switch (IID) {
+    default: llvm_unreachable("Unexpected overflow intrinsic!");
+    case Intrinsic::uadd_with_overflow:
+      SetOpc = X86::SETBr;
+      // FALLTHROUGH
+    case Intrinsic::sadd_with_overflow:
+      BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DL,
+              TII.get(Is64 ? X86::ADD64rr : X86::ADD32rr), ResultReg)
+        .addReg(Reg1).addReg(Reg2);
+      break;
+    case Intrinsic::usub_with_overflow:
+      SetOpc = X86::SETBr;
+      // FALLTHROUGH
+    case Intrinsic::ssub_with_overflow:
+      BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DL,
+              TII.get(Is64 ? X86::SUB64rr : X86::SUB32rr), ResultReg)
+        .addReg(Reg1).addReg(Reg2);
+      break;
+    case Intrinsic::smul_with_overflow:
+      BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DL,
+              TII.get(Is64 ? X86::IMUL64rr : X86::IMUL32rr), ResultReg)
+        .addReg(Reg1).addReg(Reg2);
+      break;
+    case Intrinsic::umul_with_overflow: {
+      // The unsigned multiply takes one operand in EAX/RAX, and sets the
+      // overflow flag when the high half of the product in EDX/RDX is
+      // nonzero.
+      unsigned AccReg = Is64 ? X86::RAX : X86::EAX;
+      BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DL,
+              TII.get(TargetOpcode::COPY), AccReg).addReg(Reg1);
+      BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DL,
+              TII.get(Is64 ? X86::MUL64r : X86::MUL32r)).addReg(Reg2);
+      BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DL,
+              TII.get(TargetOpcode::COPY), ResultReg).addReg(AccReg);
+      break;
+    }
+    }
 
-    unsigned Opc = X86::SETBr;
-    if (I.getIntrinsicID() == Intrinsic::sadd_with_overflow)
-      Opc = X86::SETOr;
-    BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DL, TII.get(Opc), ResultReg+1);
+    BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DL, TII.get(SetOpc),
+            ResultReg+1);
 
     UpdateValueMap(&I, ResultReg, 2);
     return true;
@@ -2024,6 +2241,8 @@ bool X86FastISel::DoSelectCall(const Instruction *I, const char *MemIntName) {
       AM.Disp = LocMemOffset;
       const Value *ArgVal = ArgVals[VA.getValNo()];
       ISD::ArgFlagsTy Flags = ArgFlags[VA.getValNo()];
+      unsigned Alignment = MinAlign(TM.getFrameLowering()->getStackAlignment(),
+                                    LocMemOffset);
 
       if (Flags.isByVal()) {
         X86AddressMode SrcAM;
@@ -2034,10 +2253,10 @@ bool X86FastISel::DoSelectCall(const Instruction *I, const char *MemIntName) {
         // If this is a really simple value, emit this with the Value* version
         // of X86FastEmitStore.  If it isn't simple, we don't want to do this,
         // as it can cause us to reevaluate the argument.
-        if (!X86FastEmitStore(ArgVT, ArgVal, AM))
+        if (!X86FastEmitStore(ArgVT, ArgVal, AM, Alignment))
           return false;
       } else {
-        if (!X86FastEmitStore(ArgVT, Arg, AM))
+        if (!X86FastEmitStore(ArgVT, Arg, AM, Alignment))
           return false;
       }
     }
@@ -2228,6 +2447,8 @@ X86FastISel::TargetSelectInstruction(const Instruction *I)  {
     return X86SelectZExt(I);
   case Instruction::Br:
     return X86SelectBranch(I);
+  case Instruction::Switch:
+    return X86SelectSwitch(I);
   case Instruction::Call:
     return X86SelectCall(I);
   case Instruction::LShr:
@@ -9,13 +9,16 @@
 //
 // This pass looks for equivalent functions that are mergable and folds them.
 //
-// A hash is computed from the function, based on its type and number of
-// basic blocks.
+// A hash is computed from the function, based on its type and on the opcodes,
+// types and operand kinds of the instructions in its body.
 //
 // Once all hashes are computed, we perform an expensive equality comparison
 // on each function pair. This takes n^2/2 comparisons per bucket, so it's
-// important that the hash function be high quality. The equality comparison
-// iterates through each instruction in each basic block.
+// important that the hash function be high quality. The hash only leaves out
+// what the comparator can prove equal in different ways, such as the exact
+// indices of a GEP or the identity of the values an instruction uses, so in
+// practice a bucket holds functions which really are equal. The equality
+// comparison iterates through each instruction in each basic block.
 //
 // When a match is found the functions are folded. If both functions are
 // overridable, we move the functionality into a new internal function and
@@ -45,6 +48,7 @@
 
 #define DEBUG_TYPE "mergefunc"
 #include "llvm/Transforms/IPO.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/FoldingSet.h"
 #include "llvm/ADT/STLExtras.h"
@@ -71,6 +75,7 @@ STATISTIC(NumFunctionsMerged, "Number of functions merged");
 STATISTIC(NumThunksWritten, "Number of thunks generated");
 STATISTIC(NumAliasesWritten, "Number of aliases generated");
 STATISTIC(NumDoubleWeak, "Number of new functions created");
+STATISTIC(NumComparisons, "Number of function bodies compared");
 
 /// Returns the type id for a type to be hashed. We turn pointer types into
 /// integers here because the actual compare logic below considers pointers and
@@ -81,10 +86,60 @@ static Type::TypeID getTypeIDForHash(Type *Ty) {
   return Ty->getTypeID();
 }
 
+/// Adds a type to the function hash. Integers are distinguished by their
+/// width, and pointers are hashed as the pointer-sized integer that the
+/// comparator considers them equal to.
+static void profileType(FoldingSetNodeID &ID, Type *Ty, const DataLayout *TD) {
+  ID.AddInteger(getTypeIDForHash(Ty));
+  if (Ty->isPointerTy())
+    ID.AddInteger(TD ? TD->getPointerSizeInBits() : 0);
+  else if (IntegerType *ITy = dyn_cast<IntegerType>(Ty))
+    ID.AddInteger(ITy->getBitWidth());
+}
+
+/// Adds the parts of an instruction that FunctionComparator checks for
+/// equality to the function hash. GEPs only contribute their opcode because
+/// two GEPs with different indices may still compute the same offset. Integer
+/// constants are hashed by value since the comparator never equates two
+/// different ones.
+static void profileInstruction(FoldingSetNodeID &ID, const Instruction *I,
+                               const DataLayout *TD) {
+  ID.AddInteger(I->getOpcode());
+  if (isa<GetElementPtrInst>(I))
+    return;
+
+  ID.AddInteger(I->getNumOperands());
+  ID.AddInteger(I->getRawSubclassOptionalData());
+  profileType(ID, I->getType(), TD);
+  for (unsigned i = 0, e = I->getNumOperands(); i != e; ++i) {
+    const Value *Op = I->getOperand(i);
+    ID.AddInteger(Op->getValueID());
+    profileType(ID, Op->getType(), TD);
+    if (const ConstantInt *C = dyn_cast<ConstantInt>(Op))
+      ID.AddInteger(C->getValue().getLimitedValue());
+  }
+
+  if (const LoadInst *LI = dyn_cast<LoadInst>(I)) {
+    ID.AddBoolean(LI->isVolatile());
+    ID.AddInteger(LI->getAlignment());
+  } else if (const StoreInst *SI = dyn_cast<StoreInst>(I)) {
+    ID.AddBoolean(SI->isVolatile());
+    ID.AddInteger(SI->getAlignment());
+  } else if (const CmpInst *CI = dyn_cast<CmpInst>(I)) {
+    ID.AddInteger(CI->getPredicate());
+  } else if (const CallInst *CI = dyn_cast<CallInst>(I)) {
+    ID.AddInteger(CI->getCallingConv());
+  } else if (const InvokeInst *II = dyn_cast<InvokeInst>(I)) {
+    ID.AddInteger(II->getCallingConv());
+  }
+}
+
 /// Creates a hash-code for the function which is the same for any two
-/// functions that will compare equal, without looking at the instructions
-/// inside the function.
-static unsigned profileFunction(const Function *F) {
+/// functions that will compare equal. Besides the signature, the hash covers
+/// the opcodes, types and operand kinds of every reachable instruction, visited
+/// in the same CFG order that FunctionComparator::compare uses, so functions
+/// that share a signature but differ in their bodies rarely collide.
+static unsigned profileFunction(const Function *F, const DataLayout *TD) {
   FunctionType *FTy = F->getFunctionType();
 
   FoldingSetNodeID ID;
@@ -92,9 +147,26 @@ static unsigned profileFunction(const Function *F) {
   ID.AddInteger(F->getCallingConv());
   ID.AddBoolean(F->hasGC());
   ID.AddBoolean(FTy->isVarArg());
-  ID.AddInteger(getTypeIDForHash(FTy->getReturnType()));
+  profileType(ID, FTy->getReturnType(), TD);
   for (unsigned i = 0, e = FTy->getNumParams(); i != e; ++i)
-    ID.AddInteger(getTypeIDForHash(FTy->getParamType(i)));
+    profileType(ID, FTy->getParamType(i), TD);
+
+  SmallVector<const BasicBlock *, 8> BBs;
+  SmallSet<const BasicBlock *, 128> VisitedBBs;
+  BBs.push_back(&F->getEntryBlock());
+  VisitedBBs.insert(BBs[0]);
+  while (!BBs.empty()) {
+    const BasicBlock *BB = BBs.pop_back_val();
+    ID.AddInteger(BB->size());
+    for (BasicBlock::const_iterator I = BB->begin(), E = BB->end(); I != E;
+         ++I)
+      profileInstruction(ID, I, TD);
+
+    const TerminatorInst *TI = BB->getTerminator();
+    for (unsigned i = 0, e = TI->getNumSuccessors(); i != e; ++i)
+      if (VisitedBBs.insert(TI->getSuccessor(i)))
+        BBs.push_back(TI->getSuccessor(i));
+  }
   return ID.ComputeHash();
 }
 
@@ -109,7 +181,12 @@ public:
   static DataLayout * const LookupOnly;
 
   ComparableFunction(Function *Func, DataLayout *TD)
-    : Func(Func), Hash(profileFunction(Func)), TD(TD) {}
+    : Func(Func), Hash(profileFunction(Func, TD)), TD(TD) {}
+
+  /// Creates a LookupOnly entry for Func. The hash must be the one Func was
+  /// inserted with.
+  ComparableFunction(Function *Func, unsigned Hash)
+    : Func(Func), Hash(Hash), TD(LookupOnly) {}
 
   Function *getFunc() const { return Func; }
   unsigned getHash() const { return Hash; }
@@ -597,6 +674,10 @@ private:
   /// to modify it.
   FnSetType FnSet;
 
+  /// The hash each function in FnSet was inserted with. remove() erases a
+  /// function with this hash, since its body may have changed since then.
+  DenseMap<Function *, unsigned> FnHashes;
+
   /// DataLayout for more accurate GEP comparisons. May be NULL.
   DataLayout *TD;
 
@@ -661,6 +742,7 @@ bool MergeFunctions::runOnModule(Module &M) {
   } while (!Deferred.empty());
 
   FnSet.clear();
+  FnHashes.clear();
 
   return Changed;
 }
@@ -673,6 +755,11 @@ bool DenseMapInfo<ComparableFunction>::isEqual(const ComparableFunction &LHS,
   if (!LHS.getFunc() || !RHS.getFunc())
     return false;
 
+  // DenseSet probes past entries from other buckets too. Functions that will
+  // compare equal always have the same hash, so don't bother comparing those.
+  if (LHS.getHash() != RHS.getHash())
+    return false;
+
   // One of these is a special "underlying pointer comparison only" object.
   if (LHS.getTD() == ComparableFunction::LookupOnly ||
       RHS.getTD() == ComparableFunction::LookupOnly)
@@ -681,6 +768,7 @@ bool DenseMapInfo<ComparableFunction>::isEqual(const ComparableFunction &LHS,
   assert(LHS.getTD() == RHS.getTD() &&
          "Comparing functions for different targets");
 
+  ++NumComparisons;
   return FunctionComparator(LHS.getTD(), LHS.getFunc(),
                             RHS.getFunc()).compare();
 }
@@ -824,6 +912,7 @@ bool MergeFunctions::insert(ComparableFunction &NewF) {
   std::pair<FnSetType::iterator, bool> Result = FnSet.insert(NewF);
   if (Result.second) {
     DEBUG(dbgs() << "Inserting as unique: " << NewF.getFunc()->getName() << '\n');
+    FnHashes[NewF.getFunc()] = NewF.getHash();
     return false;
   }
 
@@ -851,7 +940,11 @@ void MergeFunctions::remove(Function *F) {
   // The special "lookup only" ComparableFunction bypasses the expensive
   // function comparison in favour of a pointer comparison on the underlying
   // Function*'s.
-  ComparableFunction CF = ComparableFunction(F, ComparableFunction::LookupOnly);
+  DenseMap<Function *, unsigned>::iterator HI = FnHashes.find(F);
+  if (HI == FnHashes.end())
+    return;
+  ComparableFunction CF = ComparableFunction(F, HI->second);
+  FnHashes.erase(HI);
   if (FnSet.erase(CF)) {
     DEBUG(dbgs() << "Removed " << F->getName() << " from set and deferred it.\n");
     Deferred.push_back(F);
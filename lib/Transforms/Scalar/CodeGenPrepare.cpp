@@ -23,6 +23,7 @@
 #include "llvm/Analysis/Dominators.h"
 #include "llvm/Analysis/InstructionSimplify.h"
 #include "llvm/Analysis/ProfileInfo.h"
+#include "llvm/Analysis/ValueTracking.h"
 #include "llvm/Assembly/Writer.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DataLayout.h"
@@ -63,6 +64,8 @@ STATISTIC(NumExtUses,    "Number of uses of [s|z]ext instructions optimized");
 STATISTIC(NumRetsDup,    "Number of return instructions duplicated");
 STATISTIC(NumDbgValueMoved, "Number of debug value instructions moved");
 STATISTIC(NumSelectsExpanded, "Number of selects turned into branches");
+STATISTIC(NumDiamondsFolded, "Number of small diamonds, triangles and switches "
+                             "turned into selects");
 
 static cl::opt<bool> DisableBranchOpts(
   "disable-cgp-branch-opts", cl::Hidden, cl::init(false),
@@ -72,6 +75,16 @@ static cl::opt<bool> DisableSelectToBranch(
   "disable-cgp-select2branch", cl::Hidden, cl::init(false),
   cl::desc("Disable select to branch conversion."));
 
+static cl::opt<bool> FoldDiamonds(
+  "cgp-fold-small-diamonds", cl::Hidden, cl::init(false),
+  cl::desc("Turn small if-then-else diamonds and switches into selects, so "
+           "that they are selected as one block"));
+
+static cl::opt<unsigned> SmallDiamondSize(
+  "cgp-small-diamond-size", cl::Hidden, cl::init(4),
+  cl::desc("Speculation cost threshold for each arm folded by "
+           "-cgp-fold-small-diamonds, and the maximum number of switch cases"));
+
 namespace {
   class CodeGenPrepare : public FunctionPass {
     /// TLI - Keep a pointer of a TargetLowering to consult for determining
@@ -120,6 +133,8 @@ namespace {
     bool EliminateMostlyEmptyBlocks(Function &F);
     bool CanMergeBlocks(const BasicBlock *BB, const BasicBlock *DestBB) const;
     void EliminateMostlyEmptyBlock(BasicBlock *BB);
+    bool FoldSmallDiamonds(Function &F);
+    bool FoldSmallDiamond(BasicBlock *BB);
     bool OptimizeBlock(BasicBlock &BB);
     bool OptimizeInst(Instruction *I);
     bool OptimizeMemoryInst(Instruction *I, Value *Addr, Type *AccessTy);
@@ -168,6 +183,11 @@ bool CodeGenPrepare::runOnFunction(Function &F) {
   // unconditional branch.
   EverMadeChange |= EliminateMostlyEmptyBlocks(F);
 
+  // Speculate small diamonds, so that instruction selection builds one DAG
+  // where it would have built three.
+  if (FoldDiamonds && !PFI && !(TLI && TLI->isSelectExpensive()))
+    EverMadeChange |= FoldSmallDiamonds(F);
+
   // llvm.dbg.value is far away from the value then iSel may not be able
   // handle it properly. iSel will drop llvm.dbg.value if it can not
   // find a node corresponding to the value.
@@ -264,6 +284,103 @@ bool CodeGenPrepare::EliminateFallThrough(Function &F) {
   return Changed;
 }
 
+/// FoldSmallDiamonds - Turn if-then-else diamonds, if-then triangles and
+/// switches with small arms into straight-line code and selects.  Each one
+/// that is folded saves instruction selection a DAG per arm, and lets the DAG
+/// combiner see the arms together.
+bool CodeGenPrepare::FoldSmallDiamonds(Function &F) {
+  bool MadeChange = false;
+  for (Function::iterator BB = F.begin(); BB != F.end(); ++BB)
+    while (FoldSmallDiamond(BB))
+      MadeChange = true;
+  return MadeChange;
+}
+
+/// getArmSuccessor - If Arm is only reached from BB and ends in an
+/// unconditional branch, return the destination of that branch.
+static BasicBlock *getArmSuccessor(BasicBlock *Arm, BasicBlock *BB) {
+  if (Arm->getSinglePredecessor() != BB)
+    return 0;
+  BranchInst *BI = dyn_cast<BranchInst>(Arm->getTerminator());
+  if (!BI || BI->isConditional())
+    return 0;
+  return BI->getSuccessor(0);
+}
+
+/// FoldSmallDiamond - Fold the diamond, triangle or switch headed by BB with
+/// SimplifyCFG's if-conversion utilities, using -cgp-small-diamond-size as the
+/// speculation cost threshold, and merge the join block into BB when BB is
+/// its only predecessor.
+bool CodeGenPrepare::FoldSmallDiamond(BasicBlock *BB) {
+  const DataLayout *TD = TLI ? TLI->getDataLayout() : 0;
+
+  if (SwitchInst *SI = dyn_cast<SwitchInst>(BB->getTerminator())) {
+    if (!FoldSwitchToSelects(SI, TD, SmallDiamondSize))
+      return false;
+    DEBUG(dbgs() << "Folded small switch in " << BB->getName() << '\n');
+    // The dominator tree is recomputed at the end of the pass.
+    MergeBlockIntoPredecessor(BB->getTerminator()->getSuccessor(0));
+    ModifiedDT = true;
+    ++NumDiamondsFolded;
+    return true;
+  }
+
+  BranchInst *BI = dyn_cast<BranchInst>(BB->getTerminator());
+  if (!BI || !BI->isConditional())
+    return false;
+  BasicBlock *TrueBB = BI->getSuccessor(0), *FalseBB = BI->getSuccessor(1);
+  if (TrueBB == FalseBB)
+    return false;
+
+  // Find the join block.  For a triangle, remember the one arm.
+  BasicBlock *TrueSucc = getArmSuccessor(TrueBB, BB);
+  BasicBlock *FalseSucc = getArmSuccessor(FalseBB, BB);
+  BasicBlock *Join, *ThenBB = 0;
+  if (TrueSucc && TrueSucc == FalseSucc) {
+    Join = TrueSucc;
+  } else if (TrueSucc == FalseBB) {
+    Join = FalseBB;
+    ThenBB = TrueBB;
+  } else if (FalseSucc && FalseSucc == TrueBB) {
+    Join = TrueBB;
+    ThenBB = FalseBB;
+  } else {
+    return false;
+  }
+  PHINode *PN = dyn_cast<PHINode>(Join->begin());
+  if (Join == BB || !PN)
+    return false;
+
+  if (PN->getNumIncomingValues() == 2) {
+    if (!FoldTwoEntryPHINode(PN, TD, SmallDiamondSize))
+      return false;
+    // The PHI nodes may just have been simplified away, leaving the branch.
+    if (cast<BranchInst>(BB->getTerminator())->isConditional())
+      return true;
+    if (TrueBB != Join)
+      DeleteDeadBlock(TrueBB);
+    if (FalseBB != Join)
+      DeleteDeadBlock(FalseBB);
+    MergeBlockIntoPredecessor(Join);
+  } else {
+    // The join block has other predecessors, so only a triangle can be
+    // speculated, and its PHI nodes stay.
+    if (!ThenBB || !SpeculativelyExecuteBB(BI, ThenBB, SmallDiamondSize))
+      return false;
+    Value *Cond = BI->getCondition();
+    BranchInst::Create(Join, BI);
+    BI->eraseFromParent();
+    DeleteDeadBlock(ThenBB);
+    RecursivelyDeleteTriviallyDeadInstructions(Cond, TLInfo);
+  }
+
+  DEBUG(dbgs() << "Folded small diamond headed by " << BB->getName() << '\n');
+  // The dominator tree is recomputed at the end of the pass.
+  ModifiedDT = true;
+  ++NumDiamondsFolded;
+  return true;
+}
+
 /// EliminateMostlyEmptyBlocks - eliminate blocks that contain only PHI nodes,
 /// debug info directives, and an unconditional branch.  Passes before isel
 /// (e.g. LSR/loopsimplify) often split edges in ways that are non-optimal for
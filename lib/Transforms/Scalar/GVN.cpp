@@ -45,6 +45,7 @@
 #include "llvm/Target/TargetLibraryInfo.h"
 #include "llvm/Transforms/Utils/BasicBlockUtils.h"
 #include "llvm/Transforms/Utils/SSAUpdater.h"
+#include <queue>
 #include <vector>
 using namespace llvm;
 using namespace PatternMatch;
@@ -56,11 +57,24 @@ STATISTIC(NumGVNBlocks, "Number of blocks merged");
 STATISTIC(NumGVNSimpl,  "Number of instructions simplified");
 STATISTIC(NumGVNEqProp, "Number of equalities propagated");
 STATISTIC(NumPRELoad,   "Number of loads PRE'd");
+STATISTIC(NumGVNRevisit, "Number of instructions revisited by sparse GVN");
+STATISTIC(NumGVNBudget, "Number of functions where sparse GVN hit its budget");
 
 static cl::opt<bool> EnablePRE("enable-pre",
                                cl::init(true), cl::Hidden);
 static cl::opt<bool> EnableLoadPRE("enable-load-pre", cl::init(true));
 
+// Sparse mode value numbers the function once and then only revisits the
+// instructions whose operands or value numbers changed.  It does no scalar PRE.
+static cl::opt<bool>
+EnableSparse("gvn-sparse", cl::Hidden, cl::init(false),
+             cl::desc("Use the sparse, worklist-driven GVN engine"));
+
+static cl::opt<unsigned>
+SparseBudget("gvn-sparse-budget", cl::Hidden, cl::init(100000),
+             cl::desc("Max instructions sparse GVN revisits in a function "
+                      "(default = 100000)"));
+
 // Maximum allowed recursion depth.
 static cl::opt<uint32_t>
 MaxRecurseDepth("max-recurse-depth", cl::Hidden, cl::init(1000), cl::ZeroOrMore,
@@ -119,6 +133,7 @@ namespace {
     ValueTable() : nextValueNumber(1) { }
     uint32_t lookup_or_add(Value *V);
     uint32_t lookup(Value *V) const;
+    bool exists(Value *V) const { return valueNumbering.count(V) != 0; }
     uint32_t lookup_or_add_cmp(unsigned Opcode, CmpInst::Predicate Pred,
                                Value *LHS, Value *RHS);
     void add(Value *V, uint32_t num);
@@ -590,6 +605,20 @@ namespace {
 
     SmallVector<Instruction*, 8> InstrsToErase;
 
+    /// Sparse - Whether this run uses the sparse engine.  In that mode every
+    /// reachable instruction gets its position in the dominator tree walk in
+    /// SparseOrder, and SparseWorklist holds the instructions to revisit,
+    /// ordered by that position.  SparseLate holds the instructions that were
+    /// created and numbered after the walk passed their position.
+    bool Sparse;
+    DenseMap<const Instruction*, unsigned> SparseOrder;
+    unsigned NextSparseOrder;
+    typedef std::pair<unsigned, Instruction*> SparseItem;
+    std::priority_queue<SparseItem, std::vector<SparseItem>,
+                        std::greater<SparseItem> > SparseWorklist;
+    SmallPtrSet<Instruction*, 32> SparseQueued;
+    SmallPtrSet<const Instruction*, 8> SparseLate;
+
     typedef SmallVector<NonLocalDepResult, 64> LoadDepVect;
     typedef SmallVector<AvailableValueInBlock, 64> AvailValInBlkVect;
     typedef SmallVector<BasicBlock*, 64> UnavailBlkVect;
@@ -597,7 +626,7 @@ namespace {
   public:
     static char ID; // Pass identification, replacement for typeid
     explicit GVN(bool noloads = false)
-        : FunctionPass(ID), NoLoads(noloads), MD(0) {
+        : FunctionPass(ID), NoLoads(noloads), MD(0), Sparse(false) {
       initializeGVNPass(*PassRegistry::getPassRegistry());
     }
 
@@ -638,10 +667,16 @@ namespace {
       LeaderTableEntry* Prev = 0;
       LeaderTableEntry* Curr = &LeaderTable[N];
 
-      while (Curr->Val != I || Curr->BB != BB) {
+      while (Curr && (Curr->Val != I || Curr->BB != BB)) {
         Prev = Curr;
         Curr = Curr->Next;
       }
+      // In sparse mode an instruction that is revisited may already have been
+      // dropped from the table.  Otherwise the entry must be there.
+      if (!Curr) {
+        assert(Sparse && "Leader table entry not found!");
+        return;
+      }
 
       if (Prev) {
         Prev->Next = Curr->Next;
@@ -686,10 +721,19 @@ namespace {
     // Other helper routines
     bool processInstruction(Instruction *I);
     bool processBlock(BasicBlock *BB);
+    void eraseMarkedInstructions();
     void dump(DenseMap<uint32_t, Value*> &d);
     bool iterateOnFunction(Function &F);
+    bool iterateSparse(Function &F);
+    bool revisitInstruction(Instruction *I);
+    Use *collectVisitedUsers(Instruction *I,
+                             SmallVectorImpl<Instruction*> &Users);
+    void queueForRevisit(Instruction *I);
+    void queueReplacement(Use *U);
     bool performPRE(Function &F);
-    Value *findLeader(const BasicBlock *BB, uint32_t num);
+    Value *findLeader(const BasicBlock *BB, uint32_t num,
+                      const Instruction *At = 0);
+    bool isAvailableAt(Value *V, const Instruction *At) const;
     void cleanupGlobalSets();
     void verifyRemoved(const Instruction *I) const;
     bool splitCriticalEdges();
@@ -1965,20 +2009,22 @@ bool GVN::processLoad(LoadInst *L) {
 // specific basic block, we first obtain the list of all Values for that number,
 // and then scan the list to find one whose block dominates the block in
 // question.  This is fast because dominator tree queries consist of only
-// a few comparisons of DFS numbers.
-Value *GVN::findLeader(const BasicBlock *BB, uint32_t num) {
+// a few comparisons of DFS numbers.  If 'At' is given, the table may also hold
+// instructions later in BB, and only those that come before 'At' qualify.
+Value *GVN::findLeader(const BasicBlock *BB, uint32_t num,
+                       const Instruction *At) {
   LeaderTableEntry Vals = LeaderTable[num];
   if (!Vals.Val) return 0;
 
   Value *Val = 0;
-  if (DT->dominates(Vals.BB, BB)) {
+  if (DT->dominates(Vals.BB, BB) && isAvailableAt(Vals.Val, At)) {
     Val = Vals.Val;
     if (isa<Constant>(Val)) return Val;
   }
 
   LeaderTableEntry* Next = Vals.Next;
   while (Next) {
-    if (DT->dominates(Next->BB, BB)) {
+    if (DT->dominates(Next->BB, BB) && isAvailableAt(Next->Val, At)) {
       if (isa<Constant>(Next->Val)) return Next->Val;
       if (!Val) Val = Next->Val;
     }
@@ -1989,6 +2035,28 @@ Value *GVN::findLeader(const BasicBlock *BB, uint32_t num) {
   return Val;
 }
 
+/// isAvailableAt - Return true unless 'V' is an instruction in the same block
+/// as 'At' that the sparse walk did not visit before 'At', or that does not
+/// come before 'At' if either of them was created late.
+bool GVN::isAvailableAt(Value *V, const Instruction *At) const {
+  const Instruction *I = dyn_cast<Instruction>(V);
+  if (!At || !I || I->getParent() != At->getParent())
+    return true;
+  DenseMap<const Instruction*, unsigned>::const_iterator VI =
+    SparseOrder.find(I), AtI = SparseOrder.find(At);
+  if (VI == SparseOrder.end() || AtI == SparseOrder.end())
+    return false;
+  if (!SparseLate.count(I) && !SparseLate.count(At))
+    return VI->second < AtI->second;
+
+  // The order of a late instruction says nothing about its position.
+  for (BasicBlock::const_iterator BI = I, BE = I->getParent()->end();
+       ++BI != BE;)
+    if (&*BI == At)
+      return true;
+  return false;
+}
+
 /// replaceAllDominatedUsesWith - Replace all uses of 'From' with 'To' if the
 /// use is dominated by the given basic block.  Returns the number of uses that
 /// were replaced.
@@ -2002,6 +2070,8 @@ unsigned GVN::replaceAllDominatedUsesWith(Value *From, Value *To,
     if (DT->dominates(Root, U)) {
       U.set(To);
       ++Count;
+      if (Sparse)
+        queueForRevisit(cast<Instruction>(U.getUser()));
     }
   }
   return Count;
@@ -2262,7 +2332,7 @@ bool GVN::processInstruction(Instruction *I) {
 
   // Perform fast-path value-number based elimination of values inherited from
   // dominators.
-  Value *repl = findLeader(I->getParent(), Num);
+  Value *repl = findLeader(I->getParent(), Num, Sparse ? I : 0);
   if (repl == 0) {
     // Failure, just remember this instance for future use.
     addToLeaderTable(Num, I, I->getParent());
@@ -2287,6 +2357,7 @@ bool GVN::runOnFunction(Function& F) {
   VN.setAliasAnalysis(&getAnalysis<AliasAnalysis>());
   VN.setMemDep(MD);
   VN.setDomTree(DT);
+  Sparse = EnableSparse;
 
   bool Changed = false;
   bool ShouldContinue = true;
@@ -2302,6 +2373,11 @@ bool GVN::runOnFunction(Function& F) {
     Changed |= removedBlock;
   }
 
+  if (Sparse) {
+    Changed |= iterateSparse(F);
+    ShouldContinue = false;
+  }
+
   unsigned Iteration = 0;
   while (ShouldContinue) {
     DEBUG(dbgs() << "GVN iteration: " << Iteration << "\n");
@@ -2310,7 +2386,9 @@ bool GVN::runOnFunction(Function& F) {
     ++Iteration;
   }
 
-  if (EnablePRE) {
+  // The sparse engine leaves PRE to processNonLocalLoad: scalar PRE rescans
+  // the whole function every round, which is what sparse mode avoids.
+  if (EnablePRE && !Sparse) {
     bool PREChanged = true;
     while (PREChanged) {
       PREChanged = performPRE(F);
@@ -2336,30 +2414,34 @@ bool GVN::processBlock(BasicBlock *BB) {
          "We expect InstrsToErase to be empty across iterations");
   bool ChangedFunction = false;
 
+  SmallVector<Instruction*, 8> Users;
+  Use *AnyUse = 0;
   for (BasicBlock::iterator BI = BB->begin(), BE = BB->end();
        BI != BE;) {
+    // In sparse mode, remember the users that were already visited (phis in
+    // loop headers, mostly): they must be revisited if BI gets replaced.
+    if (Sparse) {
+      SparseOrder[BI] = NextSparseOrder++;
+      AnyUse = collectVisitedUsers(BI, Users);
+    }
+
     ChangedFunction |= processInstruction(BI);
     if (InstrsToErase.empty()) {
       ++BI;
       continue;
     }
 
-    // If we need some instructions deleted, do it now.
-    NumGVNInstr += InstrsToErase.size();
+    for (unsigned i = 0, e = Users.size(); i != e; ++i)
+      queueForRevisit(Users[i]);
+    queueReplacement(AnyUse);
 
     // Avoid iterator invalidation.
     bool AtStart = BI == BB->begin();
     if (!AtStart)
       --BI;
 
-    for (SmallVector<Instruction*, 4>::iterator I = InstrsToErase.begin(),
-         E = InstrsToErase.end(); I != E; ++I) {
-      DEBUG(dbgs() << "GVN removed: " << **I << '\n');
-      if (MD) MD->removeInstruction(*I);
-      DEBUG(verifyRemoved(*I));
-      (*I)->eraseFromParent();
-    }
-    InstrsToErase.clear();
+    // If we need some instructions deleted, do it now.
+    eraseMarkedInstructions();
 
     if (AtStart)
       BI = BB->begin();
@@ -2370,6 +2452,38 @@ bool GVN::processBlock(BasicBlock *BB) {
   return ChangedFunction;
 }
 
+/// eraseMarkedInstructions - Delete the instructions queued by
+/// markInstructionForDeletion.
+void GVN::eraseMarkedInstructions() {
+  NumGVNInstr += InstrsToErase.size();
+
+  // In sparse mode, loads that lose their last use here are revisited so that
+  // processLoad can delete them.
+  SmallVector<LoadInst*, 4> OperandLoads;
+  for (SmallVector<Instruction*, 4>::iterator I = InstrsToErase.begin(),
+       E = InstrsToErase.end(); I != E; ++I) {
+    DEBUG(dbgs() << "GVN removed: " << **I << '\n');
+    if (MD) MD->removeInstruction(*I);
+    DEBUG(verifyRemoved(*I));
+    if (Sparse) {
+      SparseOrder.erase(*I);
+      SparseQueued.erase(*I);
+      SparseLate.erase(*I);
+      for (User::op_iterator OI = (*I)->op_begin(), OE = (*I)->op_end();
+           OI != OE; ++OI)
+        if (LoadInst *L = dyn_cast<LoadInst>(*OI))
+          OperandLoads.push_back(L);
+    }
+    (*I)->eraseFromParent();
+  }
+  InstrsToErase.clear();
+
+  // Loads erased above are no longer in SparseOrder, so they are skipped.
+  for (unsigned i = 0, e = OperandLoads.size(); i != e; ++i)
+    if (SparseOrder.count(OperandLoads[i]) && OperandLoads[i]->use_empty())
+      queueForRevisit(OperandLoads[i]);
+}
+
 /// performPRE - Perform a purely local form of PRE that looks for diamond
 /// control flow patterns and attempts to perform simple PRE at the join point.
 bool GVN::performPRE(Function &F) {
@@ -2603,6 +2717,157 @@ bool GVN::iterateOnFunction(Function &F) {
   return Changed;
 }
 
+/// iterateSparse - Value number the function once in dominator tree order, then
+/// revisit only the instructions that a change may have made redundant: users
+/// of replaced values, users of values whose number changed, and values that
+/// share the new number.  Returns whether the function changed.
+bool GVN::iterateSparse(Function &F) {
+  NextSparseOrder = 0;
+  bool Changed = iterateOnFunction(F);
+
+  unsigned Budget = SparseBudget;
+  while (!SparseWorklist.empty()) {
+    Instruction *I = SparseWorklist.top().second;
+    SparseWorklist.pop();
+    // Skip stale entries for instructions that were erased or already redone.
+    if (!SparseQueued.erase(I))
+      continue;
+
+    if (Budget == 0) {
+      DEBUG(dbgs() << "GVN: sparse budget exhausted in " << F.getName()
+                   << "\n");
+      ++NumGVNBudget;
+      break;
+    }
+    --Budget;
+    ++NumGVNRevisit;
+    Changed |= revisitInstruction(I);
+  }
+
+  while (!SparseWorklist.empty())
+    SparseWorklist.pop();
+  SparseQueued.clear();
+  SparseOrder.clear();
+  SparseLate.clear();
+  return Changed;
+}
+
+/// revisitInstruction - Value number 'I' again now that something it depends
+/// on has changed, and queue the instructions that this in turn affects.
+bool GVN::revisitInstruction(Instruction *I) {
+  DEBUG(dbgs() << "GVN revisiting: " << *I << '\n');
+  uint32_t OldNum = 0;
+  if (VN.exists(I)) {
+    OldNum = VN.lookup(I);
+    removeFromLeaderTable(OldNum, I, I->getParent());
+    VN.erase(I);
+  }
+
+  SmallVector<Instruction*, 8> Users;
+  Use *AnyUse = collectVisitedUsers(I, Users);
+
+  uint32_t NextNum = VN.getNextUnusedValueNumber();
+  bool Changed = processInstruction(I);
+  if (!InstrsToErase.empty()) {
+    for (unsigned i = 0, e = Users.size(); i != e; ++i)
+      queueForRevisit(Users[i]);
+    queueReplacement(AnyUse);
+    eraseMarkedInstructions();
+    return true;
+  }
+
+  // A load that split critical edges for PRE can try again.
+  if (Changed && isa<LoadInst>(I))
+    queueForRevisit(I);
+
+  if (!VN.exists(I))
+    return Changed;
+  // A brand new number (every phi gets one) is shared with nothing, so it
+  // cannot make anything else redundant.
+  uint32_t Num = VN.lookup(I);
+  if (Num == OldNum || Num >= NextNum)
+    return Changed;
+
+  // The users were numbered in terms of the old number.
+  for (unsigned i = 0, e = Users.size(); i != e; ++i)
+    queueForRevisit(Users[i]);
+
+  // Instructions that already have the new number may be dominated by 'I'.
+  for (LeaderTableEntry *Entry = &LeaderTable[Num]; Entry;
+       Entry = Entry->Next)
+    if (Instruction *Other = dyn_cast_or_null<Instruction>(Entry->Val))
+      if (Other != I)
+        queueForRevisit(Other);
+
+  return Changed;
+}
+
+/// collectVisitedUsers - Fill 'Users' with the users of 'I' that the sparse
+/// walk has already visited.  Also return a use of 'I' by some other
+/// instruction, which will show the replacement if 'I' is replaced.
+Use *GVN::collectVisitedUsers(Instruction *I,
+                              SmallVectorImpl<Instruction*> &Users) {
+  Users.clear();
+  Use *AnyUse = 0;
+  for (Value::use_iterator UI = I->use_begin(), UE = I->use_end();
+       UI != UE; ++UI) {
+    Instruction *User = cast<Instruction>(*UI);
+    if (User != I)
+      AnyUse = &UI.getUse();
+    if (SparseOrder.count(User))
+      Users.push_back(User);
+  }
+  return AnyUse;
+}
+
+/// queueReplacement - Load PRE and load widening replace loads with phis and
+/// loads that they create, and load coercion puts casts and shifts in front of
+/// the value it forwards.  The dense engine cleans those up on its next pass
+/// over the function, so queue them here, operands first.  The branches that
+/// end the incoming blocks of a new phi are queued too, so that equalities they
+/// imply reach its operands.  Other new instructions, and equalities implied
+/// by branches further up, are left alone.
+void GVN::queueReplacement(Use *U) {
+  if (!U)
+    return;
+  SmallVector<Instruction*, 4> Chain;
+  Value *V = U->get();
+  while (Instruction *I = dyn_cast<Instruction>(V)) {
+    if (SparseOrder.count(I))
+      break;
+    if (isa<PHINode>(I) || isa<LoadInst>(I)) {
+      Chain.push_back(I);
+      break;
+    }
+    if (!isa<CastInst>(I) && !I->isShift())
+      break;
+    Chain.push_back(I);
+    V = I->getOperand(0);
+  }
+
+  // They are numbered after everything else, so isAvailableAt looks at their
+  // positions instead.
+  while (!Chain.empty()) {
+    Instruction *I = Chain.pop_back_val();
+    SparseOrder[I] = NextSparseOrder++;
+    SparseLate.insert(I);
+    queueForRevisit(I);
+    if (PHINode *PN = dyn_cast<PHINode>(I))
+      for (unsigned i = 0, e = PN->getNumIncomingValues(); i != e; ++i)
+        queueForRevisit(PN->getIncomingBlock(i)->getTerminator());
+  }
+}
+
+/// queueForRevisit - Add 'I' to the sparse worklist, unless the walk has not
+/// reached it yet or it is already queued.
+void GVN::queueForRevisit(Instruction *I) {
+  DenseMap<const Instruction*, unsigned>::iterator It = SparseOrder.find(I);
+  if (It == SparseOrder.end())
+    return;
+  if (SparseQueued.insert(I))
+    SparseWorklist.push(std::make_pair(It->second, I));
+}
+
 void GVN::cleanupGlobalSets() {
   VN.clear();
   LeaderTable.clear();
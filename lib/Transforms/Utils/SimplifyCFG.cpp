@@ -65,6 +65,7 @@ HoistCondStores("simplifycfg-hoist-cond-stores", cl::Hidden, cl::init(true),
 
 STATISTIC(NumBitMaps, "Number of switch instructions turned into bitmaps");
 STATISTIC(NumLookupTables, "Number of switch instructions turned into lookup tables");
+STATISTIC(NumSwitchSelects, "Number of switch instructions turned into selects");
 STATISTIC(NumSinkCommons, "Number of common instructions sunk down to the end block");
 STATISTIC(NumSpeculations, "Number of speculative executed instructions");
 
@@ -1448,7 +1449,8 @@ static Value *isSafeToSpeculateStore(Instruction *I, BasicBlock *BrBB,
 /// \endcode
 ///
 /// \returns true if the conditional block is removed.
-static bool SpeculativelyExecuteBB(BranchInst *BI, BasicBlock *ThenBB) {
+bool llvm::SpeculativelyExecuteBB(BranchInst *BI, BasicBlock *ThenBB,
+                                  unsigned Threshold) {
   // Be conservative for now. FP select instruction can often be expensive.
   Value *BrCond = BI->getCondition();
   if (isa<FCmpInst>(BrCond))
@@ -1497,7 +1499,7 @@ static bool SpeculativelyExecuteBB(BranchInst *BI, BasicBlock *ThenBB) {
                                                          EndBB))))
       return false;
     if (!SpeculatedStoreValue &&
-        ComputeSpeculationCost(I) > PHINodeFoldingThreshold)
+        ComputeSpeculationCost(I) > Threshold)
       return false;
 
     // Store the store speculation candidate.
@@ -1553,7 +1555,7 @@ static bool SpeculativelyExecuteBB(BranchInst *BI, BasicBlock *ThenBB) {
       return false;
     unsigned OrigCost = OrigCE ? ComputeSpeculationCost(OrigCE) : 0;
     unsigned ThenCost = ThenCE ? ComputeSpeculationCost(ThenCE) : 0;
-    if (OrigCost + ThenCost > 2 * PHINodeFoldingThreshold)
+    if (OrigCost + ThenCost > 2 * Threshold)
       return false;
 
     // Account for the cost of an unfolded ConstantExpr which could end up
@@ -1744,7 +1746,8 @@ static bool FoldCondBranchOnPHI(BranchInst *BI, const DataLayout *TD) {
 
 /// FoldTwoEntryPHINode - Given a BB that starts with the specified two-entry
 /// PHI node, see if we can eliminate it.
-static bool FoldTwoEntryPHINode(PHINode *PN, const DataLayout *TD) {
+bool llvm::FoldTwoEntryPHINode(PHINode *PN, const DataLayout *TD,
+                               unsigned Threshold) {
   // Ok, this is a two entry PHI node.  Check to see if this is a simple "if
   // statement", which has a very simple dominance structure.  Basically, we
   // are trying to find the condition that is being branched on, which
@@ -1773,8 +1776,7 @@ static bool FoldTwoEntryPHINode(PHINode *PN, const DataLayout *TD) {
   // instructions.  While we are at it, keep track of the instructions
   // that need to be moved to the dominating block.
   SmallPtrSet<Instruction*, 4> AggressiveInsts;
-  unsigned MaxCostVal0 = PHINodeFoldingThreshold,
-           MaxCostVal1 = PHINodeFoldingThreshold;
+  unsigned MaxCostVal0 = Threshold, MaxCostVal1 = Threshold;
 
   for (BasicBlock::iterator II = BB->begin(); isa<PHINode>(II);) {
     PHINode *PN = cast<PHINode>(II++);
@@ -1878,6 +1880,150 @@ static bool FoldTwoEntryPHINode(PHINode *PN, const DataLayout *TD) {
   return true;
 }
 
+/// FoldSwitchToSelects - Turn a switch whose destinations are small arms
+/// branching to a common merge block, or the merge block itself, into compares
+/// and selects.  For example:
+/// \code
+///   BB:
+///     switch i32 %x, label %Merge [ i32 1, label %A
+///                                   i32 2, label %B ]
+///   A:
+///     %a = add i32 %y, 1
+///     br label %Merge
+///   B:
+///     br label %Merge
+///   Merge:
+///     %r = phi i32 [ %a, %A ], [ 7, %B ], [ %y, %BB ]
+/// \endcode
+/// becomes
+/// \code
+///   BB:
+///     %a = add i32 %y, 1
+///     %0 = icmp eq i32 %x, 1
+///     %1 = icmp eq i32 %x, 2
+///     %2 = select i1 %1, i32 7, i32 %y
+///     %3 = select i1 %0, i32 %a, i32 %2
+///     br label %Merge
+///   Merge:
+///     %r = phi i32 [ %3, %BB ]
+/// \endcode
+bool llvm::FoldSwitchToSelects(SwitchInst *SI, const DataLayout *TD,
+                               unsigned Threshold) {
+  BasicBlock *BB = SI->getParent();
+  if (SI->getNumCases() == 0 || SI->getNumCases() > Threshold ||
+      isa<Constant>(SI->getCondition()))
+    return false;
+
+  // Sort the destinations into arms, which are only reached from BB and fall
+  // through to the merge block, and the merge block itself.
+  BasicBlock *Merge = 0;
+  SmallVector<BasicBlock*, 4> Arms;
+  SmallPtrSet<BasicBlock*, 4> ArmSet;
+  for (unsigned i = 0, e = SI->getNumSuccessors(); i != e; ++i) {
+    BasicBlock *Succ = SI->getSuccessor(i);
+    if (ArmSet.count(Succ))
+      continue;
+    BasicBlock *Dest = Succ;
+    BranchInst *BI = dyn_cast<BranchInst>(Succ->getTerminator());
+    if (Succ != Merge && Succ->getUniquePredecessor() == BB &&
+        BI && BI->isUnconditional()) {
+      Dest = BI->getSuccessor(0);
+      ArmSet.insert(Succ);
+      Arms.push_back(Succ);
+    }
+    if (Merge && Dest != Merge)
+      return false;
+    Merge = Dest;
+  }
+  if (Merge == BB || Arms.empty())
+    return false;
+
+  // Like FoldTwoEntryPHINode, don't turn more than two PHI nodes into selects.
+  unsigned NumPhis = 0;
+  for (BasicBlock::iterator I = Merge->begin(); isa<PHINode>(I); ++I)
+    if (++NumPhis > 2)
+      return false;
+
+  // Every arm has to be cheap and safe to execute unconditionally.
+  for (unsigned i = 0, e = Arms.size(); i != e; ++i) {
+    unsigned Cost = 0;
+    for (BasicBlock::iterator I = Arms[i]->begin();
+         &*I != Arms[i]->getTerminator(); ++I) {
+      if (isa<DbgInfoIntrinsic>(I))
+        continue;
+      if (isa<PHINode>(I) || !isSafeToSpeculativelyExecute(I))
+        return false;
+      // Check the cost on its own first, it may be UINT_MAX.
+      unsigned InstCost = ComputeSpeculationCost(I);
+      if (InstCost > Threshold || Cost + InstCost > Threshold)
+        return false;
+      Cost += InstCost;
+    }
+  }
+
+  // The incoming constant expressions end up in selects, which evaluate them
+  // unconditionally, so they must not trap either.
+  for (BasicBlock::iterator I = Merge->begin(); isa<PHINode>(I); ++I) {
+    PHINode *PN = cast<PHINode>(I);
+    for (unsigned i = 0, e = PN->getNumIncomingValues(); i != e; ++i) {
+      BasicBlock *Pred = PN->getIncomingBlock(i);
+      if (Pred != BB && !ArmSet.count(Pred))
+        continue;
+      if (ConstantExpr *CE = dyn_cast<ConstantExpr>(PN->getIncomingValue(i)))
+        if (CE->canTrap())
+          return false;
+    }
+  }
+
+  DEBUG(dbgs() << "FOLDING SWITCH TO SELECTS: " << *SI << "\n");
+
+  // Hoist the arms.
+  for (unsigned i = 0, e = Arms.size(); i != e; ++i)
+    BB->getInstList().splice(SI, Arms[i]->getInstList(), Arms[i]->begin(),
+                             Arms[i]->getTerminator());
+
+  IRBuilder<true, NoFolder> Builder(SI);
+  Value *Cond = SI->getCondition();
+  SmallVector<Value*, 4> Cmps;
+  for (SwitchInst::CaseIt CI = SI->case_begin(), CE = SI->case_end();
+       CI != CE; ++CI)
+    Cmps.push_back(Builder.CreateICmpEQ(Cond, CI.getCaseValue()));
+
+  // Build a select chain per PHI node, testing the cases in order and falling
+  // back to the value for the default destination.
+  for (BasicBlock::iterator I = Merge->begin(); isa<PHINode>(I); ++I) {
+    PHINode *PN = cast<PHINode>(I);
+    BasicBlock *Default = SI->getDefaultDest();
+    Value *V =
+      PN->getIncomingValueForBlock(ArmSet.count(Default) ? Default : BB);
+    for (unsigned i = SI->getNumCases(); i-- != 0;) {
+      BasicBlock *Dest = SI->getSuccessor(i + 1);
+      Value *CaseV =
+        PN->getIncomingValueForBlock(ArmSet.count(Dest) ? Dest : BB);
+      if (CaseV != V)
+        V = Builder.CreateSelect(Cmps[i], CaseV, V);
+    }
+
+    for (unsigned i = 0, e = Arms.size(); i != e; ++i)
+      PN->removeIncomingValue(Arms[i], false);
+    while (PN->getBasicBlockIndex(BB) >= 0)
+      PN->removeIncomingValue(BB, false);
+    PN->addIncoming(V, BB);
+  }
+
+  Builder.CreateBr(Merge);
+  SI->eraseFromParent();
+  for (unsigned i = 0, e = Arms.size(); i != e; ++i) {
+    Arms[i]->getTerminator()->eraseFromParent();
+    Arms[i]->eraseFromParent();
+  }
+  for (unsigned i = 0, e = Cmps.size(); i != e; ++i)
+    RecursivelyDeleteTriviallyDeadInstructions(Cmps[i]);
+
+  ++NumSwitchSelects;
+  return true;
+}
+
 /// SimplifyCondBranchToTwoReturns - If we found a conditional branch that goes
 /// to two returning blocks, try to merge them together into one return,
 /// introducing a select if the return values disagree.
@@ -4009,7 +4155,8 @@ bool SimplifyCFGOpt::SimplifyCondBranch(BranchInst *BI, IRBuilder<> &Builder) {
       TerminatorInst *Succ0TI = BI->getSuccessor(0)->getTerminator();
       if (Succ0TI->getNumSuccessors() == 1 &&
           Succ0TI->getSuccessor(0) == BI->getSuccessor(1))
-        if (SpeculativelyExecuteBB(BI, BI->getSuccessor(0)))
+        if (SpeculativelyExecuteBB(BI, BI->getSuccessor(0),
+                                   PHINodeFoldingThreshold))
           return SimplifyCFG(BB, TTI, TD) | true;
     }
   } else if (BI->getSuccessor(1)->getSinglePredecessor() != 0) {
@@ -4018,7 +4165,8 @@ bool SimplifyCFGOpt::SimplifyCondBranch(BranchInst *BI, IRBuilder<> &Builder) {
     TerminatorInst *Succ1TI = BI->getSuccessor(1)->getTerminator();
     if (Succ1TI->getNumSuccessors() == 1 &&
         Succ1TI->getSuccessor(0) == BI->getSuccessor(0))
-      if (SpeculativelyExecuteBB(BI, BI->getSuccessor(1)))
+      if (SpeculativelyExecuteBB(BI, BI->getSuccessor(1),
+                                 PHINodeFoldingThreshold))
         return SimplifyCFG(BB, TTI, TD) | true;
   }
 
@@ -4146,7 +4294,7 @@ bool SimplifyCFGOpt::run(BasicBlock *BB) {
   // eliminate it, do so now.
   if (PHINode *PN = dyn_cast<PHINode>(BB->begin()))
     if (PN->getNumIncomingValues() == 2)
-      Changed |= FoldTwoEntryPHINode(PN, TD);
+      Changed |= FoldTwoEntryPHINode(PN, TD, PHINodeFoldingThreshold);
 
   Builder.SetInsertPoint(BB->getTerminator());
   if (BranchInst *BI = dyn_cast<BranchInst>(BB->getTerminator())) {
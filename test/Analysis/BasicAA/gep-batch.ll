@@ -0,0 +1,48 @@
+; RUN: opt < %s -basicaa -aa-eval -print-all-alias-modref-info -disable-output 2>&1 | FileCheck %s
+
+; aa-eval asks for all pairs as one batch, during which BasicAA decomposes
+; each GEP only once. Every GEP here takes part in several queries with
+; different partners, which must all still see their own offsets.
+
+; CHECK: Function: f: 7 pointers, 0 call sites
+; CHECK: MustAlias: %pair* %p, i32* %p0
+; CHECK: PartialAlias: %pair* %p, i32* %p1
+; CHECK: NoAlias: i32* %p0, i32* %p1
+; CHECK: NoAlias: %pair* %p, i32* %q0
+; CHECK: NoAlias: i32* %p0, i32* %q0
+; CHECK: NoAlias: i32* %p1, i32* %q0
+; CHECK: PartialAlias: %pair* %p, i32* %r0
+; CHECK: PartialAlias: i32* %p0, i32* %r0
+; CHECK: NoAlias: i32* %p1, i32* %r0
+; CHECK: PartialAlias: i32* %q0, i32* %r0
+; CHECK: PartialAlias: %pair* %p, i32* %r1
+; CHECK: NoAlias: i32* %p0, i32* %r1
+; CHECK: PartialAlias: i32* %p1, i32* %r1
+; CHECK: NoAlias: i32* %q0, i32* %r1
+; CHECK: NoAlias: i32* %r0, i32* %r1
+; CHECK: PartialAlias: %pair* %p, i32* %s1
+; CHECK: NoAlias: i32* %p0, i32* %s1
+; CHECK: MustAlias: i32* %p1, i32* %s1
+; CHECK: NoAlias: i32* %q0, i32* %s1
+; CHECK: NoAlias: i32* %r0, i32* %s1
+; CHECK: PartialAlias: i32* %r1, i32* %s1
+
+target datalayout = "e-p:64:64:64-i32:32:32-i64:64:64-n32:64"
+
+%pair = type { i32, i32 }
+
+define void @f(%pair* %p, i64 %i) {
+  %p0 = getelementptr inbounds %pair* %p, i64 0, i32 0
+  %p1 = getelementptr inbounds %pair* %p, i64 0, i32 1
+  %q0 = getelementptr inbounds %pair* %p, i64 1, i32 0
+  %r0 = getelementptr inbounds %pair* %p, i64 %i, i32 0
+  %r1 = getelementptr inbounds %pair* %p, i64 %i, i32 1
+  %s1 = getelementptr inbounds i32* %p0, i64 1
+  store i32 0, i32* %p0
+  store i32 0, i32* %p1
+  store i32 0, i32* %q0
+  store i32 0, i32* %r0
+  store i32 0, i32* %r1
+  store i32 0, i32* %s1
+  ret void
+}
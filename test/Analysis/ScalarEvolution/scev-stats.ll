@@ -0,0 +1,47 @@
+; RUN: opt < %s -indvars -scev-stats -disable-output 2>&1 | FileCheck %s
+; RUN: opt < %s -indvars -verify-scev -scev-stats -disable-output 2>&1 | FileCheck %s --check-prefix=VERIFY
+
+; -scev-stats prints one record per function when ScalarEvolution releases
+; its caches: function, values, unique SCEVs, arena bytes, scope entries,
+; backedge-taken counts, then lookups and hits for getSCEV, getSCEVAtScope
+; and the backedge-taken counts, and the number of counts forgotten.
+
+; The loop's trip count is computed once and then reused, and its exit values
+; are evaluated outside the loop.
+; CHECK: scev-stats,sum,{{[1-9][0-9]*}},{{[1-9][0-9]*}},{{[0-9]+}},{{[1-9][0-9]*}},1,{{[1-9][0-9]*}},{{[1-9][0-9]*}},{{[1-9][0-9]*}},{{[0-9]+}},{{[1-9][0-9]*}},{{[1-9][0-9]*}},{{[0-9]+}}
+; CHECK: scev-stats,empty,0,0,{{[0-9]+}},0,0,0,0,0,0,0,0,0
+
+; -verify-scev releases the caches once more in the middle of the function, but
+; each function still gets exactly one record.
+; VERIFY: scev-stats,sum,
+; VERIFY-NOT: scev-stats,sum,
+; VERIFY: scev-stats,empty,
+; VERIFY-NOT: scev-stats
+
+target datalayout = "e-p:64:64:64-i32:32:32-i64:64:64-n32:64"
+
+define i32 @sum(i32* %a, i32 %n) {
+entry:
+  %cmp1 = icmp sgt i32 %n, 0
+  br i1 %cmp1, label %loop, label %exit
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %s = phi i32 [ 0, %entry ], [ %s.next, %loop ]
+  %p = getelementptr inbounds i32* %a, i32 %i
+  %v = load i32* %p
+  %s.next = add i32 %s, %v
+  %i.next = add nsw i32 %i, 1
+  %cmp = icmp slt i32 %i.next, %n
+  br i1 %cmp, label %loop, label %exit
+
+exit:
+  %r = phi i32 [ 0, %entry ], [ %s.next, %loop ]
+  %last = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %t = add i32 %r, %last
+  ret i32 %t
+}
+
+define void @empty() {
+  ret void
+}
@@ -0,0 +1,50 @@
+; Check that the function bodies are indexed, and that the index is used to
+; find them when loading the module.
+; RUN: llvm-as < %s | llvm-bcanalyzer -dump | FileCheck %s
+; RUN: llvm-as < %s | opt -S | FileCheck %s --check-prefix=IR
+; RUN: llvm-as -enable-bc-uselist-preserve < %s | opt -S \
+; RUN:   | FileCheck %s --check-prefix=IR
+; RUN: llvm-as < %s | llvm-extract -func=g -S | FileCheck %s --check-prefix=G
+; RUN: llvm-as -bitcode-function-index=false < %s | llvm-bcanalyzer -dump \
+; RUN:   | FileCheck %s --check-prefix=NOINDEX
+; RUN: llvm-as -bitcode-function-index=false < %s | opt -S \
+; RUN:   | FileCheck %s --check-prefix=IR
+
+; CHECK: <FNINDEXOFFSET
+; CHECK: <FUNCTION_INDEX_BLOCK
+; CHECK-NEXT: <ENTRY {{.*}}/> function block #0
+; CHECK-NEXT: <ENTRY {{.*}}/> function block #1
+; CHECK-NEXT: <ENTRY {{.*}}/> function block #2
+; CHECK-NEXT: </FUNCTION_INDEX_BLOCK>
+; CHECK-NEXT: </MODULE_BLOCK>
+
+; NOINDEX-NOT: FNINDEXOFFSET
+; NOINDEX-NOT: FUNCTION_INDEX_BLOCK
+
+declare i32 @ext(i32)
+
+; IR: define i32 @f(i32 %x)
+; IR-NEXT: add i32 %x, 1
+define i32 @f(i32 %x) {
+  %y = add i32 %x, 1
+  ret i32 %y
+}
+
+; IR: define i32 @g(i32 %x)
+; IR-NEXT: call i32 @f(i32 %x)
+; IR-NEXT: mul i32 %y, 3
+; G: declare i32 @f(i32)
+; G: define i32 @g(i32 %x)
+; G-NEXT: call i32 @f(i32 %x)
+define i32 @g(i32 %x) {
+  %y = call i32 @f(i32 %x)
+  %z = mul i32 %y, 3
+  ret i32 %z
+}
+
+; IR: define i32 @h(i32 %x)
+; IR-NEXT: call i32 @ext(i32 %x)
+define i32 @h(i32 %x) {
+  %y = call i32 @ext(i32 %x)
+  ret i32 %y
+}
@@ -0,0 +1,64 @@
+; Check that writing the function bodies with several threads gives the same
+; bitcode as writing them with one.
+; RUN: llvm-link -j 1 %s -o %t.1.bc
+; RUN: llvm-link -j 3 %s -o %t.3.bc
+; RUN: cmp %t.1.bc %t.3.bc
+; RUN: llvm-bcanalyzer -dump %t.3.bc | FileCheck %s
+; RUN: opt -S %t.3.bc | FileCheck %s --check-prefix=IR
+
+; CHECK: <FUNCTION_INDEX_BLOCK
+; CHECK-NEXT: function block #0
+; CHECK-NEXT: function block #1
+; CHECK-NEXT: function block #2
+; CHECK-NEXT: function block #3
+; CHECK-NEXT: function block #4
+; CHECK-NEXT: </FUNCTION_INDEX_BLOCK>
+
+@p = global i8* blockaddress(@d, %target)
+
+; IR: define i32 @a(i32 %x)
+; IR-NEXT: add i32 %x, 1
+define i32 @a(i32 %x) {
+  %y = add i32 %x, 1
+  ret i32 %y
+}
+
+; IR: define i32 @b(i32 %x)
+; IR-NEXT: call i32 @a(i32 %x)
+define i32 @b(i32 %x) {
+  %y = call i32 @a(i32 %x)
+  %z = mul i32 %y, 3
+  ret i32 %z
+}
+
+; IR: define double @c(double %x)
+; IR-NEXT: fadd double %x, 2.500000e+00, !tag !0
+define double @c(double %x) {
+  %y = fadd double %x, 2.5, !tag !0
+  ret double %y
+}
+
+; IR: define void @d()
+; IR: target:
+define void @d() {
+entry:
+  br label %target
+target:
+  ret void
+}
+
+; IR: define i32 @e(i32 %x)
+; IR: phi i32 [ 0, %entry ], [ %next, %loop ]
+define i32 @e(i32 %x) {
+entry:
+  br label %loop
+loop:
+  %i = phi i32 [ 0, %entry ], [ %next, %loop ]
+  %next = add i32 %i, 1
+  %done = icmp eq i32 %next, %x
+  br i1 %done, label %exit, label %loop
+exit:
+  ret i32 %i
+}
+
+!0 = metadata !{metadata !"tag"}
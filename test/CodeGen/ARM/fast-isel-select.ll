@@ -98,3 +98,35 @@ entry:
   %0 = select i1 %c, i32 %a, i32 -978945
   ret i32 %0
 }
+
+define void @t7(i1 %c, float* %p, float* %q) nounwind {
+entry:
+; ARM: t7
+; ARM: cmp r0, #0
+; ARM: vmovne.f32 s{{[0-9]+}}, s{{[0-9]+}}
+; THUMB: t7
+; THUMB: cmp r0, #0
+; THUMB: it ne
+; THUMB: vmovne.f32 s{{[0-9]+}}, s{{[0-9]+}}
+  %a = load float* %p
+  %b = load float* %q
+  %0 = select i1 %c, float %a, float %b
+  store float %0, float* %p
+  ret void
+}
+
+define void @t8(i1 %c, double* %p, double* %q) nounwind {
+entry:
+; ARM: t8
+; ARM: cmp r0, #0
+; ARM: vmovne.f64 d{{[0-9]+}}, d{{[0-9]+}}
+; THUMB: t8
+; THUMB: cmp r0, #0
+; THUMB: it ne
+; THUMB: vmovne.f64 d{{[0-9]+}}, d{{[0-9]+}}
+  %a = load double* %p
+  %b = load double* %q
+  %0 = select i1 %c, double %a, double %b
+  store double %0, double* %p
+  ret void
+}
@@ -0,0 +1,21 @@
+; RUN: llc < %s -march=msp430 | FileCheck %s -check-prefix=DEFAULT
+; RUN: llc < %s -march=msp430 -compact-stack-frame -compact-stack-frame-report 2>&1 | FileCheck %s
+
+; DEFAULT: sub.w #38, r1
+
+; CHECK: frame-compaction,f,38,30
+; CHECK: sub.w #30, r1
+
+declare void @use(i8*, i32*, i8*, i32*, i16*, i64*)
+
+define void @f() nounwind {
+entry:
+  %a = alloca i8
+  %b = alloca i32
+  %c = alloca i8
+  %d = alloca i32
+  %e = alloca i16
+  %g = alloca i64
+  call void @use(i8* %a, i32* %b, i8* %c, i32* %d, i16* %e, i64* %g)
+  ret void
+}
@@ -0,0 +1,17 @@
+; RUN: llc < %s -march=r600 -mcpu=verde -print-interference-cache-stats -o /dev/null 2>&1 | FileCheck %s
+; RUN: llc < %s -march=r600 -mcpu=verde -interference-cache-entries=32 -print-interference-cache-stats -o /dev/null 2>&1 | FileCheck %s --check-prefix=OLD
+
+; SI has 256 vector registers, more than the 32 interference cache entries
+; RAGreedy used to be limited to.  The cache is sized for the largest class
+; up to 128 entries, which is also the number of split candidates RAGreedy
+; can keep.
+
+; CHECK: Interference cache for copy: 128 entries
+; OLD: Interference cache for copy: 32 entries
+
+define void @copy(i32 addrspace(1)* %out, i32 addrspace(1)* %in) {
+  %a = load i32 addrspace(1)* %in
+  %b = add i32 %a, 1
+  store i32 %b, i32 addrspace(1)* %out
+  ret void
+}
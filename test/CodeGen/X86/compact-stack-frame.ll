@@ -0,0 +1,42 @@
+; RUN: llc < %s -mtriple=i686-unknown-linux-gnu -verify-machineinstrs | FileCheck %s -check-prefix=DEFAULT
+; RUN: llc < %s -mtriple=i686-unknown-linux-gnu -verify-machineinstrs \
+; RUN:     -compact-stack-frame -compact-stack-frame-report 2>&1 | FileCheck %s
+;
+; The small objects are packed into the padding in front of the aligned
+; ones, and the object accessed in the loop is placed right above the call
+; frame, where the stack pointer reaches it with the smallest offset.
+
+; DEFAULT: subl $60, %esp
+
+; CHECK: frame-compaction,f,60,44
+; CHECK: subl $44, %esp
+; CHECK: %loop
+; CHECK: movl 24(%esp)
+; CHECK: adcl $0, 28(%esp)
+; CHECK: movl %{{e[a-z]+}}, 24(%esp)
+
+declare void @use(i8*, i32*, i8*, i32*, i16*, i64*)
+
+define void @f(i32 %n) nounwind {
+entry:
+  %a = alloca i8
+  %b = alloca i32
+  %c = alloca i8
+  %d = alloca i32
+  %e = alloca i16
+  %g = alloca i64
+  call void @use(i8* %a, i32* %b, i8* %c, i32* %d, i16* %e, i64* %g)
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %v = load i64* %g
+  %v1 = add i64 %v, 1
+  store i64 %v1, i64* %g
+  %i.next = add i32 %i, 1
+  %done = icmp eq i32 %i.next, %n
+  br i1 %done, label %exit, label %loop
+
+exit:
+  ret void
+}
@@ -0,0 +1,12 @@
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -dag-combine-stats -o /dev/null 2>&1 | FileCheck %s
+
+; CHECK: DAG combine of 'f' before type legalization: {{[0-9]+}} visits, {{[1-9][0-9]*}} combined
+; CHECK-NEXT: {{[1-9][0-9]*}} {{[1-9][0-9]*}} add
+; CHECK: DAG combine of 'f' after DAG legalization:
+
+define i32 @f(i32 %x) nounwind {
+  %a = add i32 %x, 1
+  %b = add i32 %a, 2
+  %c = add i32 %b, 3
+  ret i32 %c
+}
@@ -0,0 +1,117 @@
+; RUN: llc < %s -mtriple=x86_64-unknown-linux -mcpu=corei7 -O0 -verify-machineinstrs -fast-isel-abort -fast-isel-report 2> %t | FileCheck %s
+; RUN: FileCheck %s -check-prefix=REPORT < %t
+; RUN: llc < %s -mtriple=x86_64-unknown-linux -mcpu=corei7-avx -O0 -verify-machineinstrs -fast-isel-abort | FileCheck %s -check-prefix=AVX
+; RUN: llc < %s -mtriple=i686-unknown-linux -mcpu=corei7 -O0 -verify-machineinstrs | FileCheck %s -check-prefix=X32
+
+; Every instruction below is selected by FastISel.
+; REPORT: FastISel Fallback Report
+; REPORT: 0 handed to SelectionDAG (0.0%)
+; REPORT-NOT: {{^ +[0-9]+ +[1-9]}}
+
+define void @vec_aligned(<4 x float>* %p, <4 x float>* %q) nounwind {
+; CHECK-LABEL: vec_aligned:
+; CHECK: movaps (%rdi), [[R:%xmm[0-9]+]]
+; CHECK: movaps [[R]], (%rsi)
+; AVX-LABEL: vec_aligned:
+; AVX: vmovaps (%rdi), [[R:%xmm[0-9]+]]
+; AVX: vmovaps [[R]], (%rsi)
+  %v = load <4 x float>* %p, align 16
+  store <4 x float> %v, <4 x float>* %q, align 16
+  ret void
+}
+
+; Under-aligned vector accesses must not use movaps.
+define void @vec_unaligned(<2 x i64>* %p, <2 x i64>* %q) nounwind {
+; CHECK-LABEL: vec_unaligned:
+; CHECK: movdqu (%rdi), [[R:%xmm[0-9]+]]
+; CHECK: movdqu [[R]], (%rsi)
+; AVX-LABEL: vec_unaligned:
+; AVX: vmovdqu (%rdi), [[R:%xmm[0-9]+]]
+; AVX: vmovdqu [[R]], (%rsi)
+  %v = load <2 x i64>* %p, align 8
+  store <2 x i64> %v, <2 x i64>* %q, align 4
+  ret void
+}
+
+define i8 @select_i8(i1 %c, i8 %a, i8 %b) nounwind {
+; CHECK-LABEL: select_i8:
+; CHECK: testb $1,
+; CHECK: cmovel
+; X32-LABEL: select_i8:
+; X32: testb $1,
+; X32: cmovel
+  %s = select i1 %c, i8 %a, i8 %b
+  ret i8 %s
+}
+
+declare {i32, i1} @llvm.ssub.with.overflow.i32(i32, i32)
+declare {i64, i1} @llvm.usub.with.overflow.i64(i64, i64)
+declare {i32, i1} @llvm.smul.with.overflow.i32(i32, i32)
+declare {i32, i1} @llvm.umul.with.overflow.i32(i32, i32)
+
+define void @overflow(i32 %a, i32 %b, i64 %c, i64 %d, i8* %o) nounwind {
+; CHECK-LABEL: overflow:
+; CHECK: subl
+; CHECK-NEXT: seto
+; CHECK: subq
+; CHECK-NEXT: setb
+; CHECK: imull
+; CHECK-NEXT: seto
+; CHECK: mull
+; CHECK: seto
+  %x = call {i32, i1} @llvm.ssub.with.overflow.i32(i32 %a, i32 %b)
+  %x1 = extractvalue {i32, i1} %x, 1
+  %y = call {i64, i1} @llvm.usub.with.overflow.i64(i64 %c, i64 %d)
+  %y1 = extractvalue {i64, i1} %y, 1
+  %z = call {i32, i1} @llvm.smul.with.overflow.i32(i32 %a, i32 %b)
+  %z1 = extractvalue {i32, i1} %z, 1
+  %w = call {i32, i1} @llvm.umul.with.overflow.i32(i32 %a, i32 %b)
+  %w1 = extractvalue {i32, i1} %w, 1
+  %xy = or i1 %x1, %y1
+  %zw = or i1 %z1, %w1
+  %r = or i1 %xy, %zw
+  %r8 = zext i1 %r to i8
+  store i8 %r8, i8* %o
+  ret void
+}
+
+declare void @llvm.memmove.p0i8.p0i8.i64(i8*, i8*, i64, i32, i1)
+declare void @llvm.memcpy.p0i8.p0i8.i64(i8*, i8*, i64, i32, i1)
+
+define void @memfns(i8* %a, i8* %b, i64 %n) nounwind {
+; CHECK-LABEL: memfns:
+; CHECK: callq memmove
+; CHECK: callq memcpy
+  call void @llvm.memmove.p0i8.p0i8.i64(i8* %a, i8* %b, i64 %n, i32 1, i1 false)
+  call void @llvm.memcpy.p0i8.p0i8.i64(i8* %a, i8* %b, i64 %n, i32 1, i1 true)
+  ret void
+}
+
+define i32 @one_case_switch(i32 %x) nounwind {
+; CHECK-LABEL: one_case_switch:
+; CHECK: cmpl $1, %edi
+; CHECK-NEXT: je
+entry:
+  switch i32 %x, label %d [ i32 1, label %a ]
+a:
+  ret i32 10
+d:
+  ret i32 0
+}
+
+define i32 @shared_dest_switch(i32 %x) nounwind {
+; CHECK-LABEL: shared_dest_switch:
+; CHECK: cmpl $1, %edi
+; CHECK-NEXT: sete
+; CHECK: cmpl $7, %edi
+; CHECK-NEXT: sete
+; CHECK: orb
+; CHECK: jne
+entry:
+  switch i32 %x, label %d [ i32 1, label %a
+                            i32 7, label %a ]
+a:
+  ret i32 10
+d:
+  ret i32 0
+}
@@ -0,0 +1,61 @@
+; RUN: llc < %s -mtriple=x86_64-unknown-linux -mcpu=corei7 -O0 -fast-isel-report -o /dev/null 2>&1 | FileCheck %s
+
+; CHECK: FastISel Fallback Report
+; CHECK: 10 instructions selected by FastISel, 9 handed to SelectionDAG (47.4%)
+; CHECK: Misses Instrs Opcode Likely reason
+; CHECK-NEXT: 3 3 switch unsupported
+; CHECK-NEXT: 1 3 select unsupported
+; CHECK-NEXT: 1 3 store illegal type
+; CHECK-NEXT: 1 0 <arguments> unsupported
+
+; FastISel selects bottom-up, so everything above the select in its block is
+; handed to SelectionDAG with it.
+define void @fp_select(i1 %c, double* %p, double* %q) nounwind {
+  %a = load double* %p
+  %b = load double* %q
+  %s = select i1 %c, double %a, double %b
+  store double %s, double* %p
+  ret void
+}
+
+define void @wide_add(i128* %p) nounwind {
+  %a = load i128* %p
+  %b = add i128 %a, 1
+  store i128 %b, i128* %p
+  ret void
+}
+
+define i32 @switch(i32 %x) nounwind {
+entry:
+  switch i32 %x, label %d [ i32 1, label %a
+                            i32 7, label %b ]
+a:
+  ret i32 10
+b:
+  ret i32 20
+d:
+  ret i32 0
+}
+
+; Four or more cases are left to SelectionDAG even if they share a block.
+define i32 @four_cases(i32 %x) nounwind {
+entry:
+  switch i32 %x, label %d [ i32 1, label %a
+                            i32 2, label %a
+                            i32 3, label %a
+                            i32 4, label %a ]
+a:
+  ret i32 10
+d:
+  ret i32 0
+}
+
+; So are cases with a value that does not fit an immediate.
+define i64 @wide_case(i64 %x) nounwind {
+entry:
+  switch i64 %x, label %d [ i64 4294967296, label %a ]
+a:
+  ret i64 10
+d:
+  ret i64 0
+}
@@ -0,0 +1,59 @@
+; RUN: llc < %s -mtriple=x86_64-unknown-linux -O0 -verify-machineinstrs -fast-isel-abort -fast-isel-report 2> %t | FileCheck %s
+; RUN: FileCheck %s -check-prefix=REPORT < %t
+
+; Switches with fewer than four cases that all go to one block are selected by
+; FastISel as compares and a single conditional branch.
+
+; REPORT: FastISel Fallback Report
+; REPORT: 0 handed to SelectionDAG (0.0%)
+
+define i32 @three_cases(i32 %x) nounwind {
+; CHECK-LABEL: three_cases:
+; CHECK: cmpl $1, %edi
+; CHECK-NEXT: sete
+; CHECK: cmpl $5, %edi
+; CHECK-NEXT: sete
+; CHECK: orb
+; CHECK: cmpl $9, %edi
+; CHECK-NEXT: sete
+; CHECK: orb
+; CHECK: testb
+; CHECK-NEXT: jne
+entry:
+  switch i32 %x, label %d [ i32 1, label %a
+                            i32 5, label %a
+                            i32 9, label %a ]
+a:
+  ret i32 10
+d:
+  ret i32 0
+}
+
+define i64 @i64_cases(i64 %x) nounwind {
+; CHECK-LABEL: i64_cases:
+; CHECK: cmpq $-1, %rdi
+; CHECK-NEXT: sete
+; CHECK: cmpq $3, %rdi
+; CHECK-NEXT: sete
+; CHECK: jne
+entry:
+  switch i64 %x, label %d [ i64 -1, label %a
+                            i64 3, label %a ]
+a:
+  ret i64 10
+d:
+  ret i64 0
+}
+
+; Every case goes to the default block, so only an unconditional branch is
+; needed.
+define i32 @default_only(i32 %x) nounwind {
+; CHECK-LABEL: default_only:
+; CHECK-NOT: cmp
+; CHECK: ret
+entry:
+  switch i32 %x, label %d [ i32 1, label %d
+                            i32 2, label %d ]
+d:
+  ret i32 0
+}
@@ -0,0 +1,69 @@
+; REQUIRES: asserts
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -verify-machineinstrs -stats 2>&1 | FileCheck %s --check-prefix=FULL
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -verify-machineinstrs -greedy-work-budget=1 -stats 2>&1 | FileCheck %s --check-prefix=TIERS
+;
+; Check that the greedy allocator degrades in tiers once it has spent its work
+; budget on a function, and that the result is still correct.
+;
+; FULL-NOT: work budget
+; FULL-NOT: to stay in budget
+
+; TIERS: 1 regalloc {{.*}} Number of functions allocated without region splitting past the work budget
+; TIERS: 1 regalloc {{.*}} Number of functions that fell back to spilling past the work budget
+; TIERS: regalloc {{.*}} Number of live ranges spilled without splitting to stay in budget
+
+declare void @clobber()
+
+define void @pressure(i32* %p) nounwind {
+entry:
+  %a0 = getelementptr i32* %p, i64 0
+  %v0 = load volatile i32* %a0
+  %a1 = getelementptr i32* %p, i64 1
+  %v1 = load volatile i32* %a1
+  %a2 = getelementptr i32* %p, i64 2
+  %v2 = load volatile i32* %a2
+  %a3 = getelementptr i32* %p, i64 3
+  %v3 = load volatile i32* %a3
+  %a4 = getelementptr i32* %p, i64 4
+  %v4 = load volatile i32* %a4
+  %a5 = getelementptr i32* %p, i64 5
+  %v5 = load volatile i32* %a5
+  %a6 = getelementptr i32* %p, i64 6
+  %v6 = load volatile i32* %a6
+  %a7 = getelementptr i32* %p, i64 7
+  %v7 = load volatile i32* %a7
+  %a8 = getelementptr i32* %p, i64 8
+  %v8 = load volatile i32* %a8
+  %a9 = getelementptr i32* %p, i64 9
+  %v9 = load volatile i32* %a9
+  %a10 = getelementptr i32* %p, i64 10
+  %v10 = load volatile i32* %a10
+  %a11 = getelementptr i32* %p, i64 11
+  %v11 = load volatile i32* %a11
+  %a12 = getelementptr i32* %p, i64 12
+  %v12 = load volatile i32* %a12
+  %a13 = getelementptr i32* %p, i64 13
+  %v13 = load volatile i32* %a13
+  %a14 = getelementptr i32* %p, i64 14
+  %v14 = load volatile i32* %a14
+  %a15 = getelementptr i32* %p, i64 15
+  %v15 = load volatile i32* %a15
+  call void @clobber()
+  store volatile i32 %v15, i32* %a0
+  store volatile i32 %v14, i32* %a1
+  store volatile i32 %v13, i32* %a2
+  store volatile i32 %v12, i32* %a3
+  store volatile i32 %v11, i32* %a4
+  store volatile i32 %v10, i32* %a5
+  store volatile i32 %v9, i32* %a6
+  store volatile i32 %v8, i32* %a7
+  store volatile i32 %v7, i32* %a8
+  store volatile i32 %v6, i32* %a9
+  store volatile i32 %v5, i32* %a10
+  store volatile i32 %v4, i32* %a11
+  store volatile i32 %v3, i32* %a12
+  store volatile i32 %v2, i32* %a13
+  store volatile i32 %v1, i32* %a14
+  store volatile i32 %v0, i32* %a15
+  ret void
+}
@@ -0,0 +1,63 @@
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -verify-machineinstrs -print-interference-cache-stats -o /dev/null 2>&1 | FileCheck %s
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -verify-machineinstrs -interference-cache-entries=2 -print-interference-cache-stats -o /dev/null 2>&1 | FileCheck %s --check-prefix=SMALL
+;
+; The interference cache has at least 32 entries, and enough for the largest
+; register class. With only two entries, global splitting still works but has
+; to keep replacing them.
+;
+; CHECK: Interference cache for loop: 32 entries, {{[0-9]+}} hits, {{[0-9]+}} misses, 0 evictions
+; SMALL: Interference cache for loop: 2 entries, {{[0-9]+}} hits, {{[0-9]+}} misses, {{[1-9][0-9]*}} evictions
+
+declare void @clobber()
+
+define i32 @loop(i32* %p, i32 %n) nounwind {
+entry:
+  %a0 = getelementptr i32* %p, i64 0
+  %v0 = load volatile i32* %a0
+  %a1 = getelementptr i32* %p, i64 1
+  %v1 = load volatile i32* %a1
+  %a2 = getelementptr i32* %p, i64 2
+  %v2 = load volatile i32* %a2
+  %a3 = getelementptr i32* %p, i64 3
+  %v3 = load volatile i32* %a3
+  %a4 = getelementptr i32* %p, i64 4
+  %v4 = load volatile i32* %a4
+  %a5 = getelementptr i32* %p, i64 5
+  %v5 = load volatile i32* %a5
+  %a6 = getelementptr i32* %p, i64 6
+  %v6 = load volatile i32* %a6
+  %a7 = getelementptr i32* %p, i64 7
+  %v7 = load volatile i32* %a7
+  %a8 = getelementptr i32* %p, i64 8
+  %v8 = load volatile i32* %a8
+  %a9 = getelementptr i32* %p, i64 9
+  %v9 = load volatile i32* %a9
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %latch ]
+  %c = icmp slt i32 %i, 5
+  br i1 %c, label %call, label %latch
+
+call:
+  call void @clobber()
+  br label %latch
+
+latch:
+  store volatile i32 %v9, i32* %a0
+  store volatile i32 %v8, i32* %a1
+  store volatile i32 %v7, i32* %a2
+  store volatile i32 %v6, i32* %a3
+  store volatile i32 %v5, i32* %a4
+  store volatile i32 %v4, i32* %a5
+  store volatile i32 %v3, i32* %a6
+  store volatile i32 %v2, i32* %a7
+  store volatile i32 %v1, i32* %a8
+  store volatile i32 %v0, i32* %a9
+  %i.next = add i32 %i, 1
+  %done = icmp eq i32 %i.next, %n
+  br i1 %done, label %exit, label %loop
+
+exit:
+  ret i32 %v0
+}
@@ -0,0 +1,128 @@
+; RUN: llc < %s -mtriple=x86_64-unknown-linux -mcpu=corei7 -verify-machineinstrs -o %t.seq
+; RUN: llc < %s -mtriple=x86_64-unknown-linux -mcpu=corei7 -verify-machineinstrs -live-interval-threads=4 -o %t.par
+; RUN: diff %t.seq %t.par
+
+; Live intervals computed in parallel chunks of virtual registers must be
+; identical to the sequential ones, so the generated code is too.
+
+define i32 @f(i32* %p, i32 %n) nounwind {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %latch ]
+  %acc = phi i32 [ 0, %entry ], [ %acc.next, %latch ]
+  %a0 = getelementptr i32* %p, i32 0
+  %v0 = load i32* %a0
+  %a1 = getelementptr i32* %p, i32 1
+  %v1 = load i32* %a1
+  %a2 = getelementptr i32* %p, i32 2
+  %v2 = load i32* %a2
+  %a3 = getelementptr i32* %p, i32 3
+  %v3 = load i32* %a3
+  %a4 = getelementptr i32* %p, i32 4
+  %v4 = load i32* %a4
+  %a5 = getelementptr i32* %p, i32 5
+  %v5 = load i32* %a5
+  %a6 = getelementptr i32* %p, i32 6
+  %v6 = load i32* %a6
+  %a7 = getelementptr i32* %p, i32 7
+  %v7 = load i32* %a7
+  %a8 = getelementptr i32* %p, i32 8
+  %v8 = load i32* %a8
+  %a9 = getelementptr i32* %p, i32 9
+  %v9 = load i32* %a9
+  %a10 = getelementptr i32* %p, i32 10
+  %v10 = load i32* %a10
+  %a11 = getelementptr i32* %p, i32 11
+  %v11 = load i32* %a11
+  %a12 = getelementptr i32* %p, i32 12
+  %v12 = load i32* %a12
+  %a13 = getelementptr i32* %p, i32 13
+  %v13 = load i32* %a13
+  %a14 = getelementptr i32* %p, i32 14
+  %v14 = load i32* %a14
+  %a15 = getelementptr i32* %p, i32 15
+  %v15 = load i32* %a15
+  %a16 = getelementptr i32* %p, i32 16
+  %v16 = load i32* %a16
+  %a17 = getelementptr i32* %p, i32 17
+  %v17 = load i32* %a17
+  %a18 = getelementptr i32* %p, i32 18
+  %v18 = load i32* %a18
+  %a19 = getelementptr i32* %p, i32 19
+  %v19 = load i32* %a19
+  %a20 = getelementptr i32* %p, i32 20
+  %v20 = load i32* %a20
+  %a21 = getelementptr i32* %p, i32 21
+  %v21 = load i32* %a21
+  %a22 = getelementptr i32* %p, i32 22
+  %v22 = load i32* %a22
+  %a23 = getelementptr i32* %p, i32 23
+  %v23 = load i32* %a23
+  %s0 = mul i32 %v0, %v7
+  %t0 = add i32 %acc, %s0
+  %s1 = mul i32 %v1, %v8
+  %t1 = add i32 %t0, %s1
+  %s2 = mul i32 %v2, %v9
+  %t2 = add i32 %t1, %s2
+  %s3 = mul i32 %v3, %v10
+  %t3 = add i32 %t2, %s3
+  %s4 = mul i32 %v4, %v11
+  %t4 = add i32 %t3, %s4
+  %s5 = mul i32 %v5, %v12
+  %t5 = add i32 %t4, %s5
+  %s6 = mul i32 %v6, %v13
+  %t6 = add i32 %t5, %s6
+  %s7 = mul i32 %v7, %v14
+  %t7 = add i32 %t6, %s7
+  %s8 = mul i32 %v8, %v15
+  %t8 = add i32 %t7, %s8
+  %s9 = mul i32 %v9, %v16
+  %t9 = add i32 %t8, %s9
+  %s10 = mul i32 %v10, %v17
+  %t10 = add i32 %t9, %s10
+  %s11 = mul i32 %v11, %v18
+  %t11 = add i32 %t10, %s11
+  %s12 = mul i32 %v12, %v19
+  %t12 = add i32 %t11, %s12
+  %s13 = mul i32 %v13, %v20
+  %t13 = add i32 %t12, %s13
+  %s14 = mul i32 %v14, %v21
+  %t14 = add i32 %t13, %s14
+  %s15 = mul i32 %v15, %v22
+  %t15 = add i32 %t14, %s15
+  %s16 = mul i32 %v16, %v23
+  %t16 = add i32 %t15, %s16
+  %s17 = mul i32 %v17, %v0
+  %t17 = add i32 %t16, %s17
+  %s18 = mul i32 %v18, %v1
+  %t18 = add i32 %t17, %s18
+  %s19 = mul i32 %v19, %v2
+  %t19 = add i32 %t18, %s19
+  %s20 = mul i32 %v20, %v3
+  %t20 = add i32 %t19, %s20
+  %s21 = mul i32 %v21, %v4
+  %t21 = add i32 %t20, %s21
+  %s22 = mul i32 %v22, %v5
+  %t22 = add i32 %t21, %s22
+  %s23 = mul i32 %v23, %v6
+  %t23 = add i32 %t22, %s23
+  %odd = and i32 %i, 1
+  %c = icmp eq i32 %odd, 0
+  br i1 %c, label %even, label %latch
+
+even:
+  %x = xor i32 %t23, %v3
+  store i32 %x, i32* %p
+  br label %latch
+
+latch:
+  %acc.next = phi i32 [ %t23, %loop ], [ %x, %even ]
+  %i.next = add i32 %i, 1
+  %done = icmp eq i32 %i.next, %n
+  br i1 %done, label %exit, label %loop
+
+exit:
+  ret i32 %acc.next
+}
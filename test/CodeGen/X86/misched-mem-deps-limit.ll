@@ -0,0 +1,58 @@
+; RUN: llc < %s -march=x86-64 -mcpu=core2 -enable-misched -verify-machineinstrs \
+; RUN:     -sched-mem-deps-limit=4 -stats 2>&1 | FileCheck %s
+; RUN: llc < %s -march=x86-64 -mcpu=core2 -enable-misched -verify-machineinstrs \
+; RUN:     -stats 2>&1 | FileCheck %s -check-prefix=NOLIMIT
+; REQUIRES: asserts
+;
+; Every load through %p may alias every store to a global, so without a
+; limit each load gets an edge to each store. With a limit of four tracked
+; memory operations the DAG builder inserts barriers instead.
+;
+; CHECK: 3 misched - Number of barriers inserted to cap memory tracking
+; CHECK: 26 misched - Number of memory dependence edges
+; NOLIMIT-NOT: Number of barriers inserted
+; NOLIMIT: 64 misched - Number of memory dependence edges
+
+@g0 = global i32 0
+@g1 = global i32 0
+@g2 = global i32 0
+@g3 = global i32 0
+@g4 = global i32 0
+@g5 = global i32 0
+@g6 = global i32 0
+@g7 = global i32 0
+
+define i32 @f(i32* %p) nounwind {
+entry:
+  store i32 0, i32* @g0
+  store i32 1, i32* @g1
+  store i32 2, i32* @g2
+  store i32 3, i32* @g3
+  store i32 4, i32* @g4
+  store i32 5, i32* @g5
+  store i32 6, i32* @g6
+  store i32 7, i32* @g7
+  %l0 = load i32* %p
+  %q1 = getelementptr i32* %p, i64 1
+  %l1 = load i32* %q1
+  %q2 = getelementptr i32* %p, i64 2
+  %l2 = load i32* %q2
+  %q3 = getelementptr i32* %p, i64 3
+  %l3 = load i32* %q3
+  %q4 = getelementptr i32* %p, i64 4
+  %l4 = load i32* %q4
+  %q5 = getelementptr i32* %p, i64 5
+  %l5 = load i32* %q5
+  %q6 = getelementptr i32* %p, i64 6
+  %l6 = load i32* %q6
+  %q7 = getelementptr i32* %p, i64 7
+  %l7 = load i32* %q7
+  %s1 = add i32 %l0, %l1
+  %s2 = add i32 %s1, %l2
+  %s3 = add i32 %s2, %l3
+  %s4 = add i32 %s3, %l4
+  %s5 = add i32 %s4, %l5
+  %s6 = add i32 %s5, %l6
+  %s7 = add i32 %s6, %l7
+  ret i32 %s7
+}
@@ -0,0 +1,22 @@
+; RUN: llc < %s -march=x86-64 -mcpu=core2 -pre-RA-sched=source -enable-misched \
+; RUN:          -misched=ilpmax -misched-report -o /dev/null 2>&1 | FileCheck %s
+;
+; Each scheduled region gets one comma-separated record: scheduler, function,
+; block, nodes, edges, critical path, pressure before and after scheduling,
+; excess pressure before and after scheduling, and microseconds.
+;
+; CHECK: misched,ilpmax,sum4,0,{{[0-9]+}},{{[0-9]+}},{{[0-9]+}},{{[0-9]+}},{{[0-9]+}},{{[0-9]+}},{{[0-9]+}},{{[0-9]+$}}
+define i32 @sum4(i32* %p) nounwind {
+entry:
+  %a0 = load i32* %p
+  %p1 = getelementptr i32* %p, i64 1
+  %a1 = load i32* %p1
+  %p2 = getelementptr i32* %p, i64 2
+  %a2 = load i32* %p2
+  %p3 = getelementptr i32* %p, i64 3
+  %a3 = load i32* %p3
+  %s0 = add i32 %a0, %a1
+  %s1 = add i32 %a2, %a3
+  %s = add i32 %s0, %s1
+  ret i32 %s
+}
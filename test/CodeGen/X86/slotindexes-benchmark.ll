@@ -0,0 +1,28 @@
+; RUN: llc < %s -march=x86-64 -mcpu=core2 -slotindexes-benchmark=2 -o /dev/null 2>&1 | FileCheck %s
+;
+; Each query gets a record: function, query, number of queries and the
+; average time per query in nanoseconds.
+;
+; CHECK: slotindexes,f,getInstructionIndex,{{[0-9]+}},{{[0-9.]+$}}
+; CHECK: slotindexes,f,getInstructionFromIndex,{{[0-9]+}},{{[0-9.]+$}}
+; CHECK: slotindexes,f,getMBBFromIndex,{{[0-9]+}},{{[0-9.]+$}}
+; CHECK: slotindexes,f,getMBBRange,8,{{[0-9.]+$}}
+; CHECK: slotindexes,f,getIndexBefore,{{[0-9]+}},{{[0-9.]+$}}
+
+define i32 @f(i32 %a, i32 %b) nounwind {
+entry:
+  %c = icmp slt i32 %a, %b
+  br i1 %c, label %then, label %else
+
+then:
+  %x = mul i32 %a, %b
+  br label %join
+
+else:
+  %y = sub i32 %a, %b
+  br label %join
+
+join:
+  %r = phi i32 [ %x, %then ], [ %y, %else ]
+  ret i32 %r
+}
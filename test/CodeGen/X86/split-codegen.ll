@@ -0,0 +1,46 @@
+; RUN: llc -mtriple=x86_64-unknown-linux-gnu -j 2 %s -o %t
+; RUN: FileCheck --check-prefix=P0 %s < %t
+; RUN: FileCheck --check-prefix=P1 %s < %t.1
+
+; The heaviest function gets a partition of its own.
+; P0: .globl big
+; P0-NOT: {{^}}helper:
+; P0-NOT: {{^}}small:
+; P0-NOT: {{^}}g:
+
+; The internal function lands next to its only user, so it keeps its name.
+; P1-NOT: {{^}}big:
+; P1: {{^}}helper:
+; P1: {{^}}user:
+; P1: {{^}}small:
+; P1: {{^}}g:
+
+@g = global i32 1
+
+define i32 @big(i32 %a, i32 %b) {
+  %1 = add i32 %a, %b
+  %2 = mul i32 %1, %a
+  %3 = sub i32 %2, %b
+  %4 = xor i32 %3, %1
+  %5 = and i32 %4, %2
+  %6 = or i32 %5, %3
+  %7 = add i32 %6, %4
+  %8 = mul i32 %7, %5
+  %9 = call i32 @user(i32 %8)
+  ret i32 %9
+}
+
+define internal i32 @helper(i32 %x) {
+  %1 = load i32* @g
+  %2 = add i32 %x, %1
+  ret i32 %2
+}
+
+define i32 @user(i32 %x) {
+  %1 = call i32 @helper(i32 %x)
+  ret i32 %1
+}
+
+define void @small() {
+  ret void
+}
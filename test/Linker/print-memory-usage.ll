@@ -0,0 +1,20 @@
+; RUN: llvm-link -print-memory-usage %s -o /dev/null 2>&1 | FileCheck %s
+
+; CHECK: Memory usage of the linked module:
+; CHECK-NEXT: instructions: 4
+; CHECK-NEXT: instruction operands: 5
+; CHECK-NEXT: size of a Use:
+; CHECK-NEXT: bytes of operand Uses:
+; CHECK-NEXT: heap bytes:
+; CHECK-NEXT: heap bytes per instruction:
+; CHECK-NEXT: load and link time:
+
+define i32 @f(i32 %x, i32 %y) {
+  %a = add i32 %x, %y
+  %b = mul i32 %a, %a
+  ret i32 %b
+}
+
+define void @g() {
+  ret void
+}
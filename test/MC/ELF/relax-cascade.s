@@ -0,0 +1,38 @@
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %s -o - | llvm-objdump -d - | FileCheck %s
+
+// Test that relaxing an instruction makes the assembler revisit the
+// instructions whose fixups span it, including the ones it only moves through
+// a change in alignment padding.
+
+        .section span,"ax",@progbits
+// Relaxing the second jump pushes the target of the first one out of range.
+// CHECK:      Disassembly of section span:
+// CHECK-NEXT: span:
+// CHECK-NEXT:   0: e9 81 00 00 00      jmpq 129
+// CHECK:      37: e9 12 01 00 00      jmpq 274
+        jmp 1f
+        .fill 50, 1, 0x90
+        jmp 2f
+        .fill 74, 1, 0x90
+1:
+        .fill 200, 1, 0x90
+2:
+        ret
+
+        .section align,"ax",@progbits
+// Relaxing the first jump moves the alignment below, which puts the target of
+// the backward branch out of range without resizing anything in between.
+// CHECK:      Disassembly of section align:
+// CHECK-NEXT: align:
+// CHECK-NEXT:   0: e9 85 01 00 00      jmpq 389
+// CHECK:       bc: 0f 85 4d ff ff ff   jne -179
+        jmp 2f
+        .fill 10, 1, 0x90
+1:
+        .fill 50, 1, 0x90
+        .p2align 6
+        .fill 60, 1, 0x90
+        jne 1b
+        .fill 200, 1, 0x90
+2:
+        ret
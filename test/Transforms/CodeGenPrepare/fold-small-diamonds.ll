@@ -0,0 +1,224 @@
+; RUN: opt -codegenprepare -cgp-fold-small-diamonds -S < %s | FileCheck %s
+; RUN: opt -codegenprepare -S < %s | FileCheck %s -check-prefix=OFF
+
+; CHECK-LABEL: @diamond(
+; CHECK: entry:
+; CHECK-NEXT: %cmp = icmp slt i32 %a, %b
+; CHECK-NEXT: %add = add i32 %a, 1
+; CHECK-NEXT: %sub = sub i32 %b, 1
+; CHECK-NEXT: %r = select i1 %cmp, i32 %add, i32 %sub
+; CHECK-NEXT: %mul = mul i32 %r, 3
+; CHECK-NEXT: ret i32 %mul
+
+; OFF-LABEL: @diamond(
+; OFF: br i1 %cmp, label %then, label %else
+define i32 @diamond(i32 %a, i32 %b) {
+entry:
+  %cmp = icmp slt i32 %a, %b
+  br i1 %cmp, label %then, label %else
+
+then:
+  %add = add i32 %a, 1
+  br label %join
+
+else:
+  %sub = sub i32 %b, 1
+  br label %join
+
+join:
+  %r = phi i32 [ %add, %then ], [ %sub, %else ]
+  %mul = mul i32 %r, 3
+  ret i32 %mul
+}
+
+; CHECK-LABEL: @triangle(
+; CHECK: entry:
+; CHECK-NEXT: %cmp = icmp eq i32 %a, 0
+; CHECK-NEXT: %shl = shl i32 %b, 2
+; CHECK-NEXT: %r = select i1 %cmp, i32 %shl, i32 %b
+; CHECK-NEXT: ret i32 %r
+define i32 @triangle(i32 %a, i32 %b) {
+entry:
+  %cmp = icmp eq i32 %a, 0
+  br i1 %cmp, label %then, label %join
+
+then:
+  %shl = shl i32 %b, 2
+  br label %join
+
+join:
+  %r = phi i32 [ %shl, %then ], [ %b, %entry ]
+  ret i32 %r
+}
+
+; Division may trap, so it cannot be speculated.
+; CHECK-LABEL: @trapping(
+; CHECK: br i1 %cmp, label %then, label %join
+; CHECK: sdiv
+define i32 @trapping(i32 %a, i32 %b) {
+entry:
+  %cmp = icmp ne i32 %b, 0
+  br i1 %cmp, label %then, label %join
+
+then:
+  %div = sdiv i32 %a, %b
+  br label %join
+
+join:
+  %r = phi i32 [ %div, %then ], [ 0, %entry ]
+  ret i32 %r
+}
+
+; Arms that cost more than -cgp-small-diamond-size are left alone.
+; CHECK-LABEL: @large(
+; CHECK: br i1 %cmp, label %then, label %join
+define i32 @large(i32 %a, i32 %b) {
+entry:
+  %cmp = icmp sgt i32 %a, %b
+  br i1 %cmp, label %then, label %join
+
+then:
+  %x1 = add i32 %a, 1
+  %x2 = and i32 %x1, %b
+  %x3 = xor i32 %x2, 7
+  %x4 = shl i32 %x3, 1
+  %x5 = or i32 %x4, %a
+  br label %join
+
+join:
+  %r = phi i32 [ %x5, %then ], [ %a, %entry ]
+  ret i32 %r
+}
+
+; A join block with other predecessors keeps its PHI, fed by the select.
+; CHECK-LABEL: @shared_join(
+; CHECK: %add.b = select i1 %cmp, i32 %add, i32 %b
+; CHECK-NEXT: br label %join
+; CHECK: join:
+; CHECK-NEXT: %r = phi i32 [ %o, %other ], [ %add.b, %body ]
+define i32 @shared_join(i32 %a, i32 %b, i1 %c) {
+entry:
+  br i1 %c, label %body, label %other
+
+other:
+  %o = mul i32 %a, %a
+  br label %join
+
+body:
+  %cmp = icmp ult i32 %a, %b
+  br i1 %cmp, label %then, label %join
+
+then:
+  %add = add i32 %a, %b
+  br label %join
+
+join:
+  %r = phi i32 [ %o, %other ], [ %add, %then ], [ %b, %body ]
+  ret i32 %r
+}
+
+; A switch whose cases only pick a value becomes compares and selects.
+; CHECK-LABEL: @switch_arms(
+; CHECK: entry:
+; CHECK-NEXT: %a = add i32 %y, 1
+; CHECK-NEXT: %s = shl i32 %y, 3
+; CHECK-NEXT: [[ONE:%[0-9]+]] = icmp eq i32 %x, 1
+; CHECK-NEXT: [[TWO:%[0-9]+]] = icmp eq i32 %x, 2
+; CHECK-NEXT: [[SEL2:%[0-9]+]] = select i1 [[TWO]], i32 %s, i32 %y
+; CHECK-NEXT: [[SEL1:%[0-9]+]] = select i1 [[ONE]], i32 %a, i32 [[SEL2]]
+; CHECK-NEXT: ret i32 [[SEL1]]
+
+; OFF-LABEL: @switch_arms(
+; OFF: switch i32 %x
+define i32 @switch_arms(i32 %x, i32 %y) {
+entry:
+  switch i32 %x, label %join [
+    i32 1, label %one
+    i32 2, label %two
+  ]
+
+one:
+  %a = add i32 %y, 1
+  br label %join
+
+two:
+  %s = shl i32 %y, 3
+  br label %join
+
+join:
+  %r = phi i32 [ %a, %one ], [ %s, %two ], [ %y, %entry ]
+  ret i32 %r
+}
+
+; The default destination may be an arm as well.
+; CHECK-LABEL: @switch_default_arm(
+; CHECK: entry:
+; CHECK-NEXT: %d = xor i32 %y, -1
+; CHECK-NEXT: [[CMP:%[0-9]+]] = icmp eq i32 %x, 7
+; CHECK-NEXT: [[SEL:%[0-9]+]] = select i1 [[CMP]], i32 0, i32 %d
+; CHECK-NEXT: ret i32 [[SEL]]
+define i32 @switch_default_arm(i32 %x, i32 %y) {
+entry:
+  switch i32 %x, label %default [
+    i32 7, label %join
+  ]
+
+default:
+  %d = xor i32 %y, -1
+  br label %join
+
+join:
+  %r = phi i32 [ %d, %default ], [ 0, %entry ]
+  ret i32 %r
+}
+
+; An arm may be reached by several cases.
+; CHECK-LABEL: @switch_shared_arms(
+; CHECK: entry:
+; CHECK-NEXT: %a = add i32 %y, 1
+; CHECK-NEXT: [[ONE:%[0-9]+]] = icmp eq i32 %x, 1
+; CHECK-NEXT: [[TWO:%[0-9]+]] = icmp eq i32 %x, 2
+; CHECK-NEXT: [[SEL2:%[0-9]+]] = select i1 [[TWO]], i32 %a, i32 %y
+; CHECK-NEXT: [[SEL1:%[0-9]+]] = select i1 [[ONE]], i32 %a, i32 [[SEL2]]
+; CHECK-NEXT: ret i32 [[SEL1]]
+define i32 @switch_shared_arms(i32 %x, i32 %y) {
+entry:
+  switch i32 %x, label %join [
+    i32 1, label %one
+    i32 2, label %one
+  ]
+
+one:
+  %a = add i32 %y, 1
+  br label %join
+
+join:
+  %r = phi i32 [ %a, %one ], [ %y, %entry ]
+  ret i32 %r
+}
+
+; A switch with more cases than -cgp-small-diamond-size stays a switch.
+; CHECK-LABEL: @switch_many_cases(
+; CHECK: switch i32 %x
+define i32 @switch_many_cases(i32 %x, i32 %y) {
+entry:
+  switch i32 %x, label %join [
+    i32 1, label %one
+    i32 2, label %two
+    i32 3, label %one
+    i32 4, label %two
+    i32 5, label %one
+  ]
+
+one:
+  %a = add i32 %y, 1
+  br label %join
+
+two:
+  %b = sub i32 %y, 1
+  br label %join
+
+join:
+  %r = phi i32 [ %a, %one ], [ %b, %two ], [ %y, %entry ]
+  ret i32 %r
+}
@@ -1,4 +1,5 @@
 ; RUN: opt < %s -basicaa -gvn -S | FileCheck %s
+; RUN: opt < %s -basicaa -gvn -gvn-sparse -S | FileCheck %s
 
 @last = external global [65 x i32*]
 
@@ -1,4 +1,5 @@
 ; RUN: opt < %s -basicaa -gvn -S | FileCheck %s
+; RUN: opt < %s -basicaa -gvn -gvn-sparse -S | FileCheck %s
 
 @a = external global i32		; <i32*> [#uses=7]
 
@@ -0,0 +1,46 @@
+; RUN: opt < %s -basicaa -gvn -S | FileCheck %s
+; RUN: opt < %s -basicaa -gvn -memdep-block-number-limit=4 -S | FileCheck %s -check-prefix=LIMIT
+; RUN: opt < %s -basicaa -gvn -memdep-block-number-limit=4 -stats -disable-output 2>&1 | FileCheck %s -check-prefix=STATS
+; REQUIRES: asserts
+
+; The load in %end depends on the load in %entry through three diamonds.
+; Finding that out visits more than four blocks, so with the lower limit the
+; query gives up and the load stays.
+
+define i32 @f(i32* %p, i1 %c1, i1 %c2, i1 %c3) {
+entry:
+  %a = load i32* %p
+  br i1 %c1, label %l1, label %r1
+l1:
+  br label %j1
+r1:
+  br label %j1
+j1:
+  br i1 %c2, label %l2, label %r2
+l2:
+  br label %j2
+r2:
+  br label %j2
+j2:
+  br i1 %c3, label %l3, label %r3
+l3:
+  br label %end
+r3:
+  br label %end
+end:
+  %b = load i32* %p
+  %s = add i32 %a, %b
+  ret i32 %s
+}
+
+; CHECK-LABEL: @f(
+; CHECK: load i32* %p
+; CHECK-NOT: load
+; CHECK: add i32 %a, %a
+
+; LIMIT-LABEL: @f(
+; LIMIT: %a = load i32* %p
+; LIMIT: %b = load i32* %p
+; LIMIT: add i32 %a, %b
+
+; STATS: 1 memdep - Number of non-local ptr searches cut off by the block limit
@@ -1,4 +1,5 @@
 ; RUN: opt -basicaa -gvn -S < %s | FileCheck %s
+; RUN: opt -basicaa -gvn -gvn-sparse -S < %s | FileCheck %s
 
 target datalayout = "e-p:64:64:64"
 
@@ -1,9 +1,12 @@
-; RUN: opt < %s -basicaa -gvn -S | grep "DEAD = phi i32 "
+; RUN: opt < %s -basicaa -gvn -S | FileCheck %s
+; RUN: opt < %s -basicaa -gvn -gvn-sparse -S | FileCheck %s
 
 ; GVN should eliminate the fully redundant %9 GEP which 
 ; allows DEAD to be removed.  This is PR3198.
 
 ; The %7 and %4 loads combine to make %DEAD unneeded.
+; The branch on %8 then says that %7 is 0 on the edge from %bb1.
+; CHECK: %DEAD = phi i32 [ 0, %bb1 ], [ %4, %bb ]
 target datalayout = "e-p:32:32:32-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:32:64-f32:32:32-f64:32:64-v64:64:64-v128:128:128-a0:0:64-f80:128:128"
 target triple = "i386-apple-darwin7"
 @H = common global [100 x i32] zeroinitializer, align 32		; <[100 x i32]*> [#uses=3]
@@ -0,0 +1,70 @@
+; RUN: opt < %s -basicaa -gvn -gvn-sparse -S | FileCheck %s
+; RUN: opt < %s -basicaa -gvn -gvn-sparse -gvn-sparse-budget=1 -S | FileCheck %s -check-prefix=BUDGET
+
+; %p1 only becomes trivial once %q1 has been simplified in the loop body, after
+; the walk has passed %p1.  That in turn makes %d2 zero.  The sparse engine
+; follows the chain through the worklist instead of walking the function again.
+
+define i64 @chain(i64 %a, i64 %n) {
+entry:
+  br label %h1
+
+h1:
+  %p1 = phi i64 [ %a, %entry ], [ %q1, %h1 ]
+  %i1 = phi i64 [ 0, %entry ], [ %i1.n, %h1 ]
+  %d1 = sub i64 %a, %a
+  %q1 = add i64 %p1, %d1
+  %i1.n = add i64 %i1, 1
+  %c1 = icmp slt i64 %i1.n, %n
+  br i1 %c1, label %h1, label %h2
+
+h2:
+  %p2 = phi i64 [ %a, %h1 ], [ %q2, %h2 ]
+  %i2 = phi i64 [ 0, %h1 ], [ %i2.n, %h2 ]
+  %d2 = sub i64 %p1, %a
+  %q2 = add i64 %p2, %d2
+  %i2.n = add i64 %i2, 1
+  %c2 = icmp slt i64 %i2.n, %n
+  br i1 %c2, label %h2, label %exit
+
+exit:
+  ret i64 %p2
+; CHECK: @chain
+; CHECK-NOT: %p1
+; CHECK-NOT: %p2
+; CHECK: ret i64 %a
+
+; With a budget of one revisit only %p1 goes away.
+; BUDGET: @chain
+; BUDGET-NOT: %p1 = phi
+; BUDGET: %p2 = phi
+; BUDGET: ret i64 %p2
+}
+
+; Sparse mode keeps load PRE but does no scalar PRE.
+
+define i32 @pre(i32* %p, i32 %x, i32 %y, i1 %c) {
+entry:
+  br i1 %c, label %left, label %right
+
+left:
+  %v1 = load i32* %p
+  %s1 = add i32 %x, %y
+  br label %join
+
+right:
+  store i32 0, i32* %p
+  br label %join
+
+join:
+  %v2 = load i32* %p
+  %s2 = add i32 %x, %y
+  %r = add i32 %v2, %s2
+  ret i32 %r
+; CHECK: @pre
+; CHECK: join:
+; CHECK: phi i32 [ 0, %right ], [ %v2.pre, %left ]
+; CHECK-NOT: load
+; CHECK: %s2 = add i32 %x, %y
+; CHECK: ret i32
+}
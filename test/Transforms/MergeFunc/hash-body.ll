@@ -0,0 +1,57 @@
+; RUN: opt -mergefunc -S < %s | FileCheck %s
+; RUN: opt -mergefunc -stats -disable-output < %s 2>&1 | FileCheck %s -check-prefix=STATS
+; REQUIRES: asserts
+
+; The function hash covers the instructions in the body, so functions which
+; share a signature but differ in their bodies are never compared. Only the
+; two pairs of equal functions are.
+target datalayout = "e-p:32:32:32-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:32:64-f32:32:32-f64:32:64-v64:64:64-v128:128:128-a0:0:64-f80:32:32-n8:16:32-S128"
+
+; STATS: 2 mergefunc - Number of function bodies compared
+; STATS: 2 mergefunc - Number of functions merged
+
+define i32 @add1(i32 %x) {
+  %r = add i32 %x, 1
+  ret i32 %r
+}
+
+define i32 @add2(i32 %x) {
+  %r = add i32 %x, 2
+  ret i32 %r
+}
+
+define i32 @sub1(i32 %x) {
+  %r = sub i32 %x, 1
+  ret i32 %r
+}
+
+define i32 @add1nsw(i32 %x) {
+  %r = add nsw i32 %x, 1
+  ret i32 %r
+}
+
+define i32 @add1twice(i32 %x) {
+  %r = add i32 %x, 1
+  %s = add i32 %r, 1
+  ret i32 %s
+}
+
+define i32 @add1copy(i32 %x) {
+  %r = add i32 %x, 1
+  ret i32 %r
+}
+; CHECK-LABEL: define i32 @add1copy(i32)
+; CHECK: tail call i32 @add1(i32 %0)
+
+; Pointers to different types still hash the same.
+define i8* @load8(i8** %p) {
+  %r = load i8** %p
+  ret i8* %r
+}
+
+define i32* @load32(i32** %p) {
+  %r = load i32** %p
+  ret i32* %r
+}
+; CHECK-LABEL: define i32* @load32(i32**)
+; CHECK: tail call i8* @load8
@@ -0,0 +1,76 @@
+; RUN: llvm-as %s -o %t.bc
+; RUN: rm -f %t.o.*
+; RUN: llvm-lto -j 2 -o %t.o %t.bc -exported-symbol=f1 -exported-symbol=f2 \
+; RUN:     -exported-symbol=f3 -exported-symbol=g
+; RUN: llvm-nm %t.o.0 | FileCheck %s -check-prefix=P0
+; RUN: llvm-nm %t.o.1 | FileCheck %s -check-prefix=P1
+; RUN: not ls %t.o.2
+; RUN: rm -f %t.main.o.*
+; RUN: llvm-lto -j 4 -o %t.main.o %t.bc -exported-symbol=main \
+; RUN:     -disable-inlining
+; RUN: llvm-nm %t.main.o.0 | FileCheck %s -check-prefix=MAIN0
+; RUN: llvm-nm %t.main.o.1 | FileCheck %s -check-prefix=MAIN1
+; RUN: llvm-nm %t.main.o.2 | FileCheck %s -check-prefix=MAIN2
+; RUN: llvm-nm %t.main.o.3 | FileCheck %s -check-prefix=MAIN3
+
+; With -j 2 libLTO writes two object files.  Between them they define every
+; symbol.  The internal helper ends up apart from its only user, so it is
+; promoted to a hidden symbol with a new name.
+
+; P0-DAG: T f2
+; P0-DAG: T helper.llvm.{{[0-9]+}}
+; P0-DAG: U g
+; P1-DAG: T f1
+; P1-DAG: T f3
+; P1-DAG: B g
+; P1-DAG: U helper.llvm.{{[0-9]+}}
+
+; With only main exported, everything else is internalized (and f1 is folded
+; away).  The internal definitions are still spread over the partitions, and
+; those that are used from another partition are promoted as well.
+
+; MAIN0-DAG: T f2.llvm.{{[0-9]+}}
+; MAIN0-DAG: U g.llvm.{{[0-9]+}}
+; MAIN1-DAG: T f3.llvm.{{[0-9]+}}
+; MAIN1-DAG: U f2.llvm.{{[0-9]+}}
+; MAIN2-DAG: T main
+; MAIN2-DAG: U f3.llvm.{{[0-9]+}}
+; MAIN3-DAG: B g.llvm.{{[0-9]+}}
+
+target datalayout = "e-p:64:64:64-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:64:64-f32:32:32-f64:64:64-v64:64:64-v128:128:128-a0:0:64-s0:64:64-f80:128:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+@g = global i32 0
+
+define internal i32 @helper(i32 %x) noinline {
+  %a = mul i32 %x, %x
+  %b = add i32 %a, 7
+  %c = mul i32 %b, %x
+  ret i32 %c
+}
+
+define i32 @f1(i32 %x) {
+  %a = call i32 @helper(i32 %x)
+  %b = add i32 %a, 1
+  ret i32 %b
+}
+
+define i32 @f2(i32 %x) {
+  %a = load i32* @g
+  %b = add i32 %a, %x
+  store i32 %b, i32* @g
+  %c = mul i32 %b, 3
+  %d = sub i32 %c, %x
+  ret i32 %d
+}
+
+define i32 @f3(i32 %x) {
+  %a = call i32 @f2(i32 %x)
+  ret i32 %a
+}
+
+define i32 @main() {
+  %a = call i32 @f1(i32 1)
+  %b = call i32 @f3(i32 %a)
+  ret i32 %b
+}
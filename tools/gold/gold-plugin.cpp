@@ -78,6 +78,9 @@ namespace options {
   static std::string extra_library_path;
   static std::string triple;
   static std::string mcpu;
+  // Number of partitions to split code generation into, each one compiled on
+  // its own thread into its own object file.
+  static unsigned jobs = 1;
   // Additional options to pass into the code generator.
   // Note: This array will contain all plugin options which are not claimed
   // as plugin exclusive to pass to the code generator.
@@ -99,6 +102,12 @@ namespace options {
       extra_library_path = opt.substr(strlen("extra_library_path="));
     } else if (opt.startswith("mtriple=")) {
       triple = opt.substr(strlen("mtriple="));
+    } else if (opt.startswith("jobs=")) {
+      if (opt.substr(strlen("jobs=")).getAsInteger(10, jobs) || jobs == 0) {
+        (*message)(LDPL_WARNING, "Invalid number of jobs. Using one: %s",
+                   opt_);
+        jobs = 1;
+      }
     } else if (opt.startswith("obj-path=")) {
       obj_path = opt.substr(strlen("obj-path="));
     } else if (opt == "emit-llvm") {
@@ -421,9 +430,23 @@ static ld_plugin_status all_symbols_read_hook(void) {
     if (options::generate_bc_file == options::BC_ONLY)
       exit(0);
   }
-  const char *objPath;
-  if (lto_codegen_compile_to_file(code_gen, &objPath)) {
-    (*message)(LDPL_ERROR, "Could not produce a combined object file\n");
+  std::vector<std::string> objPaths;
+  if (options::jobs > 1) {
+    const char *const *names;
+    unsigned count;
+    if (lto_codegen_compile_to_files(code_gen, options::jobs, &names,
+                                     &count)) {
+      (*message)(LDPL_ERROR, "Could not produce the object files\n");
+    } else {
+      objPaths.assign(names, names + count);
+    }
+  } else {
+    const char *objPath;
+    if (lto_codegen_compile_to_file(code_gen, &objPath)) {
+      (*message)(LDPL_ERROR, "Could not produce a combined object file\n");
+    } else {
+      objPaths.push_back(objPath);
+    }
   }
 
   lto_codegen_dispose(code_gen);
@@ -435,10 +458,13 @@ static ld_plugin_status all_symbols_read_hook(void) {
     }
   }
 
-  if ((*add_input_file)(objPath) != LDPS_OK) {
-    (*message)(LDPL_ERROR, "Unable to add .o file to the link.");
-    (*message)(LDPL_ERROR, "File left behind in: %s", objPath);
-    return LDPS_ERR;
+  for (unsigned i = 0, e = objPaths.size(); i != e; ++i) {
+    const char *objPath = objPaths[i].c_str();
+    if ((*add_input_file)(objPath) != LDPS_OK) {
+      (*message)(LDPL_ERROR, "Unable to add .o file to the link.");
+      (*message)(LDPL_ERROR, "File left behind in: %s", objPath);
+      return LDPS_ERR;
+    }
   }
 
   if (!options::extra_library_path.empty() &&
@@ -448,7 +474,7 @@ static ld_plugin_status all_symbols_read_hook(void) {
   }
 
   if (options::obj_path.empty())
-    Cleanup.push_back(objPath);
+    Cleanup.insert(Cleanup.end(), objPaths.begin(), objPaths.end());
 
   return LDPS_OK;
 }
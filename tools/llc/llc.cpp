@@ -15,11 +15,16 @@
 
 
 #include "llvm/IR/LLVMContext.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/Triple.h"
+#include "llvm/Analysis/Verifier.h"
 #include "llvm/Assembly/PrintModulePass.h"
 #include "llvm/CodeGen/CommandFlags.h"
 #include "llvm/CodeGen/LinkAllAsmWriterComponents.h"
 #include "llvm/CodeGen/LinkAllCodegenComponents.h"
+#include "llvm/CodeGen/LiveIntervalAnalysis.h"
+#include "llvm/CodeGen/ParallelCG.h"
 #include "llvm/IR/DataLayout.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IRReader/IRReader.h"
@@ -37,6 +42,7 @@
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Target/TargetLibraryInfo.h"
 #include "llvm/Target/TargetMachine.h"
@@ -53,6 +59,11 @@ InputFilename(cl::Positional, cl::desc("<input bitcode>"), cl::init("-"));
 static cl::opt<std::string>
 OutputFilename("o", cl::desc("Output filename"), cl::value_desc("filename"));
 
+static cl::opt<unsigned>
+NumPartitions("j", cl::desc("Split the module into N partitions and code "
+                            "generate them in parallel"),
+              cl::value_desc("N"), cl::init(1u));
+
 static cl::opt<unsigned>
 TimeCompilations("time-compilations", cl::Hidden, cl::init(1u),
                  cl::value_desc("N"),
@@ -78,6 +89,18 @@ DisableSimplifyLibCalls("disable-simplify-libcalls",
                         cl::desc("Disable simplify-libcalls"),
                         cl::init(false));
 
+namespace {
+/// TargetMachineConfig - Everything needed to create the TargetMachine for
+/// the module, or for one of its partitions with -j.
+struct TargetMachineConfig {
+  const Target *TheTarget;
+  Triple TheTriple;
+  std::string FeaturesStr;
+  TargetOptions Options;
+  CodeGenOpt::Level OLvl;
+};
+}
+
 static int compileModule(char**, LLVMContext&);
 
 // GetFileNameRoot - Helper function to get the basename of a filename.
@@ -97,6 +120,9 @@ GetFileNameRoot(const std::string &InputFilename) {
   return outputFilename;
 }
 
+static tool_output_file *OpenOutputFile(const std::string &Filename,
+                                        bool Binary);
+
 static tool_output_file *GetOutputStream(const char *TargetName,
                                          Triple::OSType OS,
                                          const char *ProgName) {
@@ -143,11 +169,17 @@ static tool_output_file *GetOutputStream(const char *TargetName,
     break;
   }
 
-  // Open the file.
+  return OpenOutputFile(OutputFilename, Binary);
+}
+
+// OpenOutputFile - Open Filename for writing, printing an error and returning
+// null on failure.
+static tool_output_file *OpenOutputFile(const std::string &Filename,
+                                        bool Binary) {
   std::string error;
   unsigned OpenFlags = 0;
   if (Binary) OpenFlags |= raw_fd_ostream::F_Binary;
-  tool_output_file *FDOut = new tool_output_file(OutputFilename.c_str(), error,
+  tool_output_file *FDOut = new tool_output_file(Filename.c_str(), error,
                                                  OpenFlags);
   if (!error.empty()) {
     errs() << error << '\n';
@@ -190,6 +222,11 @@ int main(int argc, char **argv) {
 
   cl::ParseCommandLineOptions(argc, argv, "llvm system compiler\n");
 
+  // Partitions are compiled on separate threads, and so are live intervals
+  // when -live-interval-threads asks for more than one.
+  if (NumPartitions > 1 || LiveIntervals::getNumThreads() > 1)
+    llvm_start_multithreaded();
+
   // Compile the module TimeCompilations times to give better compile time
   // metrics.
   for (unsigned I = TimeCompilations; I; --I)
@@ -198,6 +235,95 @@ int main(int argc, char **argv) {
   return 0;
 }
 
+// CreateTargetMachine - Create a TargetMachine as described by the
+// TargetMachineConfig passed in Opaque and the command line options.
+static TargetMachine *CreateTargetMachine(void *Opaque) {
+  const TargetMachineConfig &Config =
+    *static_cast<const TargetMachineConfig*>(Opaque);
+  const Triple &TheTriple = Config.TheTriple;
+  TargetMachine *Target =
+    Config.TheTarget->createTargetMachine(TheTriple.getTriple(), MCPU,
+                                          Config.FeaturesStr, Config.Options,
+                                          RelocModel, CMModel, Config.OLvl);
+  if (!Target)
+    return 0;
+
+  if (DisableDotLoc)
+    Target->setMCUseLoc(false);
+
+  if (DisableCFI)
+    Target->setMCUseCFI(false);
+
+  if (EnableDwarfDirectory)
+    Target->setMCUseDwarfDirectory(true);
+
+  // Disable .loc support for older OS X versions.
+  if (TheTriple.isMacOSX() &&
+      TheTriple.isMacOSXVersionLT(10, 6))
+    Target->setMCUseLoc(false);
+
+  if (RelaxAll && FileType == TargetMachine::CGFT_ObjectFile)
+    Target->setMCRelaxAll(true);
+
+  return Target;
+}
+
+// compileModuleInParallel - Split the module into NumPartitions partitions
+// and code generate them in parallel.  The first partition is written to Out,
+// and partition N to a file named after Out with a ".N" suffix.
+static int compileModuleInParallel(char **argv, const Module &M,
+                                   TargetMachineConfig &Config,
+                                   tool_output_file &Out) {
+  if (OutputFilename == "-") {
+    errs() << argv[0] << ": -j requires an output file.\n";
+    return 1;
+  }
+  if (!StartAfter.empty() || !StopAfter.empty()) {
+    errs() << argv[0] << ": -start-after and -stop-after cannot be used "
+           << "with -j.\n";
+    return 1;
+  }
+
+  // The partitions are compiled without the usual verifier pass.
+  if (!NoVerify && verifyModule(M, PrintMessageAction)) {
+    errs() << argv[0] << ": input module is broken!\n";
+    return 1;
+  }
+
+  bool Binary = FileType != TargetMachine::CGFT_AssemblyFile;
+  std::vector<tool_output_file*> Outs;
+  std::vector<raw_ostream*> OSs(1, &Out.os());
+  for (unsigned i = 1; i != NumPartitions; ++i) {
+    tool_output_file *PartOut =
+      OpenOutputFile(OutputFilename + "." + utostr(i), Binary);
+    if (!PartOut) {
+      DeleteContainerPointers(Outs);
+      return 1;
+    }
+    Outs.push_back(PartOut);
+    OSs.push_back(&PartOut->os());
+  }
+
+  // Before executing passes, print the final values of the LLVM options.
+  cl::PrintOptionValues();
+
+  TargetMachine::setAsmVerbosityDefault(true);
+  std::string ErrMsg;
+  if (splitCodeGen(M, OSs, NumPartitions, CreateTargetMachine, &Config,
+                   FileType, ErrMsg)) {
+    errs() << argv[0] << ": " << ErrMsg << "\n";
+    DeleteContainerPointers(Outs);
+    return 1;
+  }
+
+  // Declare success.
+  Out.keep();
+  for (unsigned i = 0, e = Outs.size(); i != e; ++i)
+    Outs[i]->keep();
+  DeleteContainerPointers(Outs);
+  return 0;
+}
+
 static int compileModule(char **argv, LLVMContext &Context) {
   // Load the module to be compiled...
   SMDiagnostic Err;
@@ -282,36 +408,24 @@ static int compileModule(char **argv, LLVMContext &Context) {
   Options.UseInitArray = UseInitArray;
   Options.SSPBufferSize = SSPBufferSize;
 
-  OwningPtr<TargetMachine>
-    target(TheTarget->createTargetMachine(TheTriple.getTriple(),
-                                          MCPU, FeaturesStr, Options,
-                                          RelocModel, CMModel, OLvl));
+  TargetMachineConfig Config = { TheTarget, TheTriple, FeaturesStr, Options,
+                                 OLvl };
+  OwningPtr<TargetMachine> target(CreateTargetMachine(&Config));
   assert(target.get() && "Could not allocate target machine!");
   assert(mod && "Should have exited after outputting help!");
   TargetMachine &Target = *target.get();
 
-  if (DisableDotLoc)
-    Target.setMCUseLoc(false);
-
-  if (DisableCFI)
-    Target.setMCUseCFI(false);
-
-  if (EnableDwarfDirectory)
-    Target.setMCUseDwarfDirectory(true);
-
   if (GenerateSoftFloatCalls)
     FloatABIForCalls = FloatABI::Soft;
 
-  // Disable .loc support for older OS X versions.
-  if (TheTriple.isMacOSX() &&
-      TheTriple.isMacOSXVersionLT(10, 6))
-    Target.setMCUseLoc(false);
-
   // Figure out where we are going to send the output.
   OwningPtr<tool_output_file> Out
     (GetOutputStream(TheTarget->getName(), TheTriple.getOS(), argv[0]));
   if (!Out) return 1;
 
+  if (NumPartitions > 1)
+    return compileModuleInParallel(argv, *mod, Config, *Out);
+
   // Build up all of the passes that we want to do to the module.
   PassManager PM;
 
@@ -333,13 +447,9 @@ static int compileModule(char **argv, LLVMContext &Context) {
   // Override default to generate verbose assembly.
   Target.setAsmVerbosityDefault(true);
 
-  if (RelaxAll) {
-    if (FileType != TargetMachine::CGFT_ObjectFile)
-      errs() << argv[0]
-             << ": warning: ignoring -mc-relax-all because filetype != obj";
-    else
-      Target.setMCRelaxAll(true);
-  }
+  if (RelaxAll && FileType != TargetMachine::CGFT_ObjectFile)
+    errs() << argv[0]
+           << ": warning: ignoring -mc-relax-all because filetype != obj";
 
   {
     formatted_raw_ostream FOS(Out->os());
@@ -109,6 +109,7 @@ static const char *GetBlockName(unsigned BlockID,
   case bitc::METADATA_BLOCK_ID:        return "METADATA_BLOCK";
   case bitc::METADATA_ATTACHMENT_ID:   return "METADATA_ATTACHMENT_BLOCK";
   case bitc::USELIST_BLOCK_ID:         return "USELIST_BLOCK_ID";
+  case bitc::FUNCTION_INDEX_BLOCK_ID:  return "FUNCTION_INDEX_BLOCK";
   }
 }
 
@@ -156,6 +157,7 @@ static const char *GetCodeName(unsigned CodeID, unsigned BlockID,
     case bitc::MODULE_CODE_ALIAS:       return "ALIAS";
     case bitc::MODULE_CODE_PURGEVALS:   return "PURGEVALS";
     case bitc::MODULE_CODE_GCNAME:      return "GCNAME";
+    case bitc::MODULE_CODE_FNINDEXOFFSET: return "FNINDEXOFFSET";
     }
   case bitc::PARAMATTR_BLOCK_ID:
     switch (CodeID) {
@@ -273,6 +275,11 @@ static const char *GetCodeName(unsigned CodeID, unsigned BlockID,
     default:return 0;
     case bitc::USELIST_CODE_ENTRY:   return "USELIST_CODE_ENTRY";
     }
+  case bitc::FUNCTION_INDEX_BLOCK_ID:
+    switch (CodeID) {
+    default: return 0;
+    case bitc::FNINDEX_CODE_ENTRY:   return "ENTRY";
+    }
   }
 }
 
@@ -311,6 +318,13 @@ struct PerBlockIDStats {
 
 static std::map<unsigned, PerBlockIDStats> BlockIDStats;
 
+/// ModuleBodyBit - The start of the body of the module block, which the
+/// offsets in the function index are relative to.
+static uint64_t ModuleBodyBit;
+
+/// FunctionBlockStarts - The offsets of the function blocks seen so far,
+/// relative to ModuleBodyBit, mapped to their number in the module.
+static std::map<uint64_t, unsigned> FunctionBlockStarts;
 
 
 /// Error - All bitcode analysis errors go through this function, making this a
@@ -344,6 +358,10 @@ static bool ParseBlock(BitstreamCursor &Stream, unsigned BlockID,
   unsigned NumWords = 0;
   if (Stream.EnterSubBlock(BlockID, &NumWords))
     return Error("Malformed block record");
+  if (CurStreamType == LLVMIRBitstream && BlockID == bitc::MODULE_BLOCK_ID) {
+    ModuleBodyBit = Stream.GetCurrentBitNo();
+    FunctionBlockStarts.clear();
+  }
 
   const char *BlockName = 0;
   if (Dump) {
@@ -389,6 +407,12 @@ static bool ParseBlock(BitstreamCursor &Stream, unsigned BlockID,
     }
         
     case BitstreamEntry::SubBlock: {
+      if (CurStreamType == LLVMIRBitstream &&
+          BlockID == bitc::MODULE_BLOCK_ID &&
+          Entry.ID == bitc::FUNCTION_BLOCK_ID) {
+        unsigned Number = FunctionBlockStarts.size();
+        FunctionBlockStarts[RecordStartBit - ModuleBodyBit] = Number;
+      }
       uint64_t SubBlockBitStart = Stream.GetCurrentBitNo();
       if (ParseBlock(Stream, Entry.ID, IndentLevel+1))
         return true;
@@ -446,6 +470,18 @@ static bool ParseBlock(BitstreamCursor &Stream, unsigned BlockID,
 
       outs() << "/>";
 
+      // Say which function block each entry of the function index refers to.
+      if (CurStreamType == LLVMIRBitstream &&
+          BlockID == bitc::FUNCTION_INDEX_BLOCK_ID &&
+          Code == bitc::FNINDEX_CODE_ENTRY && !Record.empty()) {
+        std::map<uint64_t, unsigned>::iterator I =
+          FunctionBlockStarts.find(Record[0]);
+        if (I != FunctionBlockStarts.end())
+          outs() << " function block #" << I->second;
+        else
+          outs() << " not a function block!";
+      }
+
       if (Blob.data()) {
         outs() << " blob data = ";
         bool BlobIsPrintable = true;
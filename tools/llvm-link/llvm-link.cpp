@@ -20,11 +20,15 @@
 #include "llvm/IRReader/IRReader.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/Process.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/SystemUtils.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/Timer.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include <memory>
 using namespace llvm;
@@ -50,6 +54,16 @@ Verbose("v", cl::desc("Print information about actions taken"));
 static cl::opt<bool>
 DumpAsm("d", cl::desc("Print assembly as linked"), cl::Hidden);
 
+static cl::opt<unsigned>
+NumThreads("j", cl::desc("Number of threads to write the output bitcode "
+                         "with"),
+           cl::init(1), cl::Prefix);
+
+static cl::opt<bool>
+PrintMemoryUsage("print-memory-usage",
+                 cl::desc("Print the heap usage of the linked module per "
+                          "instruction"));
+
 // LoadFile - Read the specified bitcode file in and return it.  This routine
 // searches the link path for the specified file to try to find it...
 //
@@ -66,6 +80,36 @@ static inline Module *LoadFile(const char *argv0, const std::string &FN,
   return NULL;
 }
 
+// printMemoryUsage - Print how much heap the inputs took to load and link,
+// relative to the number of instructions in the linked module.  Comparing the
+// numbers between builds of llvm-link over a large set of inputs shows the
+// effect of changes to the in-memory representation of the IR.
+static void printMemoryUsage(const Module &M, size_t HeapBytes,
+                             double Seconds) {
+  uint64_t NumInsts = 0, NumOperands = 0;
+  for (Module::const_iterator F = M.begin(), FE = M.end(); F != FE; ++F)
+    for (Function::const_iterator BB = F->begin(), BE = F->end(); BB != BE;
+         ++BB)
+      for (BasicBlock::const_iterator I = BB->begin(), IE = BB->end(); I != IE;
+           ++I) {
+        ++NumInsts;
+        NumOperands += I->getNumOperands();
+      }
+
+  errs() << "Memory usage of the linked module:\n"
+         << "  instructions:               " << NumInsts << "\n"
+         << "  instruction operands:       " << NumOperands << "\n"
+         << "  size of a Use:              " << sizeof(Use) << "\n"
+         << "  bytes of operand Uses:      " << NumOperands * sizeof(Use)
+         << "\n"
+         << "  heap bytes:                 " << HeapBytes << "\n"
+         << "  heap bytes per instruction: "
+         << format("%.1f", NumInsts ? double(HeapBytes) / NumInsts : 0.0)
+         << "\n"
+         << "  load and link time:         " << format("%.3fs", Seconds)
+         << "\n";
+}
+
 int main(int argc, char **argv) {
   // Print a stack trace if we signal out.
   sys::PrintStackTraceOnErrorSignal();
@@ -78,6 +122,9 @@ int main(int argc, char **argv) {
   unsigned BaseArg = 0;
   std::string ErrorMessage;
 
+  size_t HeapAtStart = sys::Process::GetMallocUsage();
+  TimeRecord TimeAtStart = TimeRecord::getCurrentTime(true);
+
   OwningPtr<Module> Composite(LoadFile(argv[0],
                                        InputFilenames[BaseArg], Context));
   if (Composite.get() == 0) {
@@ -103,6 +150,13 @@ int main(int argc, char **argv) {
     }
   }
 
+  if (PrintMemoryUsage) {
+    TimeRecord Elapsed = TimeRecord::getCurrentTime(false);
+    Elapsed -= TimeAtStart;
+    printMemoryUsage(*Composite, sys::Process::GetMallocUsage() - HeapAtStart,
+                     Elapsed.getWallTime());
+  }
+
   if (DumpAsm) errs() << "Here's the assembly:\n" << *Composite;
 
   std::string ErrorInfo;
@@ -121,8 +175,11 @@ int main(int argc, char **argv) {
   if (Verbose) errs() << "Writing bitcode...\n";
   if (OutputAssembly) {
     Out.os() << *Composite;
-  } else if (Force || !CheckBitcodeOutputToConsole(Out.os(), true))
-    WriteBitcodeToFile(Composite.get(), Out.os());
+  } else if (Force || !CheckBitcodeOutputToConsole(Out.os(), true)) {
+    if (NumThreads > 1)
+      llvm_start_multithreaded();
+    WriteBitcodeToFile(Composite.get(), Out.os(), NumThreads);
+  }
 
   // Declare success.
   Out.keep();
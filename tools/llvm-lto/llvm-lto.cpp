@@ -0,0 +1,139 @@
+//===-- llvm-lto.cpp - Test driver for libLTO -----------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This program links bitcode files through the libLTO C API and writes the
+// native object files it generates, so that libLTO can be tested without a
+// linker.  With -j N the code is generated in N partitions, one object file
+// each, as with lto_codegen_compile_to_files().
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm-c/lto.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/ToolOutputFile.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/system_error.h"
+using namespace llvm;
+
+static cl::list<std::string>
+InputFilenames(cl::Positional, cl::OneOrMore,
+               cl::desc("<input bitcode files>"));
+
+static cl::opt<std::string>
+OutputFilename("o", cl::Required, cl::value_desc("filename"),
+               cl::desc("Output filename; with -j, the prefix of the names "
+                        "<filename>.0 to <filename>.N-1"));
+
+static cl::opt<unsigned>
+NumPartitions("j", cl::init(0), cl::value_desc("N"),
+              cl::desc("Generate code in N partitions, into one object file "
+                       "each"));
+
+static cl::list<std::string>
+ExportedSymbols("exported-symbol",
+                cl::desc("Symbol to keep visible outside the linked code"));
+
+static cl::opt<std::string>
+MCPU("mcpu", cl::value_desc("cpu-name"),
+     cl::desc("Target a specific cpu type"));
+
+static int error(const Twine &Msg) {
+  errs() << "llvm-lto: " << Msg << '\n';
+  return 1;
+}
+
+/// writeFile - Write Length bytes at Data to Path.
+static int writeFile(const std::string &Path, const void *Data,
+                     size_t Length) {
+  std::string ErrorInfo;
+  tool_output_file Out(Path.c_str(), ErrorInfo, raw_fd_ostream::F_Binary);
+  if (!ErrorInfo.empty())
+    return error("cannot open " + Path + ": " + ErrorInfo);
+  Out.os().write(static_cast<const char *>(Data), Length);
+  Out.os().close();
+  if (Out.os().has_error())
+    return error("cannot write " + Path);
+  Out.keep();
+  return 0;
+}
+
+/// moveFile - Move the object file libLTO wrote at From to To.  The file is
+/// copied, since From may be on another file system.
+static int moveFile(const char *From, const std::string &To) {
+  OwningPtr<MemoryBuffer> Buffer;
+  if (error_code EC = MemoryBuffer::getFile(From, Buffer, -1, false))
+    return error(Twine("cannot read ") + From + ": " + EC.message());
+  if (int Ret = writeFile(To, Buffer->getBufferStart(),
+                          Buffer->getBufferSize()))
+    return Ret;
+  sys::fs::remove(From);
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  // Print a stack trace if we signal out.
+  sys::PrintStackTraceOnErrorSignal();
+  PrettyStackTraceProgram X(argc, argv);
+  llvm_shutdown_obj Y;  // Call llvm_shutdown() on exit.
+
+  cl::ParseCommandLineOptions(argc, argv, "llvm LTO linker\n");
+
+  lto_code_gen_t CodeGen = lto_codegen_create();
+  lto_codegen_set_pic_model(CodeGen, LTO_CODEGEN_PIC_MODEL_DYNAMIC);
+  if (!MCPU.empty())
+    lto_codegen_set_cpu(CodeGen, MCPU.c_str());
+
+  int Ret = 0;
+  for (unsigned i = 0, e = InputFilenames.size(); i != e && !Ret; ++i) {
+    lto_module_t Module = lto_module_create(InputFilenames[i].c_str());
+    if (!Module) {
+      Ret = error("cannot load " + InputFilenames[i] + ": " +
+                  lto_get_error_message());
+      break;
+    }
+    if (lto_codegen_add_module(CodeGen, Module))
+      Ret = error("cannot link " + InputFilenames[i] + ": " +
+                  lto_get_error_message());
+    lto_module_dispose(Module);
+  }
+
+  for (unsigned i = 0, e = ExportedSymbols.size(); i != e; ++i)
+    lto_codegen_add_must_preserve_symbol(CodeGen, ExportedSymbols[i].c_str());
+
+  if (!Ret && NumPartitions == 0) {
+    size_t Length;
+    const void *Code = lto_codegen_compile(CodeGen, &Length);
+    if (!Code)
+      Ret = error(Twine("error compiling the code: ") +
+                  lto_get_error_message());
+    else
+      Ret = writeFile(OutputFilename, Code, Length);
+  } else if (!Ret) {
+    const char *const *Names;
+    unsigned Count;
+    if (lto_codegen_compile_to_files(CodeGen, NumPartitions, &Names, &Count)) {
+      Ret = error(Twine("error compiling the code: ") +
+                  lto_get_error_message());
+    } else {
+      for (unsigned i = 0; i != Count; ++i)
+        if (int FileRet = moveFile(Names[i], OutputFilename + "." + utostr(i)))
+          Ret = FileRet;
+    }
+  }
+
+  lto_codegen_dispose(CodeGen);
+  return Ret;
+}
@@ -12,12 +12,18 @@
 //===----------------------------------------------------------------------===//
 
 #include "LLVMSymbolize.h"
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/Object/MachO.h"
 #include "llvm/Support/Casting.h"
+#include "llvm/Support/DataExtractor.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MathExtras.h"
 #include "llvm/Support/Path.h"
-
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 #include <sstream>
 
 namespace llvm {
@@ -46,13 +52,112 @@ static void patchFunctionNameInDILineInfo(const std::string &NewFunctionName,
                         LineInfo.getLine(), LineInfo.getColumn());
 }
 
-ModuleInfo::ModuleInfo(ObjectFile *Obj, DIContext *DICtx)
+// Returns a string identifying the contents of Obj: the GNU build ID if the
+// object has one, and a hash of the path, size and modification time of the
+// file otherwise. A stripped binary shares the build ID of its unstripped twin,
+// so a build ID key also includes the file hash. If HashContents is set, a
+// module without a build ID is keyed on a hash of the whole file instead, which
+// reads all of it.
+static std::string getCacheKey(const ObjectFile *Obj, StringRef Path,
+                               bool HashContents) {
+  static const char Hex[] = "0123456789abcdef";
+  MD5 FileHash;
+  FileHash.update(Path);
+  uint64_t Identity[2] = { Obj->getData().size(), 0 };
+  sys::fs::file_status Status;
+  if (!sys::fs::status(Path, Status))
+    Identity[1] = Status.getLastModificationTime().toEpochTime();
+  FileHash.update(ArrayRef<uint8_t>((const uint8_t *)Identity,
+                                    sizeof(Identity)));
+  MD5::MD5Result FileResult;
+  FileHash.final(FileResult);
+  SmallString<32> FileStr;
+  MD5::stringifyResult(FileResult, FileStr);
+
+  error_code ec;
+  for (section_iterator si = Obj->begin_sections(), se = Obj->end_sections();
+       si != se; si.increment(ec)) {
+    if (ec)
+      break;
+    StringRef Name, Data;
+    if (si->getName(Name) || Name != ".note.gnu.build-id" ||
+        si->getContents(Data))
+      continue;
+    // The note is namesz, descsz and type, followed by the padded name "GNU"
+    // and the ID itself. The sizes are in the byte order of the object.
+    DataExtractor Note(Data, Obj->isLittleEndian(), /*AddressSize*/ 8);
+    uint32_t Offset = 0;
+    uint32_t NameSize = Note.getU32(&Offset);
+    uint32_t DescSize = Note.getU32(&Offset);
+    Offset += 4 + RoundUpToAlignment(NameSize, 4);
+    if (DescSize == 0 || !Note.isValidOffsetForDataOfSize(Offset, DescSize))
+      break;
+    std::string Key = "buildid-";
+    for (StringRef::iterator I = Data.begin() + Offset,
+                             E = Data.begin() + Offset + DescSize;
+         I != E; ++I) {
+      Key += Hex[(unsigned char)*I >> 4];
+      Key += Hex[*I & 0xf];
+    }
+    return Key + "-" + FileStr.str().str();
+  }
+  if (!HashContents)
+    return "file-" + FileStr.str().str();
+  MD5 Hash;
+  Hash.update(Obj->getData());
+  MD5::MD5Result Result;
+  Hash.final(Result);
+  SmallString<32> Str;
+  MD5::stringifyResult(Result, Str);
+  return "md5-" + Str.str().str();
+}
+
+ModuleInfo::ModuleInfo(ObjectFile *Obj, DIContext *DICtx, StringRef Path,
+                       StringRef CacheDir, bool CacheHashContents)
     : Module(Obj), DebugInfoContext(DICtx) {
+  if (CacheDir.empty()) {
+    buildSymbolTables();
+    return;
+  }
+  SmallString<128> CachePath = CacheDir;
+  sys::path::append(CachePath,
+                    getCacheKey(Obj, Path, CacheHashContents) + ".symbols");
+  if (loadSymbolTables(CachePath))
+    return;
+  buildSymbolTables();
+  saveSymbolTables(CacheDir, CachePath);
+}
+
+namespace {
+// Orders pairs by their first element only.
+struct LessFirst {
+  template <typename T> bool operator()(const T &LHS, const T &RHS) const {
+    return LHS.first < RHS.first;
+  }
+};
+}
+
+// Sorts M by address. Like insertion into a map, this keeps the first of
+// several symbols with the same address.
+template <typename MapTy>
+static void sortAndUniqueSymbols(MapTy &M) {
+  std::stable_sort(M.begin(), M.end(), LessFirst());
+  typename MapTy::iterator I = M.begin(), E = M.end(), Out = M.begin();
+  while (I != E) {
+    *Out = *I;
+    for (++I; I != E && !(Out->first < I->first); ++I)
+      ;
+    ++Out;
+  }
+  M.erase(Out, E);
+}
+
+void ModuleInfo::buildSymbolTables() {
   error_code ec;
   for (symbol_iterator si = Module->begin_symbols(), se = Module->end_symbols();
        si != se; si.increment(ec)) {
     if (error(ec))
-      return;
+      break;
     SymbolRef::Type SymbolType;
     if (error(si->getType(SymbolType)))
       continue;
@@ -66,7 +171,7 @@ ModuleInfo::ModuleInfo(ObjectFile *Obj, DIContext *DICtx)
     uint64_t SymbolSize;
     // Getting symbol size is linear for Mach-O files, so assume that symbol
     // occupies the memory range up to the following symbol.
-    if (isa<MachOObjectFile>(Obj))
+    if (isa<MachOObjectFile>(Module.get()))
       SymbolSize = 0;
     else if (error(si->getSize(SymbolSize)) ||
              SymbolSize == UnknownAddressOrSize)
@@ -78,8 +183,97 @@ ModuleInfo::ModuleInfo(ObjectFile *Obj, DIContext *DICtx)
     // with same address size. Make sure we choose the correct one.
     SymbolMapTy &M = SymbolType == SymbolRef::ST_Function ? Functions : Objects;
     SymbolDesc SD = { SymbolAddress, SymbolSize };
-    M.insert(std::make_pair(SD, SymbolName));
+    M.push_back(std::make_pair(SD, SymbolName));
+  }
+  sortAndUniqueSymbols(Functions);
+  sortAndUniqueSymbols(Objects);
+}
+
+// The symbol table cache file starts with the magic string and version below,
+// followed by the number of functions and objects, and then by the sorted
+// functions and objects themselves. Each symbol is its address, size, name
+// length and name. All numbers are little endian.
+static const char kCacheMagic[] = "LLVMSYMC";
+static const uint32_t kCacheVersion = 1;
+
+bool ModuleInfo::loadSymbolTables(StringRef CachePath) {
+  OwningPtr<MemoryBuffer> Buf;
+  if (MemoryBuffer::getFile(CachePath, Buf))
+    return false;
+  StringRef Data = Buf->getBuffer();
+  const size_t MagicSize = sizeof(kCacheMagic) - 1;
+  if (!Data.startswith(StringRef(kCacheMagic, MagicSize)))
+    return false;
+  DataExtractor DE(Data, /*IsLittleEndian*/ true, /*AddressSize*/ 8);
+  uint32_t Offset = MagicSize;
+  if (DE.getU32(&Offset) != kCacheVersion)
+    return false;
+  uint32_t NumFunctions = DE.getU32(&Offset);
+  uint32_t NumObjects = DE.getU32(&Offset);
+  SymbolMapTy Symbols[2];
+  uint32_t Counts[2] = { NumFunctions, NumObjects };
+  for (unsigned k = 0; k != 2; ++k) {
+    for (uint32_t i = 0; i != Counts[k]; ++i) {
+      if (!DE.isValidOffsetForDataOfSize(Offset, 20))
+        return false;
+      SymbolDesc SD;
+      SD.Addr = DE.getU64(&Offset);
+      SD.Size = DE.getU64(&Offset);
+      uint32_t NameSize = DE.getU32(&Offset);
+      if (NameSize && !DE.isValidOffsetForDataOfSize(Offset, NameSize))
+        return false;
+      Symbols[k].push_back(
+          std::make_pair(SD, Data.substr(Offset, NameSize)));
+      Offset += NameSize;
+    }
   }
+  Functions.swap(Symbols[0]);
+  Objects.swap(Symbols[1]);
+  SymbolCache.swap(Buf);
+  return true;
+}
+
+static void writeLE(raw_ostream &OS, uint64_t Value, unsigned Size) {
+  for (unsigned i = 0; i != Size; ++i)
+    OS << char(Value >> (8 * i));
+}
+
+void ModuleInfo::saveSymbolTables(StringRef CacheDir,
+                                  StringRef CachePath) const {
+  // Write to a temporary file and move it into place, so that concurrent
+  // symbolizers never see a partially written cache. Failing to write the
+  // cache is not an error.
+  if (sys::fs::create_directories(CacheDir))
+    return;
+  int FD;
+  SmallString<128> TempPath;
+  if (sys::fs::unique_file(CachePath + ".tmp-%%%%%%", FD, TempPath))
+    return;
+  bool Failed;
+  {
+    raw_fd_ostream OS(FD, /*shouldClose*/ true);
+    OS << kCacheMagic;
+    writeLE(OS, kCacheVersion, 4);
+    writeLE(OS, Functions.size(), 4);
+    writeLE(OS, Objects.size(), 4);
+    const SymbolMapTy *Maps[2] = { &Functions, &Objects };
+    for (unsigned k = 0; k != 2; ++k) {
+      for (SymbolMapTy::const_iterator I = Maps[k]->begin(),
+                                       E = Maps[k]->end();
+           I != E; ++I) {
+        writeLE(OS, I->first.Addr, 8);
+        writeLE(OS, I->first.Size, 8);
+        writeLE(OS, I->second.size(), 4);
+        OS << I->second;
+      }
+    }
+    OS.close();
+    Failed = OS.has_error();
+    OS.clear_error();
+  }
+  bool Existed;
+  if (Failed || sys::fs::rename(TempPath.str(), CachePath))
+    sys::fs::remove(TempPath.str(), Existed);
 }
 
 bool ModuleInfo::getNameFromSymbolTable(SymbolRef::Type Type, uint64_t Address,
@@ -89,7 +283,9 @@ bool ModuleInfo::getNameFromSymbolTable(SymbolRef::Type Type, uint64_t Address,
   if (M.empty())
     return false;
   SymbolDesc SD = { Address, Address };
-  SymbolMapTy::const_iterator it = M.upper_bound(SD);
+  SymbolMapTy::const_iterator it =
+      std::upper_bound(M.begin(), M.end(), std::make_pair(SD, StringRef()),
+                       LessFirst());
   if (it == M.begin())
     return false;
   --it;
@@ -161,7 +357,19 @@ const char LLVMSymbolizer::kBadString[] = "??";
 
 std::string LLVMSymbolizer::symbolizeCode(const std::string &ModuleName,
                                           uint64_t ModuleOffset) {
-  ModuleInfo *Info = getOrCreateModuleInfo(ModuleName);
+  return symbolizeCode(getOrCreateModuleInfo(ModuleName), ModuleOffset);
+}
+
+std::string LLVMSymbolizer::symbolizeData(const std::string &ModuleName,
+                                          uint64_t ModuleOffset) {
+  ModuleInfo *Info = 0;
+  if (Opts.UseSymbolTable)
+    Info = getOrCreateModuleInfo(ModuleName);
+  return symbolizeData(Info, ModuleOffset);
+}
+
+std::string LLVMSymbolizer::symbolizeCode(ModuleInfo *Info,
+                                          uint64_t ModuleOffset) const {
   if (Info == 0)
     return printDILineInfo(DILineInfo());
   if (Opts.PrintInlining) {
@@ -180,22 +388,104 @@ std::string LLVMSymbolizer::symbolizeCode(const std::string &ModuleName,
   return printDILineInfo(LineInfo);
 }
 
-std::string LLVMSymbolizer::symbolizeData(const std::string &ModuleName,
-                                          uint64_t ModuleOffset) {
+std::string LLVMSymbolizer::symbolizeData(ModuleInfo *Info,
+                                          uint64_t ModuleOffset) const {
   std::string Name = kBadString;
   uint64_t Start = 0;
   uint64_t Size = 0;
-  if (Opts.UseSymbolTable) {
-    if (ModuleInfo *Info = getOrCreateModuleInfo(ModuleName)) {
-      if (Info->symbolizeData(ModuleOffset, Name, Start, Size))
-        DemangleName(Name);
-    }
+  if (Opts.UseSymbolTable && Info) {
+    if (Info->symbolizeData(ModuleOffset, Name, Start, Size))
+      DemangleName(Name);
   }
   std::stringstream ss;
   ss << Name << "\n" << Start << " " << Size << "\n";
   return ss.str();
 }
 
+// The requests of a batch that refer to one module not loaded yet.
+struct LLVMSymbolizer::ModuleBatch {
+  const LLVMSymbolizer *Symbolizer;
+  std::string ModuleName;
+  ModuleInfo *Info;
+  // Indices of the requests, sorted by offset.
+  std::vector<unsigned> Indices;
+  const std::vector<Request> *Requests;
+  std::vector<std::string> *Results;
+};
+
+namespace {
+struct RequestOffsetLess {
+  const std::vector<LLVMSymbolizer::Request> &Requests;
+  RequestOffsetLess(const std::vector<LLVMSymbolizer::Request> &Requests)
+      : Requests(Requests) {}
+  bool operator()(unsigned LHS, unsigned RHS) const {
+    return Requests[LHS].ModuleOffset < Requests[RHS].ModuleOffset;
+  }
+};
+}
+
+void LLVMSymbolizer::symbolizeModuleBatch(void *Batch) {
+  ModuleBatch &B = *static_cast<ModuleBatch *>(Batch);
+  const LLVMSymbolizer &S = *B.Symbolizer;
+  if (!B.Info)
+    B.Info = S.createModuleInfo(B.ModuleName);
+  // Each batch writes to its own elements of Results only.
+  for (unsigned i = 0, e = B.Indices.size(); i != e; ++i) {
+    const Request &R = (*B.Requests)[B.Indices[i]];
+    (*B.Results)[B.Indices[i]] = R.IsData
+                                     ? S.symbolizeData(B.Info, R.ModuleOffset)
+                                     : S.symbolizeCode(B.Info, R.ModuleOffset);
+  }
+}
+
+void LLVMSymbolizer::symbolizeBatch(const std::vector<Request> &Requests,
+                                    unsigned NumThreads,
+                                    std::vector<std::string> &Results) {
+  Results.assign(Requests.size(), std::string());
+
+  // Group the requests by module, so that every module (and its debug info)
+  // is loaded and walked once, by a single thread.
+  std::map<std::string, unsigned> BatchOfModule;
+  std::vector<ModuleBatch> Batches;
+  for (unsigned i = 0, e = Requests.size(); i != e; ++i) {
+    const Request &R = Requests[i];
+    // Data requests never need the module without the symbol table.
+    if (R.IsData && !Opts.UseSymbolTable) {
+      Results[i] = symbolizeData((ModuleInfo *)0, R.ModuleOffset);
+      continue;
+    }
+    std::pair<std::map<std::string, unsigned>::iterator, bool> Ins =
+        BatchOfModule.insert(std::make_pair(R.ModuleName, Batches.size()));
+    if (Ins.second) {
+      ModuleBatch B;
+      B.Symbolizer = this;
+      B.ModuleName = R.ModuleName;
+      ModuleMapTy::iterator I = Modules.find(R.ModuleName);
+      B.Info = I != Modules.end() ? I->second : 0;
+      B.Requests = &Requests;
+      B.Results = &Results;
+      Batches.push_back(B);
+    }
+    Batches[Ins.first->second].Indices.push_back(i);
+  }
+  if (Batches.empty())
+    return;
+
+  std::vector<void *> BatchPtrs;
+  for (unsigned i = 0, e = Batches.size(); i != e; ++i) {
+    ModuleBatch &B = Batches[i];
+    std::stable_sort(B.Indices.begin(), B.Indices.end(),
+                     RequestOffsetLess(Requests));
+    BatchPtrs.push_back(&B);
+  }
+  llvm_execute_on_threads(symbolizeModuleBatch, &BatchPtrs[0],
+                          BatchPtrs.size(), NumThreads ? NumThreads : 1);
+
+  // Keep the loaded modules for later requests.
+  for (unsigned i = 0, e = Batches.size(); i != e; ++i)
+    Modules.insert(make_pair(Batches[i].ModuleName, Batches[i].Info));
+}
+
 void LLVMSymbolizer::flush() {
   DeleteContainerSeconds(Modules);
 }
@@ -229,12 +519,18 @@ LLVMSymbolizer::getOrCreateModuleInfo(const std::string &ModuleName) {
   if (I != Modules.end())
     return I->second;
 
+  // A null ModuleInfo records that the module name doesn't point to a valid
+  // object file.
+  ModuleInfo *Info = createModuleInfo(ModuleName);
+  Modules.insert(make_pair(ModuleName, Info));
+  return Info;
+}
+
+ModuleInfo *
+LLVMSymbolizer::createModuleInfo(const std::string &ModuleName) const {
   ObjectFile *Obj = getObjectFile(ModuleName);
-  if (Obj == 0) {
-    // Module name doesn't point to a valid object file.
-    Modules.insert(make_pair(ModuleName, (ModuleInfo *)0));
+  if (Obj == 0)
     return 0;
-  }
 
   DIContext *Context = 0;
   bool IsLittleEndian;
@@ -254,11 +550,11 @@ LLVMSymbolizer::getOrCreateModuleInfo(const std::string &ModuleName) {
     }
     Context = DIContext::getDWARFContext(DbgObj);
     assert(Context);
+    Context->setMemoryBudget(Opts.DebugInfoMemoryBudget);
   }
 
-  ModuleInfo *Info = new ModuleInfo(Obj, Context);
-  Modules.insert(make_pair(ModuleName, Info));
-  return Info;
+  return new ModuleInfo(Obj, Context, ModuleName, Opts.CacheDir,
+                        Opts.CacheHashContents);
 }
 
 std::string LLVMSymbolizer::printDILineInfo(DILineInfo LineInfo) const {
@@ -19,6 +19,7 @@
 #include "llvm/Support/MemoryBuffer.h"
 #include <map>
 #include <string>
+#include <vector>
 
 namespace llvm {
 
@@ -35,13 +36,30 @@ public:
     bool PrintFunctions : 1;
     bool PrintInlining : 1;
     bool Demangle : 1;
+    uint64_t DebugInfoMemoryBudget;
+    // If not empty, the directory in which the symbol tables of the modules
+    // are cached between runs.
+    std::string CacheDir;
+    // Key the cache entries of modules without a build ID on a hash of their
+    // contents rather than on their path, size and modification time.
+    bool CacheHashContents;
     Options(bool UseSymbolTable = true, bool PrintFunctions = true,
-            bool PrintInlining = true, bool Demangle = true)
+            bool PrintInlining = true, bool Demangle = true,
+            uint64_t DebugInfoMemoryBudget = 0,
+            const std::string &CacheDir = "", bool CacheHashContents = false)
         : UseSymbolTable(UseSymbolTable), PrintFunctions(PrintFunctions),
-          PrintInlining(PrintInlining), Demangle(Demangle) {
+          PrintInlining(PrintInlining), Demangle(Demangle),
+          DebugInfoMemoryBudget(DebugInfoMemoryBudget), CacheDir(CacheDir),
+          CacheHashContents(CacheHashContents) {
     }
   };
 
+  struct Request {
+    std::string ModuleName;
+    uint64_t ModuleOffset;
+    bool IsData;
+  };
+
   LLVMSymbolizer(const Options &Opts = Options()) : Opts(Opts) {}
 
   // Returns the result of symbolization for module name/offset as
@@ -50,9 +68,20 @@ public:
   symbolizeCode(const std::string &ModuleName, uint64_t ModuleOffset);
   std::string
   symbolizeData(const std::string &ModuleName, uint64_t ModuleOffset);
+  // Symbolizes all of Requests and stores the result for Requests[i] in
+  // Results[i]. The requests are handled one module at a time, in order of
+  // increasing offsets, and up to NumThreads modules are handled in parallel.
+  void symbolizeBatch(const std::vector<Request> &Requests,
+                      unsigned NumThreads, std::vector<std::string> &Results);
   void flush();
 private:
+  struct ModuleBatch;
+  static void symbolizeModuleBatch(void *Batch);
+
   ModuleInfo *getOrCreateModuleInfo(const std::string &ModuleName);
+  ModuleInfo *createModuleInfo(const std::string &ModuleName) const;
+  std::string symbolizeCode(ModuleInfo *Info, uint64_t ModuleOffset) const;
+  std::string symbolizeData(ModuleInfo *Info, uint64_t ModuleOffset) const;
   std::string printDILineInfo(DILineInfo LineInfo) const;
   void DemangleName(std::string &Name) const;
 
@@ -64,7 +93,8 @@ private:
 
 class ModuleInfo {
 public:
-  ModuleInfo(ObjectFile *Obj, DIContext *DICtx);
+  ModuleInfo(ObjectFile *Obj, DIContext *DICtx, StringRef Path,
+             StringRef CacheDir, bool CacheHashContents);
 
   DILineInfo symbolizeCode(uint64_t ModuleOffset,
                            const LLVMSymbolizer::Options &Opts) const;
@@ -77,8 +107,13 @@ private:
   bool getNameFromSymbolTable(SymbolRef::Type Type, uint64_t Address,
                               std::string &Name, uint64_t &Addr,
                               uint64_t &Size) const;
+  void buildSymbolTables();
+  bool loadSymbolTables(StringRef CachePath);
+  void saveSymbolTables(StringRef CacheDir, StringRef CachePath) const;
   OwningPtr<ObjectFile> Module;
   OwningPtr<DIContext> DebugInfoContext;
+  // The cache file the symbol names point into, if they were loaded from it.
+  OwningPtr<MemoryBuffer> SymbolCache;
 
   struct SymbolDesc {
     uint64_t Addr;
@@ -89,7 +124,8 @@ private:
       return s1.Addr < s2.Addr;
     }
   };
-  typedef std::map<SymbolDesc, StringRef> SymbolMapTy;
+  // Symbols sorted by address, with at most one symbol per address.
+  typedef std::vector<std::pair<SymbolDesc, StringRef> > SymbolMapTy;
   SymbolMapTy Functions;
   SymbolMapTy Objects;
 };
@@ -22,6 +22,7 @@
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Signals.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/raw_ostream.h"
 #include <cstdio>
 #include <cstring>
@@ -47,6 +48,32 @@ ClPrintInlining("inlining", cl::init(true),
 static cl::opt<bool>
 ClDemangle("demangle", cl::init(true), cl::desc("Demangle function names"));
 
+static cl::opt<unsigned long long>
+ClDWARFMemoryBudget("dwarf-memory-budget", cl::init(0),
+                    cl::desc("Approximate number of bytes of parsed debug "
+                             "info to keep per module between lookups "
+                             "(0 = no limit)"));
+
+static cl::opt<std::string>
+ClCacheDir("cache-dir", cl::init(""),
+           cl::desc("Directory in which to cache the symbol tables of the "
+                    "modules between runs"));
+
+static cl::opt<bool>
+ClCacheHashContents("cache-hash-contents", cl::init(false),
+                    cl::desc("Key the cache entries of modules without a "
+                             "build ID on a hash of their contents"));
+
+static cl::opt<bool>
+ClBatch("batch", cl::init(false),
+        cl::desc("Read all of the input before answering, and symbolize it "
+                 "one module at a time"));
+
+static cl::opt<unsigned>
+ClNumThreads("j", cl::init(1), cl::Prefix,
+             cl::desc("Number of modules to symbolize in parallel in batch "
+                      "mode"));
+
 static bool parseCommand(bool &IsData, std::string &ModuleName,
                          uint64_t &ModuleOffset) {
   const char *kDataCmd = "DATA ";
@@ -102,12 +129,29 @@ int main(int argc, char **argv) {
 
   cl::ParseCommandLineOptions(argc, argv, "llvm symbolizer for compiler-rt\n");
   LLVMSymbolizer::Options Opts(ClUseSymbolTable, ClPrintFunctions,
-                               ClPrintInlining, ClDemangle);
+                               ClPrintInlining, ClDemangle,
+                               ClDWARFMemoryBudget, ClCacheDir,
+                               ClCacheHashContents);
   LLVMSymbolizer Symbolizer(Opts);
 
   bool IsData = false;
   std::string ModuleName;
   uint64_t ModuleOffset;
+  if (ClBatch) {
+    std::vector<LLVMSymbolizer::Request> Requests;
+    while (parseCommand(IsData, ModuleName, ModuleOffset)) {
+      LLVMSymbolizer::Request R = { ModuleName, ModuleOffset, IsData };
+      Requests.push_back(R);
+    }
+    if (ClNumThreads > 1)
+      llvm_start_multithreaded();
+    std::vector<std::string> Results;
+    Symbolizer.symbolizeBatch(Requests, ClNumThreads, Results);
+    for (unsigned i = 0, e = Results.size(); i != e; ++i)
+      outs() << Results[i] << "\n";
+    return 0;
+  }
+
   while (parseCommand(IsData, ModuleName, ModuleOffset)) {
     std::string Result =
         IsData ? Symbolizer.symbolizeData(ModuleName, ModuleOffset)
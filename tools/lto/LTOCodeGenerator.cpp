@@ -18,6 +18,7 @@
 #include "llvm/Analysis/Passes.h"
 #include "llvm/Analysis/Verifier.h"
 #include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/CodeGen/ParallelCG.h"
 #include "llvm/Config/config.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DataLayout.h"
@@ -37,6 +38,7 @@
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Support/system_error.h"
 #include "llvm/Target/Mangler.h"
@@ -70,7 +72,8 @@ const char* LTOCodeGenerator::getVersionString() {
 
 LTOCodeGenerator::LTOCodeGenerator()
   : _context(getGlobalContext()),
-    _linker(new Module("ld-temp.o", _context)), _target(NULL),
+    _linker(new Module("ld-temp.o", _context)), _target(NULL), _march(NULL),
+    _relocModel(Reloc::Default),
     _emitDwarfDebugInfo(false), _scopeRestrictionsDone(false),
     _codeModel(LTO_CODEGEN_PIC_MODEL_DYNAMIC),
     _nativeObjectFile(NULL) {
@@ -158,36 +161,86 @@ bool LTOCodeGenerator::writeMergedModules(const char *path,
   return false;
 }
 
-bool LTOCodeGenerator::compile_to_file(const char** name, std::string& errMsg) {
-  // make unique temp .o file to put generated object file
-  SmallString<128> Filename;
-  int FD;
-  error_code EC = sys::fs::unique_file("lto-llvm-%%%%%%%.o",
-                                       FD, Filename);
-  if (EC) {
-    errMsg = EC.message();
-    return true;
+/// createObjectFiles - Generate code for the merged module into
+/// numPartitions new temporary object files, and record their names.
+bool LTOCodeGenerator::createObjectFiles(unsigned numPartitions,
+                                         std::string &errMsg) {
+  _nativeObjectPaths.clear();
+  _nativeObjectNames.clear();
+
+  // make unique temp .o files to put generated object files
+  std::vector<tool_output_file*> objFiles;
+  std::vector<raw_ostream*> outs;
+  std::vector<std::string> paths;
+  bool genResult = false;
+  for (unsigned i = 0; i != numPartitions; ++i) {
+    SmallString<128> Filename;
+    int FD;
+    error_code EC = sys::fs::unique_file("lto-llvm-%%%%%%%.o",
+                                         FD, Filename);
+    if (EC) {
+      errMsg = EC.message();
+      genResult = true;
+      break;
+    }
+    objFiles.push_back(new tool_output_file(Filename.c_str(), FD));
+    outs.push_back(&objFiles.back()->os());
+    paths.push_back(Filename.str());
   }
 
-  // generate object file
-  tool_output_file objFile(Filename.c_str(), FD);
+  // generate object files
+  if (!genResult)
+    genResult = generateObjectFiles(outs, errMsg);
 
-  bool genResult = generateObjectFile(objFile.os(), errMsg);
-  objFile.os().close();
-  if (objFile.os().has_error()) {
-    objFile.os().clear_error();
-    sys::fs::remove(Twine(Filename));
-    return true;
+  for (unsigned i = 0, e = objFiles.size(); i != e; ++i) {
+    objFiles[i]->os().close();
+    if (objFiles[i]->os().has_error()) {
+      objFiles[i]->os().clear_error();
+      genResult = true;
+    }
+    objFiles[i]->keep();
+    delete objFiles[i];
   }
 
-  objFile.keep();
   if (genResult) {
-    sys::fs::remove(Twine(Filename));
+    for (unsigned i = 0, e = paths.size(); i != e; ++i)
+      sys::fs::remove(paths[i]);
     return true;
   }
 
-  _nativeObjectPath = Filename.c_str();
-  *name = _nativeObjectPath.c_str();
+  _nativeObjectPaths.swap(paths);
+  for (unsigned i = 0; i != numPartitions; ++i)
+    _nativeObjectNames.push_back(_nativeObjectPaths[i].c_str());
+  return false;
+}
+
+bool LTOCodeGenerator::compile_to_file(const char** name, std::string& errMsg) {
+  if (createObjectFiles(1, errMsg))
+    return true;
+
+  *name = _nativeObjectNames[0];
+  return false;
+}
+
+/// compile_to_files - Split the merged module into numPartitions partitions,
+/// and generate code for them in parallel into one object file each.
+bool LTOCodeGenerator::compile_to_files(unsigned numPartitions,
+                                        const char *const **names,
+                                        unsigned *count, std::string &errMsg) {
+  if (numPartitions == 0) {
+    errMsg = "the number of partitions must be at least one";
+    return true;
+  }
+
+  // The partitions are compiled on separate threads.
+  if (numPartitions > 1 && !llvm_is_multithreaded())
+    llvm_start_multithreaded();
+
+  if (createObjectFiles(numPartitions, errMsg))
+    return true;
+
+  *names = &_nativeObjectNames[0];
+  *count = _nativeObjectNames.size();
   return false;
 }
 
@@ -203,13 +256,13 @@ const void* LTOCodeGenerator::compile(size_t* length, std::string& errMsg) {
   OwningPtr<MemoryBuffer> BuffPtr;
   if (error_code ec = MemoryBuffer::getFile(name, BuffPtr, -1, false)) {
     errMsg = ec.message();
-    sys::fs::remove(_nativeObjectPath);
+    sys::fs::remove(name);
     return NULL;
   }
   _nativeObjectFile = BuffPtr.take();
 
   // remove temp files
-  sys::fs::remove(_nativeObjectPath);
+  sys::fs::remove(name);
 
   // return buffer, unless error
   if (_nativeObjectFile == NULL)
@@ -233,29 +286,30 @@ bool LTOCodeGenerator::determineTarget(std::string &errMsg) {
   llvm::Triple Triple(TripleStr);
 
   // create target machine from info for merged modules
-  const Target *march = TargetRegistry::lookupTarget(TripleStr, errMsg);
-  if (march == NULL)
+  _march = TargetRegistry::lookupTarget(TripleStr, errMsg);
+  if (_march == NULL)
     return true;
+  _tripleStr = TripleStr;
 
   // The relocation model is actually a static member of TargetMachine and
   // needs to be set before the TargetMachine is instantiated.
-  Reloc::Model RelocModel = Reloc::Default;
+  _relocModel = Reloc::Default;
   switch (_codeModel) {
   case LTO_CODEGEN_PIC_MODEL_STATIC:
-    RelocModel = Reloc::Static;
+    _relocModel = Reloc::Static;
     break;
   case LTO_CODEGEN_PIC_MODEL_DYNAMIC:
-    RelocModel = Reloc::PIC_;
+    _relocModel = Reloc::PIC_;
     break;
   case LTO_CODEGEN_PIC_MODEL_DYNAMIC_NO_PIC:
-    RelocModel = Reloc::DynamicNoPIC;
+    _relocModel = Reloc::DynamicNoPIC;
     break;
   }
 
   // construct LTOModule, hand over ownership of module and target
   SubtargetFeatures Features;
   Features.getDefaultSubtargetFeatures(Triple);
-  std::string FeatureStr = Features.getString();
+  _featureStr = Features.getString();
   // Set a default CPU for Darwin triples.
   if (_mCpu.empty() && Triple.isOSDarwin()) {
     if (Triple.getArch() == llvm::Triple::x86_64)
@@ -263,12 +317,20 @@ bool LTOCodeGenerator::determineTarget(std::string &errMsg) {
     else if (Triple.getArch() == llvm::Triple::x86)
       _mCpu = "yonah";
   }
+  _target = createTargetMachine(this);
+  return false;
+}
+
+/// createTargetMachine - Create a TargetMachine for the merged module, or for
+/// one of its partitions.  This may be called from several threads at once.
+TargetMachine *LTOCodeGenerator::createTargetMachine(void *codeGen) {
+  const LTOCodeGenerator &CG = *static_cast<LTOCodeGenerator*>(codeGen);
   TargetOptions Options;
   LTOModule::getTargetOptions(Options);
-  _target = march->createTargetMachine(TripleStr, _mCpu, FeatureStr, Options,
-                                       RelocModel, CodeModel::Default,
-                                       CodeGenOpt::Aggressive);
-  return false;
+  return CG._march->createTargetMachine(CG._tripleStr, CG._mCpu,
+                                        CG._featureStr, Options,
+                                        CG._relocModel, CodeModel::Default,
+                                        CodeGenOpt::Aggressive);
 }
 
 void LTOCodeGenerator::
@@ -356,9 +418,11 @@ void LTOCodeGenerator::applyScopeRestrictions() {
   _scopeRestrictionsDone = true;
 }
 
-/// Optimize merged modules using various IPO passes
-bool LTOCodeGenerator::generateObjectFile(raw_ostream &out,
-                                          std::string &errMsg) {
+/// Optimize merged modules using various IPO passes, and generate code into
+/// outs.size() object files.  The optimizations need the whole program, so
+/// only code generation is split into partitions.
+bool LTOCodeGenerator::generateObjectFiles(ArrayRef<raw_ostream *> outs,
+                                           std::string &errMsg) {
   if (this->determineTarget(errMsg))
     return true;
 
@@ -389,12 +453,27 @@ bool LTOCodeGenerator::generateObjectFile(raw_ostream &out,
   // Make sure everything is still good.
   passes.add(createVerifierPass());
 
+  if (outs.size() > 1) {
+    // If the bitcode files contain ARC code and were compiled with
+    // optimization, the ObjCARCContractPass must be run before code
+    // generation, so do it unconditionally here.
+    passes.add(createObjCARCContractPass());
+
+    // Run our queue of passes all at once now, efficiently.
+    passes.run(*mergedModule);
+
+    // Generate code for the partitions in parallel, one per thread.
+    return splitCodeGen(*mergedModule, outs, outs.size(),
+                        createTargetMachine, this,
+                        TargetMachine::CGFT_ObjectFile, errMsg);
+  }
+
   PassManager codeGenPasses;
 
   codeGenPasses.add(new DataLayout(*_target->getDataLayout()));
   _target->addAnalysisPasses(codeGenPasses);
 
-  formatted_raw_ostream Out(out);
+  formatted_raw_ostream Out(*outs[0]);
 
   // If the bitcode files contain ARC code and were compiled with optimization,
   // the ObjCARCContractPass must be run, so do it unconditionally here.
@@ -15,9 +15,11 @@
 #define LTO_CODE_GENERATOR_H
 
 #include "llvm-c/lto.h"
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/Linker.h"
+#include "llvm/Support/CodeGen.h"
 #include <string>
 #include <vector>
 
@@ -26,6 +28,7 @@ namespace llvm {
   class GlobalValue;
   class Mangler;
   class MemoryBuffer;
+  class Target;
   class TargetMachine;
   class raw_ostream;
 }
@@ -52,11 +55,16 @@ struct LTOCodeGenerator {
 
   bool writeMergedModules(const char *path, std::string &errMsg);
   bool compile_to_file(const char **name, std::string &errMsg);
+  bool compile_to_files(unsigned numPartitions, const char *const **names,
+                        unsigned *count, std::string &errMsg);
   const void *compile(size_t *length, std::string &errMsg);
   void setCodeGenDebugOptions(const char *opts);
 
 private:
-  bool generateObjectFile(llvm::raw_ostream &out, std::string &errMsg);
+  bool generateObjectFiles(llvm::ArrayRef<llvm::raw_ostream *> outs,
+                           std::string &errMsg);
+  bool createObjectFiles(unsigned numPartitions, std::string &errMsg);
+  static llvm::TargetMachine *createTargetMachine(void *codeGen);
   void applyScopeRestrictions();
   void applyRestriction(llvm::GlobalValue &GV,
                         std::vector<const char*> &mustPreserveList,
@@ -69,6 +77,10 @@ private:
   llvm::LLVMContext&          _context;
   llvm::Linker                _linker;
   llvm::TargetMachine*        _target;
+  const llvm::Target*         _march;
+  std::string                 _tripleStr;
+  std::string                 _featureStr;
+  llvm::Reloc::Model          _relocModel;
   bool                        _emitDwarfDebugInfo;
   bool                        _scopeRestrictionsDone;
   lto_codegen_model           _codeModel;
@@ -77,7 +89,8 @@ private:
   llvm::MemoryBuffer*         _nativeObjectFile;
   std::vector<char*>          _codegenOptions;
   std::string                 _mCpu;
-  std::string                 _nativeObjectPath;
+  std::vector<std::string>    _nativeObjectPaths;
+  std::vector<const char*>    _nativeObjectNames;
 };
 
 #endif // LTO_CODE_GENERATOR_H
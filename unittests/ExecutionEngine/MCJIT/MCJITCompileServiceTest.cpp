@@ -0,0 +1,212 @@
+//===- MCJITCompileServiceTest.cpp - Unit tests for MCJITCompileService ---===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This test suite compiles many modules concurrently through the
+// MCJITCompileService, and checks that every one of them ends up with working
+// code.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ExecutionEngine/MCJITCompileService.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ExecutionEngine/MCJIT.h"
+#include "llvm/Support/Threading.h"
+#include "MCJITTestBase.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+namespace {
+
+class MCJITCompileServiceTest : public testing::Test, public MCJITTestBase {
+protected:
+  virtual void SetUp() {
+    // The service only uses threads in multithreaded mode.
+    if (!llvm_is_multithreaded())
+      llvm_start_multithreaded();
+  }
+
+  virtual void TearDown() {
+    // The service owns the modules, so it has to go before their contexts.
+    Service.reset();
+    for (unsigned i = 0, e = Contexts.size(); i != e; ++i)
+      delete Contexts[i];
+  }
+
+  LLVMContext &createContext() {
+    Contexts.push_back(new LLVMContext());
+    return *Contexts.back();
+  }
+
+  /// createModule - Create a module in Ctx defining "int Name(int x)", which
+  /// returns x * Mul + Add computed in a loop, so that the code generator has
+  /// some work to do.
+  Module *createModule(LLVMContext &Ctx, StringRef Name, int Mul, int Add) {
+    Module *Mod = new Module(("module." + Name).str(), Ctx);
+    Mod->setTargetTriple(Triple::normalize(HostTriple));
+    Type *Int32Ty = Type::getInt32Ty(Ctx);
+    Type *Params[] = { Int32Ty };
+    Function *F = Function::Create(FunctionType::get(Int32Ty, Params, false),
+                                   GlobalValue::ExternalLinkage, Name, Mod);
+    Value *X = F->arg_begin();
+
+    BasicBlock *Entry = BasicBlock::Create(Ctx, "entry", F);
+    BasicBlock *Loop = BasicBlock::Create(Ctx, "loop", F);
+    BasicBlock *Exit = BasicBlock::Create(Ctx, "exit", F);
+    IRBuilder<> B(Entry);
+    B.CreateBr(Loop);
+
+    B.SetInsertPoint(Loop);
+    PHINode *I = B.CreatePHI(Int32Ty, 2, "i");
+    PHINode *Acc = B.CreatePHI(Int32Ty, 2, "acc");
+    Value *NextAcc = B.CreateAdd(Acc, X, "acc.next");
+    Value *NextI = B.CreateAdd(I, B.getInt32(1), "i.next");
+    I->addIncoming(B.getInt32(0), Entry);
+    I->addIncoming(NextI, Loop);
+    Acc->addIncoming(B.getInt32(Add), Entry);
+    Acc->addIncoming(NextAcc, Loop);
+    B.CreateCondBr(B.CreateICmpSLT(NextI, B.getInt32(Mul)), Loop, Exit);
+
+    B.SetInsertPoint(Exit);
+    B.CreateRet(NextAcc);
+    return Mod;
+  }
+
+  /// Submitter - One client thread of the concurrent_clients test.  It builds
+  /// a module in its own context, queues it and compiles whatever is pending.
+  struct Submitter {
+    MCJITCompileServiceTest *Test;
+    LLVMContext *Ctx;
+    unsigned Index;
+    MCJITCompileService::Ticket Ticket;
+    bool CompiledOnReturn;
+  };
+
+  static void submit(void *Arg) {
+    Submitter &S = *static_cast<Submitter*>(Arg);
+    MCJITCompileService &Service = *S.Test->Service;
+    std::string Name = "s" + utostr(S.Index);
+    S.Ticket = Service.addModule(
+      S.Test->createModule(*S.Ctx, Name, S.Index % 5 + 1, S.Index), Name);
+    Service.compilePending();
+    S.CompiledOnReturn = Service.isCompiled(S.Ticket);
+  }
+
+  OwningPtr<MCJITCompileService> Service;
+  std::vector<LLVMContext*> Contexts;
+};
+
+typedef int (*IntFn)(int);
+
+TEST_F(MCJITCompileServiceTest, many_contexts) {
+  SKIP_UNSUPPORTED_PLATFORM;
+
+  const unsigned NumModules = 64;
+  Service.reset(new MCJITCompileService(8, CodeGenOpt::Default));
+  std::vector<MCJITCompileService::Ticket> Tickets;
+  for (unsigned i = 0; i != NumModules; ++i) {
+    std::string Name = "f" + utostr(i);
+    Tickets.push_back(Service->addModule(
+      createModule(createContext(), Name, i % 7 + 1, i), Name));
+  }
+  Service->compilePending();
+
+  for (unsigned i = 0; i != NumModules; ++i) {
+    MCJITCompileService::Ticket T = Tickets[i];
+    ASSERT_TRUE(Service->isCompiled(T));
+    ASSERT_TRUE(Service->getFunctionAddress(T) != 0)
+      << Service->getErrorMessage(T);
+    IntFn F = (IntFn)(intptr_t)Service->getFunctionAddress(T);
+    EXPECT_EQ(int(3 * (i % 7 + 1) + i), F(3));
+  }
+}
+
+TEST_F(MCJITCompileServiceTest, shared_contexts) {
+  SKIP_UNSUPPORTED_PLATFORM;
+
+  // Modules sharing a context are compiled on the same thread.
+  LLVMContext &Ctx0 = createContext(), &Ctx1 = createContext();
+  Service.reset(new MCJITCompileService(4));
+  std::vector<MCJITCompileService::Ticket> Tickets;
+  for (unsigned i = 0; i != 16; ++i) {
+    std::string Name = "g" + utostr(i);
+    Tickets.push_back(Service->addModule(
+      createModule(i % 2 ? Ctx1 : Ctx0, Name, 2, i), Name));
+  }
+  Service->compilePending();
+
+  for (unsigned i = 0; i != 16; ++i) {
+    IntFn F = (IntFn)(intptr_t)Service->getFunctionAddress(Tickets[i]);
+    ASSERT_TRUE(F != 0) << Service->getErrorMessage(Tickets[i]);
+    EXPECT_EQ(int(10 + i), F(5));
+  }
+}
+
+TEST_F(MCJITCompileServiceTest, batches) {
+  SKIP_UNSUPPORTED_PLATFORM;
+
+  Service.reset(new MCJITCompileService(4));
+  MCJITCompileService::Ticket First =
+    Service->addModule(createModule(createContext(), "h0", 1, 0), "h0");
+  Service->compilePending();
+  MCJITCompileService::Ticket Second =
+    Service->addModule(createModule(createContext(), "h1", 1, 1), "h1");
+  EXPECT_TRUE(Service->isCompiled(First));
+  EXPECT_FALSE(Service->isCompiled(Second));
+  Service->compilePending();
+
+  ASSERT_TRUE(Service->isCompiled(Second));
+  IntFn F = (IntFn)(intptr_t)Service->getFunctionAddress(Second);
+  ASSERT_TRUE(F != 0) << Service->getErrorMessage(Second);
+  EXPECT_EQ(8, F(7));
+}
+
+TEST_F(MCJITCompileServiceTest, concurrent_clients) {
+  SKIP_UNSUPPORTED_PLATFORM;
+
+  // Several threads add modules and call compilePending at the same time,
+  // while the service compiles on threads of its own.
+  const unsigned NumClients = 32;
+  Service.reset(new MCJITCompileService(4));
+  std::vector<Submitter> Clients(NumClients);
+  std::vector<void*> ClientPtrs;
+  for (unsigned i = 0; i != NumClients; ++i) {
+    Submitter S = { this, &createContext(), i, 0, false };
+    Clients[i] = S;
+    ClientPtrs.push_back(&Clients[i]);
+  }
+  llvm_execute_on_threads(submit, &ClientPtrs[0], NumClients, 8);
+
+  std::vector<bool> SeenTicket(NumClients);
+  for (unsigned i = 0; i != NumClients; ++i) {
+    const Submitter &S = Clients[i];
+    EXPECT_TRUE(S.CompiledOnReturn);
+    ASSERT_TRUE(S.Ticket < NumClients);
+    EXPECT_FALSE(SeenTicket[S.Ticket]);
+    SeenTicket[S.Ticket] = true;
+    IntFn F = (IntFn)(intptr_t)Service->getFunctionAddress(S.Ticket);
+    ASSERT_TRUE(F != 0) << Service->getErrorMessage(S.Ticket);
+    EXPECT_EQ(int(4 * (i % 5 + 1) + i), F(4));
+  }
+}
+
+TEST_F(MCJITCompileServiceTest, missing_function) {
+  SKIP_UNSUPPORTED_PLATFORM;
+
+  Service.reset(new MCJITCompileService(2));
+  MCJITCompileService::Ticket T =
+    Service->addModule(createModule(createContext(), "k", 1, 0), "nope");
+  Service->compilePending();
+
+  EXPECT_TRUE(Service->isCompiled(T));
+  EXPECT_TRUE(Service->getFunctionAddress(T) == 0);
+  EXPECT_FALSE(Service->getErrorMessage(T).empty());
+}
+
+}
@@ -0,0 +1,127 @@
+//===- llvm/unittest/IR/ModuleTest.cpp - Module unit tests ----------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/IR/Module.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/Assembly/Parser.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/ValueSymbolTable.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/Timer.h"
+#include "llvm/Support/ValueHandle.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+using namespace llvm;
+
+namespace {
+
+TEST(ModuleTest, DropAllAndRelease) {
+  LLVMContext C;
+
+  const char *ModuleString =
+      "@g = global i32 0\n"
+      "@addr = global i8* blockaddress(@f, %target)\n"
+      "define i32 @f(i32 %x) {\n"
+      "entry:\n"
+      "  %a = add i32 %x, 12345\n"
+      "  %c = icmp eq i32 %a, 0\n"
+      "  br i1 %c, label %target, label %exit\n"
+      "target:\n"
+      "  store i32 %a, i32* @g\n"
+      "  br label %exit\n"
+      "exit:\n"
+      "  %p = phi i32 [ %a, %entry ], [ 0, %target ]\n"
+      "  ret i32 %p\n"
+      "}\n"
+      "define i8* @h() {\n"
+      "  %r = call i32 @f(i32 54321)\n"
+      "  ret i8* blockaddress(@f, %target)\n"
+      "}\n";
+  SMDiagnostic Err;
+  OwningPtr<Module> M(ParseAssemblyString(ModuleString, NULL, Err, C));
+  ASSERT_TRUE(M.get() != 0);
+
+  Function *F = M->getFunction("f");
+  WeakVH Add(F->getEntryBlock().begin());
+  Constant *K1 = ConstantInt::get(Type::getInt32Ty(C), 12345);
+  Constant *K2 = ConstantInt::get(Type::getInt32Ty(C), 54321);
+  EXPECT_FALSE(K1->use_empty());
+  EXPECT_FALSE(K2->use_empty());
+
+  M->dropAllAndRelease();
+  EXPECT_TRUE(M->empty());
+  EXPECT_TRUE(M->global_empty());
+  EXPECT_TRUE(M->getValueSymbolTable().empty());
+  EXPECT_TRUE(Add == 0);
+  EXPECT_TRUE(K1->use_empty());
+  EXPECT_TRUE(K2->use_empty());
+
+  // The module can still be used.
+  M->getOrInsertFunction("f", Type::getVoidTy(C), NULL);
+  EXPECT_TRUE(M->getFunction("f") != 0);
+}
+
+/// buildModule - Create a module with NumFunctions functions of NumBlocks
+/// blocks, each with a chain of named arithmetic instructions.
+static Module *buildModule(LLVMContext &C, unsigned NumFunctions,
+                           unsigned NumBlocks) {
+  Module *M = new Module("bench", C);
+  Type *Int32Ty = Type::getInt32Ty(C);
+  Type *Params[] = { Int32Ty };
+  FunctionType *FTy = FunctionType::get(Int32Ty, Params, false);
+  for (unsigned f = 0; f != NumFunctions; ++f) {
+    Function *F = Function::Create(FTy, GlobalValue::ExternalLinkage, "f", M);
+    IRBuilder<> B(BasicBlock::Create(C, "entry", F));
+    Value *V = F->arg_begin();
+    for (unsigned b = 0; b != NumBlocks; ++b) {
+      V = B.CreateAdd(V, B.getInt32(b), "add");
+      V = B.CreateMul(V, V, "mul");
+      V = B.CreateXor(V, F->arg_begin(), "xor");
+      BasicBlock *Next = BasicBlock::Create(C, "bb", F);
+      B.CreateBr(Next);
+      B.SetInsertPoint(Next);
+    }
+    B.CreateRet(V);
+  }
+  return M;
+}
+
+// Compares deleting a module directly with releasing it first.  Disabled by
+// default; run with --gtest_also_run_disabled_tests.
+TEST(ModuleTest, DISABLED_ReleaseBenchmark) {
+  LLVMContext C;
+  const unsigned NumFunctions = 2000, NumBlocks = 100, Rounds = 3;
+  double Build = 0, Delete = 0, Release = 0;
+  for (unsigned r = 0; r != Rounds; ++r) {
+    TimeRecord Start = TimeRecord::getCurrentTime();
+    Module *M = buildModule(C, NumFunctions, NumBlocks);
+    TimeRecord Built = TimeRecord::getCurrentTime();
+    delete M;
+    TimeRecord Deleted = TimeRecord::getCurrentTime();
+    Build += Built.getWallTime() - Start.getWallTime();
+    Delete += Deleted.getWallTime() - Built.getWallTime();
+
+    Start = TimeRecord::getCurrentTime();
+    M = buildModule(C, NumFunctions, NumBlocks);
+    Built = TimeRecord::getCurrentTime();
+    M->dropAllAndRelease();
+    delete M;
+    Deleted = TimeRecord::getCurrentTime();
+    Build += Built.getWallTime() - Start.getWallTime();
+    Release += Deleted.getWallTime() - Built.getWallTime();
+  }
+  outs() << "build: " << Build / (2 * Rounds) << "s, delete: "
+         << Delete / Rounds << "s, dropAllAndRelease: " << Release / Rounds
+         << "s\n";
+}
+
+} // end anonymous namespace
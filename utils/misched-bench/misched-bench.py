@@ -0,0 +1,176 @@
+#!/usr/bin/env python
+
+"""Compile-time and schedule quality benchmark for the MachineScheduler.
+
+Runs a fixed corpus of IR files through llc once for every registered
+MachineSchedRegistry strategy and collects the -misched-report records that
+llc prints for each scheduled region. The result is a CSV file with one row
+per region, or one row per strategy with --summary, suitable for tracking the
+cost and quality of the scheduling strategies across releases. With --from-csv
+the summary is computed from the per-region CSV of an earlier run instead of
+running llc again.
+
+Strategies are discovered from 'llc -help-hidden', so schedulers added by a
+target or by a plugin are picked up automatically.
+"""
+
+import argparse
+import csv
+import os
+import subprocess
+import sys
+
+# The corpus is a fixed list of files from the LLVM test suite so that the
+# numbers stay comparable from one release to the next. Every file is compiled
+# with the same target options.
+CORPUS = [
+  'test/CodeGen/X86/misched-balance.ll',
+  'test/CodeGen/X86/misched-fusion.ll',
+  'test/CodeGen/X86/misched-ilp.ll',
+  'test/CodeGen/X86/misched-matmul.ll',
+  'test/CodeGen/X86/misched-matrix.ll',
+  'test/CodeGen/X86/misched-new.ll',
+  'test/CodeGen/X86/2007-10-15-CoalescerCrash.ll',
+  'test/CodeGen/X86/2009-04-27-CoalescerAssert.ll',
+  'test/CodeGen/X86/lsr-reuse.ll',
+  'test/CodeGen/X86/scev-interchange.ll',
+  'test/CodeGen/X86/sse-minmax.ll',
+]
+
+LLC_ARGS = ['-mtriple=x86_64-unknown-linux-gnu', '-mcpu=core2',
+            '-pre-RA-sched=source', '-enable-misched', '-misched-report']
+
+# Columns of the 'misched,...' records printed by llc -misched-report.
+REPORT_FIELDS = ['scheduler', 'function', 'block', 'nodes', 'edges',
+                 'critical_path', 'max_pressure', 'sched_max_pressure',
+                 'excess_pressure', 'sched_excess_pressure', 'usec']
+
+SUMMARY_FIELDS = ['scheduler', 'regions', 'nodes', 'edges', 'critical_path',
+                  'max_pressure', 'sched_max_pressure', 'excess_pressure',
+                  'sched_excess_pressure', 'usec']
+
+def find_strategies(llc):
+  """Return the names accepted by llc -misched=<name>."""
+  help_text = subprocess.Popen([llc, '-help-hidden'], stdout=subprocess.PIPE,
+                               universal_newlines=True).communicate()[0]
+  strategies = []
+  in_misched = False
+  for line in help_text.splitlines():
+    line = line.strip()
+    if line.startswith('-misched '):
+      in_misched = True
+      continue
+    if not in_misched:
+      continue
+    if not line.startswith('='):
+      break
+    name = line[1:].split()[0]
+    if name != 'default':
+      strategies.append(name)
+  return strategies
+
+def run_llc(llc, path, strategy):
+  """Compile one corpus file and return its parsed region records."""
+  args = [llc] + LLC_ARGS + ['-misched=' + strategy, '-o', os.devnull, path]
+  proc = subprocess.Popen(args, stderr=subprocess.PIPE,
+                          universal_newlines=True)
+  err = proc.communicate()[1]
+  if proc.returncode != 0:
+    sys.stderr.write(err)
+    raise SystemExit('error: %s failed on %s' % (' '.join(args), path))
+  records = []
+  for line in err.splitlines():
+    if not line.startswith('misched,'):
+      continue
+    values = line.split(',')[1:]
+    if len(values) != len(REPORT_FIELDS):
+      raise SystemExit('error: malformed record: %s' % line)
+    records.append(dict(zip(REPORT_FIELDS, values)))
+  return records
+
+def summarize(strategy, records):
+  """Add up the records of one strategy. Pressure is summed over regions."""
+  row = dict((field, 0) for field in SUMMARY_FIELDS)
+  row['scheduler'] = strategy
+  row['regions'] = len(records)
+  for record in records:
+    for field in SUMMARY_FIELDS[2:]:
+      if record[field]:
+        row[field] += int(record[field])
+  return row
+
+def read_csv(path):
+  """Return the region records of a per-region CSV, grouped by strategy."""
+  strategies = []
+  records = {}
+  with open(path) as f:
+    for record in csv.DictReader(f):
+      strategy = record['scheduler']
+      if strategy not in records:
+        strategies.append(strategy)
+        records[strategy] = []
+      records[strategy].append(record)
+  return strategies, records
+
+def main():
+  parser = argparse.ArgumentParser(description=__doc__)
+  parser.add_argument('--llc', help='path to llc')
+  parser.add_argument('--srcroot',
+                      default=os.path.join(os.path.dirname(__file__),
+                                           os.pardir, os.pardir),
+                      help='root of the LLVM source tree')
+  parser.add_argument('--strategy', action='append', default=[],
+                      help='benchmark only this strategy (may be repeated)')
+  parser.add_argument('--summary', action='store_true',
+                      help='print one row per strategy instead of per region')
+  parser.add_argument('--from-csv', metavar='FILE',
+                      help='summarize the per-region CSV FILE instead of '
+                           'running llc; implies --summary')
+  parser.add_argument('--output', help='write CSV here instead of stdout')
+  args = parser.parse_args()
+
+  if args.from_csv:
+    strategies, records = read_csv(args.from_csv)
+    if args.strategy:
+      strategies = [s for s in strategies if s in args.strategy]
+    out = open(args.output, 'w') if args.output else sys.stdout
+    writer = csv.writer(out, lineterminator='\n')
+    writer.writerow(SUMMARY_FIELDS)
+    for strategy in strategies:
+      row = summarize(strategy, records[strategy])
+      writer.writerow([row[f] for f in SUMMARY_FIELDS])
+    if args.output:
+      out.close()
+    return
+
+  if not args.llc:
+    parser.error('--llc is required unless --from-csv is given')
+  strategies = args.strategy or find_strategies(args.llc)
+  if not strategies:
+    raise SystemExit('error: no machine schedulers registered in %s' %
+                     args.llc)
+
+  out = open(args.output, 'w') if args.output else sys.stdout
+  writer = csv.writer(out, lineterminator='\n')
+  if args.summary:
+    writer.writerow(SUMMARY_FIELDS)
+  else:
+    writer.writerow(['file'] + REPORT_FIELDS)
+
+  for strategy in strategies:
+    all_records = []
+    for path in CORPUS:
+      records = run_llc(args.llc, os.path.join(args.srcroot, path), strategy)
+      if not args.summary:
+        for record in records:
+          writer.writerow([path] + [record[f] for f in REPORT_FIELDS])
+      all_records.extend(records)
+    if args.summary:
+      row = summarize(strategy, all_records)
+      writer.writerow([row[f] for f in SUMMARY_FIELDS])
+
+  if args.output:
+    out.close()
+
+if __name__ == '__main__':
+  main()